@@ -10,28 +10,183 @@ extern "C" {
 #include <zephyr/kernel.h>
 #include <pub_sub/subscriber.h>
 #include <pub_sub/msg_alloc.h>
+#ifdef CONFIG_PUB_SUB_MSG_RING
+#include <pub_sub/msg_ring.h>
+#endif // CONFIG_PUB_SUB_MSG_RING
+
+// An immutable priority ordered array of subscribers. Subscriber arrays are read without locking
+// so when one is replaced the old array is retired until all of the readers that could be using it
+// have finished.
+struct pub_sub_sub_array {
+	sys_snode_t retire_node;
+	uint16_t num_subs;
+	struct pub_sub_subscriber *subs[];
+};
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+// Brokers always dispatch messages from a higher priority lane before a lower priority one
+enum pub_sub_publish_lane {
+	PUB_SUB_PUBLISH_LANE_URGENT,
+	PUB_SUB_PUBLISH_LANE_NORMAL,
+	PUB_SUB_PUBLISH_LANE_BULK,
+	PUB_SUB_PUBLISH_NUM_LANES,
+};
+
+#define PUB_SUB_BROKER_NUM_PUBLISH_QUEUES PUB_SUB_PUBLISH_NUM_LANES
+#else
+#define PUB_SUB_BROKER_NUM_PUBLISH_QUEUES 1
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+// An additional dispatch thread of a broker and the queue of the messages published to it
+struct pub_sub_broker_shard {
+	struct k_fifo msg_publish_fifo;
+	struct k_thread thread;
+	K_KERNEL_STACK_MEMBER(thread_stack, CONFIG_PUB_SUB_BROKER_THREAD_STACK_SIZE);
+};
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
 
 struct pub_sub_broker {
 	struct k_fifo msg_publish_fifo;
+#ifdef CONFIG_PUB_SUB_MSG_RING
+	// When set published messages are queued on the ring instead of the fifo
+	struct pub_sub_msg_ring *msg_publish_ring;
+#endif // CONFIG_PUB_SUB_MSG_RING
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	// The normal lane is the publish fifo or ring
+	struct k_fifo msg_urgent_fifo;
+	struct k_fifo msg_bulk_fifo;
+	atomic_t lane_depth[PUB_SUB_PUBLISH_NUM_LANES];
+	atomic_t lane_peak_depth[PUB_SUB_PUBLISH_NUM_LANES];
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+#if !defined(CONFIG_PUB_SUB_BROKER_THREAD) || defined(CONFIG_PUB_SUB_PUBLISH_LANES)
+	// Signals when any of the publish queues have messages available. A broker thread without
+	// lanes blocks directly on its only publish queue instead.
+	struct k_poll_event publish_poll_events[PUB_SUB_BROKER_NUM_PUBLISH_QUEUES];
+#endif
+	// Only needs to be locked to modify the subscribers, reading uses the subscriber arrays
 	struct k_mutex sub_list_mutex;
 	sys_slist_t subscribers;
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+	struct k_thread thread;
+#else
 	struct k_work_poll publish_work;
-	struct k_poll_event publish_work_poll_event;
+	struct k_work_q *work_q;
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+	// All of the broker's subscribers
+	atomic_ptr_t sub_array;
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+	// The subscribers subscribed to each message id
+	atomic_ptr_t routes[CONFIG_PUB_SUB_ROUTING_INDEX_MAX_MSG_ID + 1];
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_TOPICS
+	// The subscribers that could be subscribed to message ids in each level 1 namespace
+	atomic_ptr_t topic_routes[PUB_SUB_TOPIC_NUM_PREFIXES(1)];
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	// Bit n is set while any of the broker's subscribers are subscribed to message id n
+	ATOMIC_DEFINE(subs_summary, CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY_MAX_MSG_ID + 1);
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	// Readers register with the reader count selected by the read epoch. Incrementing the epoch
+	// starts a grace period which finishes when the previous reader count reaches 0.
+	atomic_t read_epoch;
+	atomic_t readers[2];
+	// The last reader using a reader count gives its semaphore if any threads are waiting for it
+	// to reach 0
+	atomic_t num_waiters[2];
+	struct k_sem readers_done[2];
+	sys_slist_t retired;
+	sys_slist_t reclaiming;
+	uint8_t reclaiming_key;
+	// Set while there are retired arrays, so that the broker frees them once it has finished
+	// routing instead of waiting for the next change to its subscribers
+	atomic_t reclaim_pending;
+	// The number of threads waiting for the readers with the sub_list_mutex released
+	uint8_t num_synchronizing;
+	// The threads currently routing messages, so that the broker can detect being modified from
+	// within its own read side critical section
+	sys_slist_t routing_threads;
+	struct k_spinlock routing_threads_lock;
+#ifdef CONFIG_PUB_SUB_STATS
+	sys_snode_t stats_node;
+	struct k_spinlock stats_lock;
+	struct pub_sub_broker_stats stats;
+#endif // CONFIG_PUB_SUB_STATS
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+	K_KERNEL_STACK_MEMBER(thread_stack, CONFIG_PUB_SUB_BROKER_THREAD_STACK_SIZE);
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	// Shard 0 is the broker's own publish fifo and thread
+	struct pub_sub_broker_shard shards[CONFIG_PUB_SUB_BROKER_NUM_SHARDS - 1];
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
 };
 
+#ifdef CONFIG_PUB_SUB_MSG_RING
+/**
+ * @brief Set the message ring a broker queues its published messages on
+ *
+ * By default a broker queues published messages on a fifo which links the messages through their
+ * headers. Queuing on a message ring instead makes publishing lock free and ISR safe, and a message
+ * that owns multiple references can be published to multiple brokers that use message rings. If
+ * the ring is full the published message is dropped, see pub_sub_msg_ring_dropped.
+ *
+ * @warning
+ * Must be called before the broker is initialized and the ring must only be used by one broker.
+ *
+ * @param broker Address of the broker
+ * @param ring Address of the initialized message ring, NULL to use the fifo
+ */
+void pub_sub_broker_set_msg_ring(struct pub_sub_broker *broker, struct pub_sub_msg_ring *ring);
+#endif // CONFIG_PUB_SUB_MSG_RING
+
 /**
  * @brief Initialize a broker
  *
- * A broker must be initialized before it can be used
+ * A broker must be initialized before it can be used. With CONFIG_PUB_SUB_BROKER_THREAD the broker
+ * starts its own thread using the CONFIG_PUB_SUB_BROKER_THREAD_* priority and CPU mask, otherwise
+ * it processes published messages on the system work queue.
  *
  * @param broker Address of the broker to initialize
  */
 void pub_sub_init_broker(struct pub_sub_broker *broker);
 
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+/**
+ * @brief Initialize a broker that processes published messages on its own thread
+ *
+ * A broker must be initialized before it can be used. The broker's thread blocks on its publish
+ * queue and routes each message as it is published. Callback subscriber handler functions are
+ * called from the broker's thread.
+ *
+ * With CONFIG_PUB_SUB_BROKER_SHARDING a thread is started for each of the broker's shards. Each
+ * thread is pinned to one of the CPUs in 'cpu_mask', or of all of the CPUs if it is 0, in turn.
+ *
+ * @param broker Address of the broker to initialize
+ * @param priority The priority of the broker's thread
+ * @param cpu_mask The CPUs the broker's thread may run on, bit n set allows CPU n. Only used with
+ * CONFIG_SCHED_CPU_MASK, 0 leaves the thread's CPU mask unchanged.
+ */
+void pub_sub_init_broker_thread(struct pub_sub_broker *broker, int priority, uint32_t cpu_mask);
+#else
+/**
+ * @brief Initialize a broker that processes published messages on a work queue
+ *
+ * A broker must be initialized before it can be used. The broker processes published messages
+ * from a work item submitted to 'work_q' so callback subscriber handler functions are called from
+ * the work queue's thread.
+ *
+ * @param broker Address of the broker to initialize
+ * @param work_q Address of the work queue to process published messages on
+ */
+void pub_sub_init_broker_on_work_q(struct pub_sub_broker *broker, struct k_work_q *work_q);
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+
 /**
  * @brief Add a subscriber to a  broker
  *
- * A subscriber must be added to a broker to receive any published messages.
+ * A subscriber must be added to a broker to receive any published messages. The broker's list of
+ * subscribers is allocated from a heap shared by all brokers which is sized with
+ * CONFIG_PUB_SUB_BROKER_HEAP_SIZE.
  *
  * @warning
  * A subscriber must have its message handler function set before it is added to a broker.
@@ -41,22 +196,213 @@ void pub_sub_init_broker(struct pub_sub_broker *broker);
  *
  * @param broker Address of the broker to add the subscriber to
  * @param subscriber Address of the subscriber to add to the broker
+ *
+ * If the heap is full the broker waits for any messages that are being routed to finish, so that
+ * the subscriber lists they could be using can be freed, and tries again. It doesn't wait when
+ * called from within a callback subscriber's handler function, or any other context that the
+ * broker routes messages from.
+ *
+ * @retval 0 Subscriber added successfully
+ * @retval -ENOMEM If there was no space on the heap for the broker's new list of subscribers
  */
-void pub_sub_add_subscriber_to_broker(struct pub_sub_broker *broker,
-				      struct pub_sub_subscriber *subscriber);
+int pub_sub_add_subscriber_to_broker(struct pub_sub_broker *broker,
+				     struct pub_sub_subscriber *subscriber);
 
 /**
  * @brief Remove a subscriber from its broker
  *
- * Removing a subscriber from a broker will stop it receiving any published messages.
+ * Removing a subscriber from a broker will stop it receiving any published messages. The broker
+ * routes messages without locking its list of subscribers so this function waits for any messages
+ * that are being routed to finish before returning. Once it returns the subscriber is no longer
+ * referenced by the broker and can be freed or added to a broker again.
+ *
+ * When called from within a callback subscriber's handler function, or any other context that the
+ * broker routes messages from, it doesn't wait as it would be waiting for itself. The subscriber
+ * receives no more messages, but it must not be freed until the broker's other routing contexts,
+ * such as the threads of publishers using direct publish, have finished routing their messages.
+ * The broker's old subscriber lists are freed once it has finished routing.
  *
  * @param subscriber Address of the subscriber to remove the broker from
+ *
+ * @retval 0 Subscriber removed successfully
+ * @retval -ENOMEM If there was no space on the heap for the broker's new list of subscribers, the
+ * subscriber is left on the broker
+ */
+int pub_sub_subscriber_remove_broker(struct pub_sub_subscriber *subscriber);
+
+/**
+ * @brief Internal implementation, only exposed for fifo subscribers
+ *
+ * Enters a read side critical section, the broker's subscriber arrays can be read until the
+ * section is exited with pub_sub_broker_read_unlock.
+ *
+ * @retval The key to pass to pub_sub_broker_read_unlock
+ */
+static inline void pub_sub_broker_read_unlock(struct pub_sub_broker *broker, uint8_t read_key);
+
+static inline uint8_t pub_sub_broker_read_lock(struct pub_sub_broker *broker)
+{
+	for (;;) {
+		atomic_val_t epoch = atomic_get(&broker->read_epoch);
+		uint8_t read_key = epoch & 1;
+		atomic_inc(&broker->readers[read_key]);
+		// If a grace period started before the reader count was incremented the writer may
+		// not have seen it so try again with the new epoch
+		if (atomic_get(&broker->read_epoch) == epoch) {
+			return read_key;
+		}
+		pub_sub_broker_read_unlock(broker, read_key);
+	}
+}
+
+/**
+ * @brief Internal implementation, only exposed for fifo subscribers
+ *
+ * Exits a read side critical section entered with pub_sub_broker_read_lock.
+ */
+static inline void pub_sub_broker_read_unlock(struct pub_sub_broker *broker, uint8_t read_key)
+{
+	if ((atomic_dec(&broker->readers[read_key]) == 1) &&
+	    (atomic_get(&broker->num_waiters[read_key]) > 0)) {
+		k_sem_give(&broker->readers_done[read_key]);
+	}
+}
+
+#ifndef CONFIG_PUB_SUB_FIFO_FANOUT
+/**
+ * @brief Internal implementation, only exposed for fifo subscribers
+ *
+ * Finds the next fifo subscriber after 'subscriber' that is subscribed to 'msg_id' and, with
+ * CONFIG_PUB_SUB_SUBSCRIBER_FILTERS, accepts 'msg'. Must be called from within a read side critical
+ * section.
+ */
+struct pub_sub_subscriber *pub_sub_broker_next_fifo_subscriber(struct pub_sub_broker *broker,
+							       struct pub_sub_subscriber *subscriber,
+							       uint16_t msg_id, const void *msg);
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+/**
+ * @brief Publish a message to one of a broker's publish lanes
+ *
+ * The broker dispatches all of the messages queued on a higher priority lane before any from a
+ * lower priority lane, messages within a lane are dispatched in the order they were published. A
+ * batch of messages that the broker has already dequeued is finished before a newly published
+ * higher priority message is dispatched, see CONFIG_PUB_SUB_BROKER_DISPATCH_BATCH_SIZE.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by 'msg' should not be accessed again. A message can only be
+ * published to a single broker even if multiple references are owned.
+ *
+ * @param broker Address of the broker to publish to
+ * @param msg Address of the message to publish
+ * @param lane The lane to publish the message on
+ */
+void pub_sub_publish_to_broker_prio(struct pub_sub_broker *broker, void *msg,
+				    enum pub_sub_publish_lane lane);
+
+/**
+ * @brief Get the number of messages queued on one of a broker's publish lanes
+ *
+ * @param broker Address of the broker
+ * @param lane The publish lane
+ *
+ * @retval The number of messages published to the lane that the broker has not dequeued yet
+ */
+static inline size_t pub_sub_broker_lane_depth(struct pub_sub_broker *broker,
+					       enum pub_sub_publish_lane lane)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(lane < PUB_SUB_PUBLISH_NUM_LANES, "");
+	return atomic_get(&broker->lane_depth[lane]);
+}
+
+/**
+ * @brief Get the largest number of messages that have been queued on one of a broker's publish
+ * lanes
+ *
+ * @param broker Address of the broker
+ * @param lane The publish lane
+ *
+ * @retval The peak depth of the lane since the broker was initialized
+ */
+static inline size_t pub_sub_broker_lane_peak_depth(struct pub_sub_broker *broker,
+						    enum pub_sub_publish_lane lane)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(lane < PUB_SUB_PUBLISH_NUM_LANES, "");
+	return atomic_get(&broker->lane_peak_depth[lane]);
+}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
+/**
+ * @brief Internal implementation, only exposed for broker shards and subscriber groups
+ *
+ * Maps a key onto an index less than 'n'. The key is mixed with a multiplicative hash so that keys
+ * that only differ in a few bits, such as consecutive keys, are spread out, then the upper bits of
+ * the hash select the index.
+ */
+static inline uint32_t pub_sub_hash_index(uint32_t key, uint32_t n)
+{
+	uint32_t hash = key * 2654435761U;
+	return ((uint64_t)hash * n) >> 32;
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+/**
+ * @brief Internal implementation, only exposed for publishing
+ *
+ * Returns the index of the shard that dispatches the messages published with 'key'.
  */
-void pub_sub_subscriber_remove_broker(struct pub_sub_subscriber *subscriber);
+static inline uint8_t pub_sub_broker_shard_index(uint32_t key)
+{
+	return pub_sub_hash_index(key, CONFIG_PUB_SUB_BROKER_NUM_SHARDS);
+}
+
+/**
+ * @brief Internal implementation, only exposed for publishing
+ *
+ * Returns the publish fifo of one of a broker's shards.
+ */
+static inline struct k_fifo *pub_sub_broker_shard_fifo(struct pub_sub_broker *broker,
+						       uint8_t shard)
+{
+	return shard == 0 ? &broker->msg_publish_fifo : &broker->shards[shard - 1].msg_publish_fifo;
+}
+
+/**
+ * @brief Publish a message to a broker with a key that selects the shard that dispatches it
+ *
+ * Messages published with the same key are dispatched by the same shard, in the order they were
+ * published, while messages with different keys can be dispatched in parallel.
+ * pub_sub_publish_to_broker uses the message id as the key so a message published with an explicit
+ * key is not ordered with respect to messages of the same id published without one.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by 'msg' should not be accessed again. A message can only be
+ * published to a single broker even if multiple references are owned.
+ *
+ * @param broker Address of the broker to publish to
+ * @param msg Address of the message to publish
+ * @param key The key that selects the shard
+ */
+static inline void pub_sub_publish_keyed_to_broker(struct pub_sub_broker *broker, void *msg,
+						   uint32_t key)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(msg != NULL, "");
+	pub_sub_msg_fifo_put(pub_sub_broker_shard_fifo(broker, pub_sub_broker_shard_index(key)),
+			     msg);
+}
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
 
 /**
  * @brief Publish a message to a broker
  *
+ * With CONFIG_PUB_SUB_PUBLISH_LANES the message is published on the normal lane. With
+ * CONFIG_PUB_SUB_BROKER_SHARDING the message's id is used as its key, see
+ * pub_sub_publish_keyed_to_broker.
+ *
  * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
  * is called the memory pointed to by 'msg' should not be accessed again. A message can only be
  * published to a single broker even if multiple references are owned.
@@ -68,9 +414,126 @@ static inline void pub_sub_publish_to_broker(struct pub_sub_broker *broker, void
 {
 	__ASSERT(broker != NULL, "");
 	__ASSERT(msg != NULL, "");
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	pub_sub_publish_to_broker_prio(broker, msg, PUB_SUB_PUBLISH_LANE_NORMAL);
+#else
+#ifdef CONFIG_PUB_SUB_MSG_RING
+	if (broker->msg_publish_ring != NULL) {
+		(void)pub_sub_msg_ring_put(broker->msg_publish_ring, msg);
+		return;
+	}
+#endif // CONFIG_PUB_SUB_MSG_RING
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	pub_sub_publish_keyed_to_broker(broker, msg, pub_sub_msg_get_msg_id(msg));
+#else
 	pub_sub_msg_fifo_put(&broker->msg_publish_fifo, msg);
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
 }
 
+/**
+ * @brief Check if any of a broker's subscribers are subscribed to a message id
+ *
+ * Can be called from an ISR. Allows a publisher to skip allocating and filling in a message that
+ * nobody would receive. With CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY this only tests a bit, otherwise
+ * the subscriptions of the broker's subscribers are checked.
+ *
+ * @param broker Address of the broker
+ * @param msg_id The message id to check
+ *
+ * @retval true At least one subscriber is subscribed to the message id
+ * @retval false No subscribers are subscribed to the message id
+ */
+bool pub_sub_broker_has_subscribers(struct pub_sub_broker *broker, uint16_t msg_id);
+
+/**
+ * @brief Publish a message to a broker if any of its subscribers are subscribed to it
+ *
+ * The subscriptions are checked before the message is queued so a message that nobody is
+ * subscribed to is released straight away instead of being queued and dispatched by the broker. A
+ * subscription made after the check does not receive the message.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by 'msg' should not be accessed again, even if it was dropped.
+ *
+ * @param broker Address of the broker to publish to
+ * @param msg Address of the message to publish
+ *
+ * @retval 0 The message was published
+ * @retval -ENOENT No subscribers are subscribed to the message so it was released
+ */
+static inline int pub_sub_publish_if_subscribed_to_broker(struct pub_sub_broker *broker, void *msg)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(msg != NULL, "");
+	if (!pub_sub_broker_has_subscribers(broker, pub_sub_msg_get_msg_id(msg))) {
+		pub_sub_release_msg(msg);
+		return -ENOENT;
+	}
+	pub_sub_publish_to_broker(broker, msg);
+	return 0;
+}
+
+/**
+ * @brief Publish an array of messages to a broker
+ *
+ * The messages are linked together through their headers and queued on the broker with a single
+ * operation so the broker is only woken once for the whole batch. The messages are received by
+ * subscribers in array order, the same as if they had been published individually. With
+ * CONFIG_PUB_SUB_PUBLISH_LANES the messages are published on the normal lane.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by the messages should not be accessed again. A message can only
+ * be published to a single broker even if multiple references are owned.
+ *
+ * @param broker Address of the broker to publish to
+ * @param msgs Array of the addresses of the messages to publish
+ * @param num_msgs The number of messages in the array
+ */
+void pub_sub_publish_batch_to_broker(struct pub_sub_broker *broker, void *const *msgs,
+				     size_t num_msgs);
+
+/**
+ * @brief Publish a list of messages to a broker
+ *
+ * The list is built with pub_sub_msg_list_append and is queued on the broker with a single
+ * operation so the broker is only woken once for the whole list. The messages are received by
+ * subscribers in list order, the same as if they had been published individually. The list is
+ * empty after the call. With CONFIG_PUB_SUB_PUBLISH_LANES the messages are published on the normal
+ * lane.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by the messages should not be accessed again. A message can only
+ * be published to a single broker even if multiple references are owned.
+ *
+ * @param broker Address of the broker to publish to
+ * @param list Address of the list of messages to publish
+ */
+void pub_sub_publish_list_to_broker(struct pub_sub_broker *broker, sys_slist_t *list);
+
+/**
+ * @brief Publish a message to a broker from the calling context
+ *
+ * The message is routed to the broker's subscribers immediately by the calling thread instead of
+ * being queued for the broker to process. Callback subscriber handler functions are called from
+ * the calling thread and the message is queued directly on message queue and fifo subscribers. The
+ * subscribers receive the message in the same priority order and with the same reference counting
+ * as a message processed by the broker.
+ *
+ * Publishing a message passes ownership of the message's reference to the broker i.e. after publish
+ * is called the memory pointed to by 'msg' should not be accessed again.
+ *
+ * @warning
+ * The message is not ordered with respect to messages that are still queued on the broker, it can
+ * be received before messages that were published to the broker before it.
+ * @warning
+ * Must not be called from an ISR as routing to a message queue subscriber can block.
+ *
+ * @param broker Address of the broker to publish to
+ * @param msg Address of the message to publish
+ */
+void pub_sub_publish_direct_to_broker(struct pub_sub_broker *broker, void *msg);
+
 #ifdef CONFIG_PUB_SUB_DEFAULT_BROKER
 
 extern struct pub_sub_broker g_pub_sub_default_broker;
@@ -87,10 +550,13 @@ extern struct pub_sub_broker g_pub_sub_default_broker;
  * broker it must first be removed from its current broker before being added to the new one.
  *
  * @param subscriber Address of the subscriber to add
+ *
+ * @retval 0 Subscriber added successfully
+ * @retval -ENOMEM If there was no space on the heap for the broker's new list of subscribers
  */
-static inline void pub_sub_add_subscriber(struct pub_sub_subscriber *subscriber)
+static inline int pub_sub_add_subscriber(struct pub_sub_subscriber *subscriber)
 {
-	pub_sub_add_subscriber_to_broker(&g_pub_sub_default_broker, subscriber);
+	return pub_sub_add_subscriber_to_broker(&g_pub_sub_default_broker, subscriber);
 }
 
 /**
@@ -107,6 +573,104 @@ static inline void pub_sub_publish(void *msg)
 	pub_sub_publish_to_broker(&g_pub_sub_default_broker, msg);
 }
 
+/**
+ * @brief Publish an array of messages to the default broker
+ *
+ * See pub_sub_publish_batch_to_broker
+ *
+ * @param msgs Array of the addresses of the messages to publish
+ * @param num_msgs The number of messages in the array
+ */
+static inline void pub_sub_publish_batch(void *const *msgs, size_t num_msgs)
+{
+	pub_sub_publish_batch_to_broker(&g_pub_sub_default_broker, msgs, num_msgs);
+}
+
+/**
+ * @brief Check if any of the default broker's subscribers are subscribed to a message id
+ *
+ * See pub_sub_broker_has_subscribers
+ *
+ * @param msg_id The message id to check
+ *
+ * @retval true At least one subscriber is subscribed to the message id
+ * @retval false No subscribers are subscribed to the message id
+ */
+static inline bool pub_sub_has_subscribers(uint16_t msg_id)
+{
+	return pub_sub_broker_has_subscribers(&g_pub_sub_default_broker, msg_id);
+}
+
+/**
+ * @brief Publish a message to the default broker if any of its subscribers are subscribed to it
+ *
+ * See pub_sub_publish_if_subscribed_to_broker
+ *
+ * @param msg Address of the message to publish
+ *
+ * @retval 0 The message was published
+ * @retval -ENOENT No subscribers are subscribed to the message so it was released
+ */
+static inline int pub_sub_publish_if_subscribed(void *msg)
+{
+	return pub_sub_publish_if_subscribed_to_broker(&g_pub_sub_default_broker, msg);
+}
+
+/**
+ * @brief Publish a list of messages to the default broker
+ *
+ * See pub_sub_publish_list_to_broker
+ *
+ * @param list Address of the list of messages to publish
+ */
+static inline void pub_sub_publish_list(sys_slist_t *list)
+{
+	pub_sub_publish_list_to_broker(&g_pub_sub_default_broker, list);
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+/**
+ * @brief Publish a message to the default broker with a key that selects the shard that
+ * dispatches it
+ *
+ * See pub_sub_publish_keyed_to_broker
+ *
+ * @param msg Address of the message to publish
+ * @param key The key that selects the shard
+ */
+static inline void pub_sub_publish_keyed(void *msg, uint32_t key)
+{
+	pub_sub_publish_keyed_to_broker(&g_pub_sub_default_broker, msg, key);
+}
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+/**
+ * @brief Publish a message to one of the default broker's publish lanes
+ *
+ * See pub_sub_publish_to_broker_prio
+ *
+ * @param msg Address of the message to publish
+ * @param lane The lane to publish the message on
+ */
+static inline void pub_sub_publish_prio(void *msg, enum pub_sub_publish_lane lane)
+{
+	pub_sub_publish_to_broker_prio(&g_pub_sub_default_broker, msg, lane);
+}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
+/**
+ * @brief Publish a message to the default broker from the calling context
+ *
+ * See pub_sub_publish_direct_to_broker
+ *
+ * @param msg Address of the message to publish
+ */
+static inline void pub_sub_publish_direct(void *msg)
+{
+	pub_sub_publish_direct_to_broker(&g_pub_sub_default_broker, msg);
+}
+
 #endif // CONFIG_PUB_SUB_DEFAULT_BROKER
 
 #ifdef __cplusplus
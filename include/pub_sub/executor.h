@@ -0,0 +1,101 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_EXECUTOR_H_
+#define PUB_SUB_EXECUTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <zephyr/kernel.h>
+#include <pub_sub/subscriber.h>
+
+// A pool of worker threads that handle the queued messages of msgq and fifo subscribers. A
+// subscriber is put on the ready list when a message is queued on it and is taken off by a single
+// worker at a time, so its handler function is never called from two workers at once.
+struct pub_sub_executor {
+	struct k_spinlock lock;
+	// Runnable subscribers in priority order
+	sys_slist_t ready;
+	// Given once for each subscriber put on the ready list
+	struct k_sem ready_sem;
+	k_thread_stack_t *stacks;
+	size_t stack_len;
+	size_t stack_size;
+	struct k_thread *threads;
+	uint8_t num_workers;
+};
+
+/**
+ * @brief Statically define an executor
+ *
+ * The executor must be initialized with pub_sub_init_executor before it is used.
+ *
+ * @param name Name of the executor
+ * @param num_threads The number of worker threads
+ * @param thread_stack_size The stack size of each worker thread, subscriber handler functions are
+ * called from the workers so it must be large enough for them
+ */
+#define PUB_SUB_EXECUTOR_DEFINE(name, num_threads, thread_stack_size)                              \
+	static K_KERNEL_STACK_ARRAY_DEFINE(_pub_sub_executor_stacks_##name, num_threads,           \
+					   thread_stack_size);                                     \
+	static struct k_thread _pub_sub_executor_threads_##name[num_threads];                      \
+	struct pub_sub_executor name = {                                                           \
+		.stacks = (k_thread_stack_t *)_pub_sub_executor_stacks_##name,                     \
+		.stack_len = K_KERNEL_STACK_LEN(thread_stack_size),                                \
+		.stack_size = K_KERNEL_STACK_SIZEOF(_pub_sub_executor_stacks_##name[0]),           \
+		.threads = _pub_sub_executor_threads_##name,                                       \
+		.num_workers = (num_threads),                                                      \
+	}
+
+/**
+ * @brief Initialize an executor and start its worker threads
+ *
+ * @param executor Address of the executor
+ * @param priority The priority of the worker threads
+ */
+void pub_sub_init_executor(struct pub_sub_executor *executor, int priority);
+
+/**
+ * @brief Have an executor handle a subscriber's queued messages
+ *
+ * Once added the executor's workers call pub_sub_handle_queued_msg for the subscriber whenever it
+ * has queued messages, up to CONFIG_PUB_SUB_EXECUTOR_BATCH_SIZE messages at a time before giving
+ * the other runnable subscribers a turn. Runnable subscribers are handled in order of their
+ * priority value, subscribers with the same priority value are handled in turn.
+ *
+ * @warning
+ * The subscriber's queued messages must not also be handled by any other thread.
+ *
+ * @param executor Address of the initialized executor
+ * @param subscriber Address of the msgq or fifo subscriber
+ */
+void pub_sub_executor_add_subscriber(struct pub_sub_executor *executor,
+				     struct pub_sub_subscriber *subscriber);
+
+/**
+ * @brief Stop an executor handling a subscriber's queued messages
+ *
+ * Waits for a worker that is running the subscriber's handler function to finish before returning.
+ * Messages still queued on the subscriber are left queued.
+ *
+ * @warning
+ * Must not be called from the subscriber's own handler function as it would wait for itself to
+ * finish.
+ *
+ * @param subscriber Address of the subscriber
+ */
+void pub_sub_executor_remove_subscriber(struct pub_sub_subscriber *subscriber);
+
+/**
+ * @brief Internal implementation, only exposed for subscribers
+ *
+ * Makes a subscriber runnable after a message has been queued on it. Can be called from an ISR.
+ */
+void pub_sub_executor_notify(struct pub_sub_subscriber *subscriber);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_EXECUTOR_H_ */
\ No newline at end of file
@@ -0,0 +1,134 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_LAZY_MSG_H_
+#define PUB_SUB_LAZY_MSG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pub_sub/broker.h>
+#include <pub_sub/msg_alloc.h>
+
+/**
+ * @brief Fills in a message produced from a lazy message
+ *
+ * @param msg_id The message id of the produced message
+ * @param msg Address of the newly allocated message to fill in
+ * @param user_data The user data the lazy message was initialized with
+ */
+typedef void (*pub_sub_lazy_msg_produce_fn)(uint16_t msg_id, void *msg, void *user_data);
+
+// A lazy message is published in place of a real message, the broker only allocates and produces
+// the real message if a subscriber is subscribed to it when the lazy message is dispatched
+struct pub_sub_lazy_msg {
+	struct pub_sub_allocator *allocator;
+	pub_sub_lazy_msg_produce_fn produce;
+	void *user_data;
+	size_t msg_size_bytes;
+	atomic_t dropped;
+	// Must be last, the header is what gets published
+	struct pub_sub_msg pub_sub_msg;
+};
+
+/**
+ * @brief Statically define and initialize a lazy message
+ *
+ * @param name The name of the created lazy message
+ * @param _allocator Address of the allocator to allocate the produced messages from
+ * @param msg_id The message id of the produced messages
+ * @param _msg_size_bytes The size of the produced messages
+ * @param produce_fn The function called to fill in a produced message
+ * @param _user_data Passed to the produce function
+ */
+#define PUB_SUB_LAZY_MSG_DEFINE(name, _allocator, msg_id, _msg_size_bytes, produce_fn, _user_data) \
+	struct pub_sub_lazy_msg name = {                                                           \
+		.allocator = _allocator,                                                           \
+		.produce = produce_fn,                                                             \
+		.user_data = _user_data,                                                           \
+		.msg_size_bytes = _msg_size_bytes,                                                 \
+		.dropped = ATOMIC_INIT(0),                                                         \
+		.pub_sub_msg.atomic_data =                                                         \
+			PUB_SUB_MSG_ATOMIC_DATA_INIT(msg_id, PUB_SUB_ALLOC_ID_LAZY_MSG),           \
+	}
+
+/**
+ * @brief Initialize a lazy message
+ *
+ * @param lazy_msg Address of the lazy message
+ * @param allocator Address of the allocator to allocate the produced messages from
+ * @param msg_id The message id of the produced messages
+ * @param msg_size_bytes The size of the produced messages
+ * @param produce The function called to fill in a produced message
+ * @param user_data Passed to the produce function
+ */
+void pub_sub_lazy_msg_init(struct pub_sub_lazy_msg *lazy_msg, struct pub_sub_allocator *allocator,
+			   uint16_t msg_id, size_t msg_size_bytes,
+			   pub_sub_lazy_msg_produce_fn produce, void *user_data);
+
+/**
+ * @brief Publish a lazy message to a broker
+ *
+ * When the broker dispatches the lazy message it checks whether any of its subscribers are
+ * subscribed to the message id. Only if there are does it allocate a message from the lazy
+ * message's allocator, without waiting, and call the produce function to fill it in. The produced
+ * message is then routed as if it had been published. The produce function is called from the
+ * broker's context, or the publishing thread for pub_sub_publish_direct_to_broker.
+ *
+ * A lazy message can only be queued on a broker once at a time, it can be published again once
+ * the broker has dispatched it. Can be called from an ISR.
+ *
+ * @param broker Address of the broker to publish to
+ * @param lazy_msg Address of the lazy message to publish
+ *
+ * @retval 0 The lazy message was published
+ * @retval -EBUSY The lazy message is still queued from a previous publish
+ */
+int pub_sub_publish_lazy_to_broker(struct pub_sub_broker *broker,
+				   struct pub_sub_lazy_msg *lazy_msg);
+
+/**
+ * @brief Get the number of produced messages dropped because they could not be allocated
+ *
+ * @param lazy_msg Address of the lazy message
+ *
+ * @retval The number of dropped messages
+ */
+static inline atomic_val_t pub_sub_lazy_msg_dropped(struct pub_sub_lazy_msg *lazy_msg)
+{
+	__ASSERT(lazy_msg != NULL, "");
+	return atomic_get(&lazy_msg->dropped);
+}
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Allocates and produces the message for a dispatched lazy message.
+ *
+ * @retval Address of the produced message, NULL if it could not be allocated
+ */
+void *pub_sub_lazy_msg_produce(void *msg);
+
+#ifdef CONFIG_PUB_SUB_DEFAULT_BROKER
+/**
+ * @brief Publish a lazy message to the default broker
+ *
+ * See pub_sub_publish_lazy_to_broker
+ *
+ * @param lazy_msg Address of the lazy message to publish
+ *
+ * @retval 0 The lazy message was published
+ * @retval -EBUSY The lazy message is still queued from a previous publish
+ */
+static inline int pub_sub_publish_lazy(struct pub_sub_lazy_msg *lazy_msg)
+{
+	return pub_sub_publish_lazy_to_broker(&g_pub_sub_default_broker, lazy_msg);
+}
+#endif // CONFIG_PUB_SUB_DEFAULT_BROKER
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_LAZY_MSG_H_ */
\ No newline at end of file
@@ -183,6 +183,45 @@ static inline void *pub_sub_msg_fifo_get(struct k_fifo *fifo, k_timeout_t timeou
 	return ps_msg != NULL ? ps_msg->msg : NULL;
 }
 
+/**
+ * @brief Append a publish subscribe message to a list
+ *
+ * The list is linked through the message's fifo reserved header so a list of messages can be put
+ * into a fifo with a single operation e.g. k_fifo_put_slist.
+ *
+ * @warning
+ * Must only be called with messages that conform to the publish subscribe message memory layout
+ * i.e. the message is preceded by the pub_sub_msg struct.
+ *
+ * @warning
+ * A message can not be in a list and a fifo, or in more than one list, at the same time.
+ *
+ * @param list Address of the list
+ * @param msg Address of the message
+ */
+static inline void pub_sub_msg_list_append(sys_slist_t *list, const void *msg)
+{
+	__ASSERT(msg != NULL, "");
+	__ASSERT(list != NULL, "");
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+	sys_slist_append(list, (sys_snode_t *)&ps_msg->fifo_reserved);
+}
+
+/**
+ * @brief Remove the first publish subscribe message from a list
+ *
+ * @param list Address of the list
+ *
+ * @retval Address of the message, NULL if the list was empty
+ */
+static inline void *pub_sub_msg_list_get(sys_slist_t *list)
+{
+	__ASSERT(list != NULL, "");
+	sys_snode_t *node = sys_slist_get(list);
+	return node != NULL ? CONTAINER_OF((void **)node, struct pub_sub_msg, fifo_reserved)->msg
+			    : NULL;
+}
+
 #ifdef __cplusplus
 }
 #endif
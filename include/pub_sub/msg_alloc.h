@@ -17,6 +17,7 @@ extern "C" {
 #define PUB_SUB_ALLOC_ID_STATIC_MSG          0xFE
 #define PUB_SUB_ALLOC_ID_CALLBACK_MSG        0xFD
 #define PUB_SUB_ALLOC_ID_LINK_SECTION        0xFC
+#define PUB_SUB_ALLOC_ID_LAZY_MSG            0xFB
 #define PUB_SUB_ALLOC_ID_LINK_SECTION_MAX_ID 0x7F
 
 #ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
@@ -26,18 +27,43 @@ extern "C" {
 typedef void *(*pub_sub_alloc_fn)(void *impl, size_t msg_size_bytes, k_timeout_t timeout);
 typedef void (*pub_sub_free_fn)(void *impl, const void *msg);
 
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+struct pub_sub_allocator_counters {
+	atomic_t in_use;
+	atomic_t peak_in_use;
+	atomic_t allocations;
+	atomic_t failures;
+	struct k_spinlock lock;
+	uint64_t blocked_ns;
+	// Live messages per message id, the last entry counts all ids above the maximum
+	atomic_t live_msgs[CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID + 2];
+};
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
+
 struct pub_sub_allocator {
 	pub_sub_alloc_fn allocate;
 	pub_sub_free_fn free;
 	void *impl;
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+	// Set when the allocator is defined or, for a runtime allocator, when it is added
+	struct pub_sub_allocator_counters *counters;
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 	uint8_t allocator_id;
 };
 
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+// Linker section allocators are in ROM so their counters are a static compound literal in RAM
+#define _PUB_SUB_ALLOCATOR_COUNTERS_INIT .counters = &(struct pub_sub_allocator_counters){0},
+#else
+#define _PUB_SUB_ALLOCATOR_COUNTERS_INIT
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
+
 #define PUB_SUB_ALLOCATOR_DEFINE(name, allocate_fn, free_fn, _impl)                                \
 	STRUCT_SECTION_ITERABLE(pub_sub_allocator, name) = {                                       \
 		.allocate = allocate_fn,                                                           \
 		.free = free_fn,                                                                   \
 		.impl = _impl,                                                                     \
+		_PUB_SUB_ALLOCATOR_COUNTERS_INIT                                                   \
 		.allocator_id = PUB_SUB_ALLOC_ID_LINK_SECTION,                                     \
 	}
 
@@ -56,6 +82,47 @@ struct pub_sub_allocator {
  */
 int pub_sub_add_runtime_allocator(struct pub_sub_allocator *allocator);
 
+/**
+ * @brief Get the allocator id of an allocator
+ *
+ * @param allocator Address of the allocator
+ *
+ * @return The allocator id, PUB_SUB_ALLOC_ID_INVALID if it is a runtime allocator that has not been
+ * added
+ */
+static inline uint8_t pub_sub_allocator_get_id(const struct pub_sub_allocator *allocator)
+{
+	__ASSERT(allocator != NULL, "");
+	uint8_t allocator_id = allocator->allocator_id;
+	if (allocator_id == PUB_SUB_ALLOC_ID_LINK_SECTION) {
+		// Linker section allocators are in ROM and are all given the
+		// PUB_SUB_ALLOC_ID_LINK_SECTION id when they are defined. Therefore we need to
+		// calculate the real id from the allocator's index in the linker section
+		STRUCT_SECTION_START_EXTERN(pub_sub_allocator);
+		allocator_id = allocator - STRUCT_SECTION_START(pub_sub_allocator);
+		__ASSERT(allocator_id <= PUB_SUB_ALLOC_ID_LINK_SECTION_MAX_ID, "");
+	}
+	return allocator_id;
+}
+
+/**
+ * @brief Get an allocator from its allocator id
+ *
+ * @param allocator_id The allocator id
+ *
+ * @retval The address of the allocator
+ * @retval NULL If the id does not belong to a linker section or added runtime allocator
+ */
+struct pub_sub_allocator *pub_sub_allocator_from_id(uint8_t allocator_id);
+
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+/**
+ * @brief Internal implementation, only exposed for pub_sub_new_msg
+ */
+void *pub_sub_allocator_stats_allocate(struct pub_sub_allocator *allocator, uint16_t msg_id,
+				       size_t msg_size_bytes, k_timeout_t timeout);
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
+
 /**
  * @brief Acquire a reference to a message
  *
@@ -98,18 +165,13 @@ static inline void *pub_sub_new_msg(struct pub_sub_allocator *allocator, uint16_
 {
 	__ASSERT(allocator != NULL, "");
 	__ASSERT(allocator->allocator_id != PUB_SUB_ALLOC_ID_INVALID, "");
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+	void *msg = pub_sub_allocator_stats_allocate(allocator, msg_id, msg_size_bytes, timeout);
+#else
 	void *msg = allocator->allocate(allocator->impl, msg_size_bytes, timeout);
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 	if (msg != NULL) {
-		uint8_t allocator_id = allocator->allocator_id;
-		if (allocator_id == PUB_SUB_ALLOC_ID_LINK_SECTION) {
-			// Linker section allocators are in ROM and are all given the
-			// PUB_SUB_ALLOC_ID_LINK_SECTION id when they are defined. Therefore we need
-			// to calculate the real id from the allocator's index in the linker section
-			STRUCT_SECTION_START_EXTERN(pub_sub_allocator);
-			allocator_id = allocator - STRUCT_SECTION_START(pub_sub_allocator);
-			__ASSERT(allocator_id <= PUB_SUB_ALLOC_ID_LINK_SECTION_MAX_ID, "");
-		}
-		pub_sub_msg_init(msg, msg_id, allocator_id);
+		pub_sub_msg_init(msg, msg_id, pub_sub_allocator_get_id(allocator));
 		pub_sub_acquire_msg(msg);
 	}
 	return msg;
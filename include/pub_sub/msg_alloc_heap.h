@@ -0,0 +1,76 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_MSG_ALLOC_HEAP_H_
+#define PUB_SUB_MSG_ALLOC_HEAP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pub_sub/msg_alloc.h>
+
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+struct pub_sub_heap_allocator_stats {
+	size_t free_bytes;
+	size_t allocated_bytes;
+	size_t max_allocated_bytes;
+	// Largest number of bytes that can currently be allocated in one block
+	size_t largest_free_block;
+	// Percentage of the free bytes that are not part of the largest free block
+	uint8_t fragmentation_percent;
+};
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+
+/**
+ * @brief Statically define and initialize a heap based message allocator
+ *
+ * Each message takes its size plus PUB_SUB_MSG_OVERHEAD_NUM_BYTES plus the heap's own per block
+ * overhead from the heap.
+ *
+ * @param name Name of the allocator
+ * @param size_bytes Size of the heap in bytes
+ */
+#define PUB_SUB_HEAP_ALLOCATOR_DEFINE_STATIC(name, size_bytes)                                     \
+	K_HEAP_DEFINE(_pub_sub_heap_##name, size_bytes);                                           \
+	static PUB_SUB_ALLOCATOR_DEFINE(name, pub_sub_allocate_from_heap, pub_sub_free_for_heap,   \
+					&_pub_sub_heap_##name)
+
+/**
+ * @brief Initialize a heap based message allocator
+ *
+ * The heap must have already been initialized prior to calling this function.
+ *
+ * @param allocator Address of the allocator
+ * @param heap Address of the heap
+ */
+void pub_sub_init_heap_allocator(struct pub_sub_allocator *allocator, struct k_heap *heap);
+
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+/**
+ * @brief Get the usage and fragmentation statistics of a heap based message allocator
+ *
+ * Finding the largest free block walks one of the heap's free lists while holding the heap's
+ * lock, so it is intended for diagnostics rather than being called on every allocation.
+ *
+ * @param allocator Address of the allocator
+ * @param stats Address the statistics are written to
+ */
+void pub_sub_heap_allocator_stats(const struct pub_sub_allocator *allocator,
+				  struct pub_sub_heap_allocator_stats *stats);
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_HEAP_ALLOCATOR_DEFINE_STATIC
+ */
+void *pub_sub_allocate_from_heap(void *impl, size_t msg_size_bytes, k_timeout_t timeout);
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_HEAP_ALLOCATOR_DEFINE_STATIC
+ */
+void pub_sub_free_for_heap(void *impl, const void *msg);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_MSG_ALLOC_HEAP_H_ */
\ No newline at end of file
@@ -0,0 +1,91 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_MSG_ALLOC_LOCK_FREE_H_
+#define PUB_SUB_MSG_ALLOC_LOCK_FREE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pub_sub/msg_alloc.h>
+
+#define PUB_SUB_LOCK_FREE_POOL_INDEX_MASK 0xFFFFU
+#define PUB_SUB_LOCK_FREE_POOL_EMPTY PUB_SUB_LOCK_FREE_POOL_INDEX_MASK
+#define PUB_SUB_LOCK_FREE_POOL_MAX_NUM_MSGS PUB_SUB_LOCK_FREE_POOL_INDEX_MASK
+
+#define PUB_SUB_LOCK_FREE_ALLOCATOR_BLOCK_SIZE(msg_size)                                           \
+	WB_UP(msg_size + PUB_SUB_MSG_OVERHEAD_NUM_BYTES)
+#define PUB_SUB_LOCK_FREE_ALLOCATOR_BUF_SIZE(msg_size, num_msgs)                                   \
+	(PUB_SUB_LOCK_FREE_ALLOCATOR_BLOCK_SIZE(msg_size) * num_msgs)
+
+// A fixed pool of blocks with a lock free stack of free blocks. The head holds the index of the
+// top free block in its low 16 bits and a tag that is incremented by every push and pop in the
+// remaining bits, so a pop that raced with other pops and pushes of the same block fails its
+// compare and swap instead of installing a stale next index. Each free block holds the index of
+// the next free block in its first word. Blocks that have never been allocated are not on the
+// stack, they are carved off the end of the used part of the buffer so the pool needs no
+// initialization beyond its static initializer.
+struct pub_sub_lock_free_pool {
+	atomic_t head;
+	atomic_t num_carved;
+	uint8_t *buffer;
+	size_t block_size;
+	uint16_t num_blocks;
+};
+
+/**
+ * @brief Statically define and initialize a lock free message allocator
+ *
+ * @param name Name of the allocator
+ * @param msg_size Size of each message
+ * @param num_msgs Number of messages, less than PUB_SUB_LOCK_FREE_POOL_MAX_NUM_MSGS
+ */
+#define PUB_SUB_LOCK_FREE_ALLOCATOR_DEFINE_STATIC(name, msg_size, num_msgs)                        \
+	BUILD_ASSERT((num_msgs) < PUB_SUB_LOCK_FREE_POOL_MAX_NUM_MSGS,                             \
+		     "Too many messages for a lock free allocator");                               \
+	static uint8_t __aligned(sizeof(uintptr_t)) _pub_sub_lock_free_buf_##name                  \
+		[PUB_SUB_LOCK_FREE_ALLOCATOR_BUF_SIZE(msg_size, num_msgs)];                        \
+	static struct pub_sub_lock_free_pool _pub_sub_lock_free_pool_##name = {                    \
+		.head = ATOMIC_INIT(PUB_SUB_LOCK_FREE_POOL_EMPTY),                                 \
+		.num_carved = ATOMIC_INIT(0),                                                      \
+		.buffer = _pub_sub_lock_free_buf_##name,                                           \
+		.block_size = PUB_SUB_LOCK_FREE_ALLOCATOR_BLOCK_SIZE(msg_size),                    \
+		.num_blocks = num_msgs,                                                            \
+	};                                                                                         \
+	static PUB_SUB_ALLOCATOR_DEFINE(name, pub_sub_allocate_from_lock_free_pool,                \
+					pub_sub_free_for_lock_free_pool,                           \
+					&_pub_sub_lock_free_pool_##name)
+
+/**
+ * @brief Initialize a lock free message allocator
+ *
+ * Allocating and freeing messages never takes a lock or blocks so it can be done from ISRs on any
+ * CPU. As allocating never blocks the allocation timeout is ignored and an allocation from an
+ * empty pool fails immediately.
+ *
+ * @param allocator Address of the allocator
+ * @param pool Address of the pool
+ * @param buffer Buffer for the messages, aligned to sizeof(uintptr_t) and sized with
+ * PUB_SUB_LOCK_FREE_ALLOCATOR_BUF_SIZE
+ * @param msg_size Size of each message
+ * @param num_msgs Number of messages, less than PUB_SUB_LOCK_FREE_POOL_MAX_NUM_MSGS
+ */
+void pub_sub_init_lock_free_allocator(struct pub_sub_allocator *allocator,
+				      struct pub_sub_lock_free_pool *pool, uint8_t *buffer,
+				      size_t msg_size, uint16_t num_msgs);
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_LOCK_FREE_ALLOCATOR_DEFINE_STATIC
+ */
+void *pub_sub_allocate_from_lock_free_pool(void *impl, size_t msg_size_bytes, k_timeout_t timeout);
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_LOCK_FREE_ALLOCATOR_DEFINE_STATIC
+ */
+void pub_sub_free_for_lock_free_pool(void *impl, const void *msg);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_MSG_ALLOC_LOCK_FREE_H_ */
\ No newline at end of file
@@ -52,6 +52,83 @@ void *pub_sub_allocate_from_mem_slab(void *impl, size_t msg_size_bytes, k_timeou
  * @brief Internal implementation, only exposed for PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC
  */
 void pub_sub_free_for_mem_slab(void *impl, const void *msg);
+
+#ifdef CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+// Each CPU's magazine is kept on its own cache line so the CPUs do not contend over them
+#define PUB_SUB_MEM_SLAB_MAGAZINE_ALIGN 64
+
+struct pub_sub_mem_slab_magazine {
+	struct k_spinlock lock;
+	uint8_t num_blocks;
+	void *blocks[CONFIG_PUB_SUB_MEM_SLAB_MAGAZINE_SIZE];
+} __aligned(PUB_SUB_MEM_SLAB_MAGAZINE_ALIGN);
+
+struct pub_sub_mem_slab_magazines {
+	struct pub_sub_mem_slab_magazine cpus[CONFIG_MP_MAX_NUM_CPUS];
+	struct k_mem_slab *mem_slab;
+	// Allocations that have found every magazine empty and may wait on the memory slab
+	atomic_t num_waiting;
+};
+
+/**
+ * @brief Statically define and initialize a memory slab based message allocator with per CPU
+ * magazines
+ *
+ * @param name Name of the allocator
+ * @param msg_size Size of each message
+ * @param num_msgs Number of messages
+ */
+#define PUB_SUB_MEM_SLAB_MAGAZINE_ALLOCATOR_DEFINE_STATIC(name, msg_size, num_msgs)                \
+	K_MEM_SLAB_DEFINE_STATIC(_pub_sub_mem_slab_##name,                                         \
+				 msg_size + PUB_SUB_MSG_OVERHEAD_NUM_BYTES, num_msgs,              \
+				 sizeof(uintptr_t));                                               \
+	static struct pub_sub_mem_slab_magazines _pub_sub_magazines_##name = {                     \
+		.mem_slab = &_pub_sub_mem_slab_##name,                                             \
+	};                                                                                         \
+	static PUB_SUB_ALLOCATOR_DEFINE(name, pub_sub_allocate_from_mem_slab_magazines,            \
+					pub_sub_free_for_mem_slab_magazines,                       \
+					&_pub_sub_magazines_##name)
+
+/**
+ * @brief Initialize a memory slab based message allocator with per CPU magazines
+ *
+ * Each CPU has a magazine, a small stack of free blocks, that its allocations are taken from and
+ * its frees are returned to. A magazine is refilled from, or flushed to, the memory slab half a
+ * magazine at a time so the memory slab's lock is only taken when a magazine runs empty or full.
+ * The memory slab must have already been initialized prior to calling this function and sized as
+ * for pub_sub_init_mem_slab_allocator.
+ *
+ * @param allocator Address of the allocator
+ * @param magazines Address of the magazines
+ * @param mem_slab Address of the memory slab
+ */
+void pub_sub_init_mem_slab_magazine_allocator(struct pub_sub_allocator *allocator,
+					      struct pub_sub_mem_slab_magazines *magazines,
+					      struct k_mem_slab *mem_slab);
+
+/**
+ * @brief Return the free blocks held in the magazines of an allocator to its memory slab
+ *
+ * Blocks held in a magazine are counted as used by the memory slab, flushing the magazines
+ * before reading the memory slab's usage gives the number of allocated messages.
+ *
+ * @param allocator Address of the allocator
+ */
+void pub_sub_mem_slab_magazines_flush(const struct pub_sub_allocator *allocator);
+
+/**
+ * @brief Internal implementation, only exposed for
+ * PUB_SUB_MEM_SLAB_MAGAZINE_ALLOCATOR_DEFINE_STATIC
+ */
+void *pub_sub_allocate_from_mem_slab_magazines(void *impl, size_t msg_size_bytes,
+					       k_timeout_t timeout);
+
+/**
+ * @brief Internal implementation, only exposed for
+ * PUB_SUB_MEM_SLAB_MAGAZINE_ALLOCATOR_DEFINE_STATIC
+ */
+void pub_sub_free_for_mem_slab_magazines(void *impl, const void *msg);
+#endif // CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,162 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_MSG_ALLOC_SIZE_CLASS_H_
+#define PUB_SUB_MSG_ALLOC_SIZE_CLASS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pub_sub/msg_alloc.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+
+struct pub_sub_size_class_counters {
+	// Allocations that fitted the class but were served by a larger class
+	atomic_t fallbacks;
+	// Allocations that fitted the class but could not be served
+	atomic_t failures;
+};
+
+struct pub_sub_size_class_allocator {
+	// Memory slabs in order of increasing block size
+	struct k_mem_slab *const *classes;
+	struct pub_sub_size_class_counters *counters;
+	uint8_t num_classes;
+	bool fallback;
+};
+
+struct pub_sub_size_class_stats {
+	size_t msg_size;
+	uint32_t num_msgs;
+	uint32_t num_used;
+#ifdef CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION
+	uint32_t max_used;
+#endif // CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION
+	uint32_t num_fallbacks;
+	uint32_t num_failures;
+};
+
+/**
+ * @brief Statically define and initialize a memory slab for a size class allocator
+ *
+ * @param name Name of the memory slab
+ * @param msg_size Size of the largest message the class holds
+ * @param num_msgs Number of messages
+ */
+#define PUB_SUB_SIZE_CLASS_DEFINE_STATIC(name, msg_size, num_msgs)                                 \
+	K_MEM_SLAB_DEFINE_STATIC(name, PUB_SUB_MEM_SLAB_ALLOCATOR_BLOCK_SIZE(msg_size), num_msgs,  \
+				 sizeof(uintptr_t))
+
+/**
+ * @brief Statically define and initialize a size class message allocator
+ *
+ * The classes are the addresses of memory slabs defined with PUB_SUB_SIZE_CLASS_DEFINE_STATIC and
+ * must be listed in order of increasing message size.
+ *
+ * @param name Name of the allocator
+ * @param fallback_to_larger Allocate from a larger class when the best fitting class is empty
+ * @param ... Addresses of the memory slabs of each class
+ */
+#define PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE_STATIC(name, fallback_to_larger, ...)                  \
+	static struct k_mem_slab *const _pub_sub_size_classes_##name[] = {__VA_ARGS__};            \
+	_PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE(name, fallback_to_larger)
+
+/**
+ * @brief Statically define and initialize a size class message allocator with power of two classes
+ *
+ * Class n holds messages of up to min_msg_size << n bytes.
+ *
+ * @param name Name of the allocator
+ * @param fallback_to_larger Allocate from a larger class when the best fitting class is empty
+ * @param min_msg_size Size of the largest message held by the smallest class
+ * @param num_classes Number of classes, must be an integer literal
+ * @param num_msgs Number of messages in each class
+ */
+#define PUB_SUB_SIZE_CLASS_ALLOCATOR_POW2_DEFINE_STATIC(name, fallback_to_larger, min_msg_size,    \
+							num_classes, num_msgs)                     \
+	LISTIFY(num_classes, _PUB_SUB_SIZE_CLASS_POW2_DEFINE, (;), name, min_msg_size, num_msgs);  \
+	static struct k_mem_slab *const _pub_sub_size_classes_##name[] = {                         \
+		LISTIFY(num_classes, _PUB_SUB_SIZE_CLASS_POW2_ADDR, (,), name)};                   \
+	_PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE(name, fallback_to_larger)
+
+#define _PUB_SUB_SIZE_CLASS_POW2_DEFINE(n, name, min_msg_size, num_msgs)                           \
+	PUB_SUB_SIZE_CLASS_DEFINE_STATIC(_pub_sub_size_class_##name##_##n, (min_msg_size) << (n),  \
+					 num_msgs)
+
+#define _PUB_SUB_SIZE_CLASS_POW2_ADDR(n, name) &_pub_sub_size_class_##name##_##n
+
+#define _PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE(name, fallback_to_larger)                             \
+	static struct pub_sub_size_class_counters                                                  \
+		_pub_sub_size_class_counters_##name[ARRAY_SIZE(_pub_sub_size_classes_##name)];     \
+	static struct pub_sub_size_class_allocator _pub_sub_size_class_allocator_##name = {        \
+		.classes = _pub_sub_size_classes_##name,                                           \
+		.counters = _pub_sub_size_class_counters_##name,                                   \
+		.num_classes = ARRAY_SIZE(_pub_sub_size_classes_##name),                           \
+		.fallback = fallback_to_larger,                                                    \
+	};                                                                                         \
+	static PUB_SUB_ALLOCATOR_DEFINE(name, pub_sub_allocate_from_size_classes,                  \
+					pub_sub_free_for_size_classes,                             \
+					&_pub_sub_size_class_allocator_##name)
+
+/**
+ * @brief Initialize a size class message allocator
+ *
+ * The memory slabs must have already been initialized prior to calling this function, must be
+ * sized with PUB_SUB_MEM_SLAB_ALLOCATOR_BLOCK_SIZE and must be in order of increasing block size.
+ *
+ * @param allocator Address of the allocator
+ * @param size_classes Address of the size class allocator implementation
+ * @param classes Array of memory slab addresses, one per class
+ * @param counters Array of counters, one per class
+ * @param num_classes Number of classes
+ * @param fallback_to_larger Allocate from a larger class when the best fitting class is empty
+ */
+void pub_sub_init_size_class_allocator(struct pub_sub_allocator *allocator,
+				       struct pub_sub_size_class_allocator *size_classes,
+				       struct k_mem_slab *const *classes,
+				       struct pub_sub_size_class_counters *counters,
+				       uint8_t num_classes, bool fallback_to_larger);
+
+/**
+ * @brief Get the occupancy statistics of a class of a size class allocator
+ *
+ * @param allocator Address of the allocator
+ * @param size_class Index of the class, 0 is the smallest class
+ * @param stats Address the statistics are written to
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the allocator does not have the class
+ */
+int pub_sub_size_class_allocator_stats(const struct pub_sub_allocator *allocator,
+				       uint8_t size_class, struct pub_sub_size_class_stats *stats);
+
+/**
+ * @brief Get the number of classes of a size class allocator
+ *
+ * @param allocator Address of the allocator
+ *
+ * @return Number of classes
+ */
+static inline uint8_t pub_sub_size_class_allocator_num_classes(
+	const struct pub_sub_allocator *allocator)
+{
+	__ASSERT(allocator != NULL, "");
+	const struct pub_sub_size_class_allocator *size_classes = allocator->impl;
+	return size_classes->num_classes;
+}
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE_STATIC
+ */
+void *pub_sub_allocate_from_size_classes(void *impl, size_t msg_size_bytes, k_timeout_t timeout);
+
+/**
+ * @brief Internal implementation, only exposed for PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE_STATIC
+ */
+void pub_sub_free_for_size_classes(void *impl, const void *msg);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_MSG_ALLOC_SIZE_CLASS_H_ */
\ No newline at end of file
@@ -0,0 +1,75 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_MSG_ALLOC_STATS_H_
+#define PUB_SUB_MSG_ALLOC_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <pub_sub/msg_alloc.h>
+
+struct pub_sub_allocator_stats {
+	// Messages currently allocated and the most that have been allocated at once
+	uint32_t in_use;
+	uint32_t peak_in_use;
+	// Successful and failed allocations
+	uint32_t allocations;
+	uint32_t failures;
+	// Time spent waiting for a message to be freed by allocations that were allowed to wait
+	uint64_t blocked_ns;
+};
+
+/**
+ * @brief Get a copy of an allocator's statistics
+ *
+ * @param allocator Address of the allocator, a runtime allocator must have been added
+ * @param stats Address to copy the statistics to
+ */
+void pub_sub_allocator_stats_get(const struct pub_sub_allocator *allocator,
+				 struct pub_sub_allocator_stats *stats);
+
+/**
+ * @brief Get the number of live messages with a message id allocated from an allocator
+ *
+ * Message ids above CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID are counted together, for any of
+ * them the combined count is returned.
+ *
+ * @param allocator Address of the allocator, a runtime allocator must have been added
+ * @param msg_id The message id
+ *
+ * @return Number of live messages
+ */
+uint32_t pub_sub_allocator_stats_live_msgs(const struct pub_sub_allocator *allocator,
+					   uint16_t msg_id);
+
+/**
+ * @brief Reset an allocator's statistics
+ *
+ * The number of messages in use and live messages are kept and the current number in use becomes
+ * the new peak.
+ *
+ * @param allocator Address of the allocator, a runtime allocator must have been added
+ */
+void pub_sub_allocator_stats_reset(const struct pub_sub_allocator *allocator);
+
+/**
+ * @brief Call a function for every linker section and added runtime allocator
+ *
+ * @param fn The function to call with each allocator
+ * @param user_data Passed to the function
+ */
+void pub_sub_allocator_stats_foreach(void (*fn)(const struct pub_sub_allocator *allocator,
+						void *user_data),
+				     void *user_data);
+
+/**
+ * @brief Internal implementation, only exposed for pub_sub_release_msg
+ */
+void pub_sub_allocator_stats_record_free(const struct pub_sub_allocator *allocator,
+					 uint16_t msg_id);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_MSG_ALLOC_STATS_H_ */
\ No newline at end of file
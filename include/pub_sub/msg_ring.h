@@ -0,0 +1,117 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_MSG_RING_H_
+#define PUB_SUB_MSG_RING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <zephyr/kernel.h>
+
+// A bounded multi producer single consumer ring of message pointers. Producers reserve a slot by
+// advancing the head and then store the message in it, the consumer treats an empty slot as the end
+// of the ring so a message becomes visible once it has been stored. The semaphore is given after
+// every put, once for a whole list, to wake the consumer.
+struct pub_sub_msg_ring {
+	atomic_ptr_t *slots;
+	atomic_val_t mask;
+	atomic_t head;
+	atomic_t tail;
+	atomic_t dropped;
+	struct k_sem signal;
+};
+
+/**
+ * @brief Statically define and initialize a message ring
+ *
+ * @param name Name of the message ring
+ * @param num_msgs The maximum number of messages the ring can hold, must be a power of 2
+ */
+#define PUB_SUB_MSG_RING_DEFINE(name, num_msgs)                                                    \
+	BUILD_ASSERT(IS_POWER_OF_TWO(num_msgs), "Message ring size must be a power of 2");        \
+	static atomic_ptr_t _pub_sub_msg_ring_slots_##name[num_msgs];                             \
+	struct pub_sub_msg_ring name = {                                                           \
+		.slots = _pub_sub_msg_ring_slots_##name,                                           \
+		.mask = (num_msgs) - 1,                                                            \
+		.head = ATOMIC_INIT(0),                                                            \
+		.tail = ATOMIC_INIT(0),                                                            \
+		.dropped = ATOMIC_INIT(0),                                                         \
+		.signal = Z_SEM_INITIALIZER(name.signal, 0, 1),                                    \
+	}
+
+/**
+ * @brief Initialize a message ring
+ *
+ * @param ring Address of the message ring
+ * @param slots Array of slots to hold the queued messages
+ * @param num_msgs The number of slots in the array, must be a power of 2
+ */
+void pub_sub_msg_ring_init(struct pub_sub_msg_ring *ring, atomic_ptr_t *slots, size_t num_msgs);
+
+/**
+ * @brief Put a publish subscribe message into a message ring
+ *
+ * Can be called from an ISR. If the ring is full the message's reference is released and the
+ * ring's dropped counter is incremented.
+ *
+ * @warning
+ * Must only be called with messages that conform to the publish subscribe message memory layout
+ * i.e. the message is preceded by the pub_sub_msg struct.
+ *
+ * @param ring Address of the message ring
+ * @param msg Address of the message
+ *
+ * @retval 0 The message was put into the ring
+ * @retval -ENOBUFS The ring was full and the message was dropped
+ */
+int pub_sub_msg_ring_put(struct pub_sub_msg_ring *ring, void *msg);
+
+/**
+ * @brief Put a list of publish subscribe messages into a message ring
+ *
+ * Can be called from an ISR. The slots for all of the messages are reserved together and the
+ * consumer is only woken once. Messages that do not fit in the ring have their reference released
+ * and are counted by the ring's dropped counter. The list is empty when this returns.
+ *
+ * @warning
+ * Must only be called with messages that conform to the publish subscribe message memory layout
+ * i.e. the message is preceded by the pub_sub_msg struct.
+ *
+ * @param ring Address of the message ring
+ * @param list Address of the list of messages, built with pub_sub_msg_list_append
+ *
+ * @retval The number of messages put into the ring
+ */
+size_t pub_sub_msg_ring_put_list(struct pub_sub_msg_ring *ring, sys_slist_t *list);
+
+/**
+ * @brief Get a publish subscribe message from a message ring
+ *
+ * Must only be called by the ring's single consumer.
+ *
+ * @param ring Address of the message ring
+ * @param timeout How long to wait for a message to be put into the ring
+ *
+ * @retval Address of the message if successful, NULL on timeout
+ */
+void *pub_sub_msg_ring_get(struct pub_sub_msg_ring *ring, k_timeout_t timeout);
+
+/**
+ * @brief Get the number of messages dropped because the message ring was full
+ *
+ * @param ring Address of the message ring
+ *
+ * @retval The number of dropped messages
+ */
+static inline atomic_val_t pub_sub_msg_ring_dropped(struct pub_sub_msg_ring *ring)
+{
+	__ASSERT(ring != NULL, "");
+	return atomic_get(&ring->dropped);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_MSG_RING_H_ */
\ No newline at end of file
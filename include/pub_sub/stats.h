@@ -0,0 +1,107 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_STATS_H_
+#define PUB_SUB_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <zephyr/kernel.h>
+
+struct pub_sub_broker;
+struct pub_sub_subscriber;
+
+struct pub_sub_broker_stats {
+	// Messages routed to the broker's subscribers, including direct publishes
+	uint32_t msgs_dispatched;
+	// Time spent waiting for space in full msgq subscriber queues
+	uint64_t msgq_blocked_ns;
+};
+
+struct pub_sub_subscriber_stats {
+	// Messages queued on a msgq or fifo subscriber
+	uint32_t msgs_queued;
+	// Messages currently queued, read from the subscriber's queue when the statistics are copied
+	uint32_t queue_depth;
+	// The most messages that have been queued at once
+	uint32_t queue_peak;
+	// Time spent waiting for space in a full msgq subscriber queue
+	uint64_t msgq_blocked_ns;
+	// Calls to the subscriber's handler function and the total time spent in them
+	uint32_t handler_calls;
+	uint64_t handler_ns;
+};
+
+/**
+ * @brief Get a copy of a broker's statistics
+ *
+ * @param broker Address of the broker
+ * @param stats Address to copy the statistics to
+ */
+void pub_sub_broker_stats_get(struct pub_sub_broker *broker, struct pub_sub_broker_stats *stats);
+
+/**
+ * @brief Reset a broker's statistics
+ *
+ * @param broker Address of the broker
+ */
+void pub_sub_broker_stats_reset(struct pub_sub_broker *broker);
+
+/**
+ * @brief Get a copy of a subscriber's statistics
+ *
+ * @param subscriber Address of the subscriber
+ * @param stats Address to copy the statistics to
+ */
+void pub_sub_subscriber_stats_get(struct pub_sub_subscriber *subscriber,
+				  struct pub_sub_subscriber_stats *stats);
+
+/**
+ * @brief Reset a subscriber's statistics
+ *
+ * The current queue depth becomes the new queue peak.
+ *
+ * @param subscriber Address of the subscriber
+ */
+void pub_sub_subscriber_stats_reset(struct pub_sub_subscriber *subscriber);
+
+/**
+ * @brief Call a function for every initialized broker
+ *
+ * @param fn The function to call with each broker
+ * @param user_data Passed to the function
+ */
+void pub_sub_stats_foreach_broker(void (*fn)(struct pub_sub_broker *broker, void *user_data),
+				  void *user_data);
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ */
+void pub_sub_stats_register_broker(struct pub_sub_broker *broker);
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ */
+void pub_sub_stats_record_dispatch(struct pub_sub_broker *broker, size_t num_msgs);
+
+/**
+ * @brief Internal implementation, only exposed for the broker and subscribers
+ */
+void pub_sub_stats_record_queued(struct pub_sub_subscriber *subscriber);
+
+/**
+ * @brief Internal implementation, only exposed for subscribers
+ */
+void pub_sub_stats_record_msgq_blocked(struct pub_sub_subscriber *subscriber, uint32_t cycles);
+
+/**
+ * @brief Internal implementation, only exposed for pub_sub_subscriber_call_handler
+ */
+void pub_sub_stats_record_handler(struct pub_sub_subscriber *subscriber, uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_STATS_H_ */
\ No newline at end of file
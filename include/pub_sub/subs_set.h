@@ -0,0 +1,207 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_SUBS_SET_H_
+#define PUB_SUB_SUBS_SET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <zephyr/kernel.h>
+
+// The number of message ids covered by each chunk of a chunked bitmap
+#define PUB_SUB_SUBS_CHUNK_NUM_IDS 256
+
+enum pub_sub_subs_set_type {
+	// A sorted array of message ids, 2 bytes per subscription
+	PUB_SUB_SUBS_SET_SORTED_ARRAY,
+	// A sorted list of inclusive message id ranges, 4 bytes per run of consecutive ids
+	PUB_SUB_SUBS_SET_RANGE_LIST,
+	// A sorted array of bitmaps that each cover PUB_SUB_SUBS_CHUNK_NUM_IDS message ids, only
+	// chunks that contain a subscription are stored. Every chunk is a full bitmap, as entries
+	// are a fixed size storing a sparse chunk's ids in an array instead wouldn't save space.
+	PUB_SUB_SUBS_SET_CHUNKED_BITMAP,
+};
+
+struct pub_sub_subs_range {
+	uint16_t first;
+	uint16_t last;
+};
+
+struct pub_sub_subs_chunk {
+	// The message ids in the chunk are key * PUB_SUB_SUBS_CHUNK_NUM_IDS onwards
+	uint16_t key;
+	uint32_t bits[PUB_SUB_SUBS_CHUNK_NUM_IDS / 32];
+};
+
+// A compact set of subscriptions for subscribers to large sparse message id spaces. The set keeps
+// two copies of its entries. Testing for a subscription reads the published copy without locking,
+// while modifications, serialized by the set's mutex, are made to the other copy which is then
+// published in its place.
+struct pub_sub_subs_set {
+	struct k_mutex mutex;
+	enum pub_sub_subs_set_type type;
+	// The index of the copy that is read when testing for a subscription
+	atomic_t published;
+	// The sequence of each copy, odd while the copy is being written
+	atomic_t seqs[2];
+	// The number of entries used in each copy and the capacity of each copy
+	uint16_t num_entries[2];
+	uint16_t max_entries;
+	// Storage for both copies, max_entries entries each
+	union {
+		uint16_t *ids;
+		struct pub_sub_subs_range *ranges;
+		struct pub_sub_subs_chunk *chunks;
+	};
+};
+
+#define _PUB_SUB_SUBS_SET_DEFINE(name, _type, entry_type, field, max)                              \
+	static entry_type _pub_sub_subs_set_storage_##name[2 * (max)];                             \
+	struct pub_sub_subs_set name = {                                                           \
+		.mutex = Z_MUTEX_INITIALIZER(name.mutex),                                          \
+		.type = _type,                                                                     \
+		.published = ATOMIC_INIT(0),                                                       \
+		.max_entries = max,                                                                \
+		.field = _pub_sub_subs_set_storage_##name,                                         \
+	}
+
+/**
+ * @brief Statically define and initialize a sorted array subscription set
+ *
+ * @param name Name of the subscription set
+ * @param max_ids The maximum number of message ids that can be subscribed to
+ */
+#define PUB_SUB_SUBS_SORTED_ARRAY_DEFINE(name, max_ids)                                            \
+	_PUB_SUB_SUBS_SET_DEFINE(name, PUB_SUB_SUBS_SET_SORTED_ARRAY, uint16_t, ids, max_ids)
+
+/**
+ * @brief Statically define and initialize a range list subscription set
+ *
+ * @param name Name of the subscription set
+ * @param max_ranges The maximum number of runs of consecutive message ids that can be subscribed
+ * to
+ */
+#define PUB_SUB_SUBS_RANGE_LIST_DEFINE(name, max_ranges)                                           \
+	_PUB_SUB_SUBS_SET_DEFINE(name, PUB_SUB_SUBS_SET_RANGE_LIST, struct pub_sub_subs_range,     \
+				 ranges, max_ranges)
+
+/**
+ * @brief Statically define and initialize a chunked bitmap subscription set
+ *
+ * @param name Name of the subscription set
+ * @param max_chunks The maximum number of chunks of PUB_SUB_SUBS_CHUNK_NUM_IDS message ids that
+ * can contain subscriptions
+ */
+#define PUB_SUB_SUBS_CHUNKED_BITMAP_DEFINE(name, max_chunks)                                       \
+	_PUB_SUB_SUBS_SET_DEFINE(name, PUB_SUB_SUBS_SET_CHUNKED_BITMAP, struct pub_sub_subs_chunk, \
+				 chunks, max_chunks)
+
+/**
+ * @brief Initialize an empty subscription set
+ *
+ * @param subs_set Address of the subscription set
+ * @param type The representation of the set
+ * @param storage Array of 2 * max_entries entries matching the type: uint16_t for a sorted array,
+ * pub_sub_subs_range for a range list or pub_sub_subs_chunk for a chunked bitmap
+ * @param max_entries The maximum number of entries in the set
+ */
+void pub_sub_subs_set_init(struct pub_sub_subs_set *subs_set, enum pub_sub_subs_set_type type,
+			   void *storage, uint16_t max_entries);
+
+/**
+ * @brief Add a message id to a subscription set
+ *
+ * Must not be called from an ISR.
+ *
+ * @param subs_set Address of the subscription set
+ * @param msg_id The message id to add
+ *
+ * @retval 1 The message id was added
+ * @retval 0 The message id was already in the set
+ * @retval -ENOMEM There was no space in the set's storage
+ */
+int pub_sub_subs_set_add(struct pub_sub_subs_set *subs_set, uint16_t msg_id);
+
+/**
+ * @brief Remove a message id from a subscription set
+ *
+ * Must not be called from an ISR.
+ *
+ * @param subs_set Address of the subscription set
+ * @param msg_id The message id to remove
+ *
+ * @retval 1 The message id was removed
+ * @retval 0 The message id was not in the set
+ * @retval -ENOMEM Removing the message id would split a range and the range list is full
+ */
+int pub_sub_subs_set_remove(struct pub_sub_subs_set *subs_set, uint16_t msg_id);
+
+/**
+ * @brief Add a range of message ids to a subscription set
+ *
+ * The whole range is added in a single modification of the set, a range list merges it into a
+ * single entry. Either all of the message ids are added or, if there isn't enough space, none of
+ * them are. Must not be called from an ISR.
+ *
+ * @param subs_set Address of the subscription set
+ * @param first_msg_id The first message id to add
+ * @param last_msg_id The last message id to add, inclusive
+ *
+ * @retval 1 At least one message id was added
+ * @retval 0 All of the message ids were already in the set
+ * @retval -ENOMEM There was no space in the set's storage
+ */
+int pub_sub_subs_set_add_range(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+			       uint16_t last_msg_id);
+
+/**
+ * @brief Remove a range of message ids from a subscription set
+ *
+ * The whole range is removed in a single modification of the set. Must not be called from an ISR.
+ *
+ * @param subs_set Address of the subscription set
+ * @param first_msg_id The first message id to remove
+ * @param last_msg_id The last message id to remove, inclusive
+ *
+ * @retval 1 At least one message id was removed
+ * @retval 0 None of the message ids were in the set
+ * @retval -ENOMEM Removing the range would split a range and the range list is full
+ */
+int pub_sub_subs_set_remove_range(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+				  uint16_t last_msg_id);
+
+/**
+ * @brief Check if a message id is in a subscription set
+ *
+ * Can be called from an ISR. The set is read without locking, the check is only repeated if the set
+ * was modified more than once while it was being read.
+ *
+ * @param subs_set Address of the subscription set
+ * @param msg_id The message id to check
+ *
+ * @retval true The message id is in the set
+ * @retval false The message id is not in the set
+ */
+bool pub_sub_subs_set_contains(struct pub_sub_subs_set *subs_set, uint16_t msg_id);
+
+/**
+ * @brief Check if any message id in a range is in a subscription set
+ *
+ * Can be called from an ISR, the set is read the same way as pub_sub_subs_set_contains.
+ *
+ * @param subs_set Address of the subscription set
+ * @param first_msg_id The first message id of the range to check
+ * @param last_msg_id The last message id of the range to check, inclusive
+ *
+ * @retval true At least one message id in the range is in the set
+ * @retval false None of the message ids in the range are in the set
+ */
+bool pub_sub_subs_set_contains_any(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+				   uint16_t last_msg_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_SUBS_SET_H_ */
\ No newline at end of file
@@ -8,15 +8,64 @@
 extern "C" {
 #endif
 #include <zephyr/kernel.h>
+#ifdef CONFIG_PUB_SUB_STATS
+#include <pub_sub/stats.h>
+#endif // CONFIG_PUB_SUB_STATS
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+#include <pub_sub/subs_set.h>
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+#ifdef CONFIG_PUB_SUB_TOPICS
+#include <pub_sub/topic.h>
+#endif // CONFIG_PUB_SUB_TOPICS
 
 typedef void (*pub_sub_handler_fn)(uint16_t msg_id, const void *msg, void *user_data);
 
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+struct pub_sub_executor;
+#endif // CONFIG_PUB_SUB_EXECUTOR
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+// Returns true if the subscriber should receive the message. Called by the broker so it must not
+// block.
+typedef bool (*pub_sub_filter_fn)(uint16_t msg_id, const void *msg, void *user_data);
+
+// A content filter run by the broker before a message is sent to a subscriber
+struct pub_sub_filter {
+	sys_snode_t node;
+	pub_sub_filter_fn filter;
+	void *user_data;
+	// Only used if 'all_msg_ids' is false
+	uint16_t msg_id;
+	bool all_msg_ids;
+	// The number of messages the filter accepted and rejected
+	atomic_t hits;
+	atomic_t misses;
+};
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+
 enum pub_sub_rx_type {
 	PUB_SUB_RX_TYPE_CALLBACK,
 	PUB_SUB_RX_TYPE_MSGQ,
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	PUB_SUB_RX_TYPE_GROUP,
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 	PUB_SUB_RX_TYPE_FIFO,
 };
 
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+// What the broker does when a message is sent to a msgq subscriber with a full message queue
+enum pub_sub_msgq_overflow_policy {
+	// Wait until there is space in the message queue
+	PUB_SUB_MSGQ_OVERFLOW_BLOCK,
+	// Drop the message being sent
+	PUB_SUB_MSGQ_OVERFLOW_DROP_NEWEST,
+	// Drop the oldest message in the message queue to make space
+	PUB_SUB_MSGQ_OVERFLOW_DROP_OLDEST,
+	// Drop the message being sent if its id is greater than the drop level, otherwise wait
+	PUB_SUB_MSGQ_OVERFLOW_DROP_ABOVE_LEVEL,
+};
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+
 struct pub_sub_subscriber_handler_data {
 	pub_sub_handler_fn msg_handler;
 	void *user_data;
@@ -31,14 +80,126 @@ struct pub_sub_subscriber {
 		struct k_fifo fifo;
 	};
 	atomic_t *subs_bitarray;
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	// When set the subscriptions are tracked in the set instead of the bit array
+	struct pub_sub_subs_set *subs_set;
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+#ifdef CONFIG_PUB_SUB_TOPICS
+	// Bit n is set while subscribed to every message id with the level 1 or level 1 and 2
+	// namespace prefix n
+	ATOMIC_DEFINE(topic_prefixes_1, PUB_SUB_TOPIC_NUM_PREFIXES(1));
+	ATOMIC_DEFINE(topic_prefixes_2, PUB_SUB_TOPIC_NUM_PREFIXES(2));
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+	sys_slist_t filters;
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
 	enum pub_sub_rx_type rx_type;
 	uint16_t max_pub_msg_id;
 	// Priority is relative to other subscribers of the same type i.e. a low priority callback
 	// will always be higher priority than a high priority msgq.
 	// 0 is highest priority, 255 is lowest priority
 	uint8_t priority;
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+	// Only used by msgq subscribers
+	enum pub_sub_msgq_overflow_policy msgq_overflow_policy;
+	uint16_t msgq_drop_level;
+	atomic_t msgq_dropped;
+	atomic_t msgq_blocked;
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+#if defined(CONFIG_PUB_SUB_STATS) || defined(CONFIG_PUB_SUB_SUBSCRIBER_GROUPS)
+	// Only used by fifo subscribers, the number of queued messages. Read by the statistics and
+	// by subscriber groups that pick their least queued member.
+	atomic_t fifo_depth;
+#endif
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+	// Only used by fifo subscribers, messages dropped because no envelope was free
+	atomic_t fifo_dropped;
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+	// Only used by msgq and fifo subscribers whose queued messages are handled by an executor,
+	// the node and state are guarded by the executor's lock
+	struct pub_sub_executor *executor;
+	sys_snode_t ready_node;
+	uint8_t exec_state;
+#endif // CONFIG_PUB_SUB_EXECUTOR
+#ifdef CONFIG_PUB_SUB_STATS
+	struct k_spinlock stats_lock;
+	struct pub_sub_subscriber_stats stats;
+#endif // CONFIG_PUB_SUB_STATS
 };
 
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Calls the subscriber's handler function with a message.
+ */
+static inline void pub_sub_subscriber_call_handler(struct pub_sub_subscriber *subscriber,
+						   uint16_t msg_id, const void *msg)
+{
+	__ASSERT(subscriber->handler_data.msg_handler != NULL, "");
+#ifdef CONFIG_PUB_SUB_STATS
+	uint32_t start = k_cycle_get_32();
+	subscriber->handler_data.msg_handler(msg_id, msg, subscriber->handler_data.user_data);
+	pub_sub_stats_record_handler(subscriber, k_cycle_get_32() - start);
+#else
+	subscriber->handler_data.msg_handler(msg_id, msg, subscriber->handler_data.user_data);
+#endif // CONFIG_PUB_SUB_STATS
+}
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Runs the subscriber's filters that apply to 'msg_id', before the broker acquires a reference to
+ * the message for the subscriber. Returns false if any of them rejected the message.
+ */
+static inline bool pub_sub_subscriber_filter_msg(struct pub_sub_subscriber *subscriber,
+						 uint16_t msg_id, const void *msg)
+{
+	struct pub_sub_filter *filter;
+	SYS_SLIST_FOR_EACH_CONTAINER(&subscriber->filters, filter, node) {
+		if (!filter->all_msg_ids && (filter->msg_id != msg_id)) {
+			continue;
+		}
+		if (!filter->filter(msg_id, msg, filter->user_data)) {
+			atomic_inc(&filter->misses);
+			return false;
+		}
+		atomic_inc(&filter->hits);
+	}
+	return true;
+}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Queues a message on a msgq subscriber's message queue, passing the ownership of the message's
+ * reference to the subscriber. With CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY a full message queue is
+ * handled according to the subscriber's overflow policy.
+ */
+void pub_sub_subscriber_msgq_put(struct pub_sub_subscriber *subscriber, void *msg);
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Queues a message on a fifo subscriber's fifo, passing the ownership of the message's reference to
+ * the subscriber. With CONFIG_PUB_SUB_FIFO_FANOUT the message is linked through an envelope taken
+ * from a shared pool so it can be queued on several fifo subscribers at once. If no envelope is
+ * freed within CONFIG_PUB_SUB_FIFO_FANOUT_ENVELOPE_TIMEOUT_MS, or at once from an ISR, the message
+ * is dropped and counted by pub_sub_subscriber_fifo_dropped.
+ */
+void pub_sub_subscriber_fifo_put(struct pub_sub_subscriber *subscriber, void *msg);
+
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+/**
+ * @brief Internal implementation, only exposed for the pub_sub_subscribe and pub_sub_unsubscribe
+ * family of functions
+ */
+void pub_sub_broker_update_subscriptions(struct pub_sub_broker *broker, uint16_t first_msg_id,
+					 uint16_t last_msg_id);
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+
 #define PUB_SUB_SUBS_BITARRAY_BYTE_LEN(max_msg_id)                                                 \
 	(ATOMIC_BITMAP_SIZE(max_msg_id + 1) * sizeof(atomic_t))
 
@@ -112,34 +273,175 @@ void pub_sub_init_fifo_subscriber(struct pub_sub_subscriber *subscriber, atomic_
  *
  * A subscriber must be subscribed to a message id to receive it
  *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING, which the
+ * routing index, subscription summary and topics select, as the broker's routing data is then also
+ * updated under its subscriber list mutex and may be allocated from the broker heap. Must not be
+ * called from an ISR for a subscriber with a subscription set either, as the set is modified under
+ * its mutex. Otherwise only the subscriber's subscriptions bit array is updated, atomically, and it
+ * can be called from an ISR.
+ *
  * @param subscriber Address of the subscriber
  * @param msg_id The message id to subscribe to
+ *
+ * @retval 0 Subscribed successfully
+ * @retval -ENOMEM The subscriber's subscription set is full, see CONFIG_PUB_SUB_SUBS_SETS
  */
-static inline void pub_sub_subscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id)
-{
-	__ASSERT(subscriber != NULL, "");
-	__ASSERT(subscriber->subs_bitarray != NULL, "");
-	__ASSERT(msg_id <= subscriber->max_pub_msg_id, "");
-	atomic_set_bit(subscriber->subs_bitarray, msg_id);
-}
+int pub_sub_subscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id);
 
 /**
  * @brief Unsubscribe from a message id
  *
  * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING or a subscription
+ * set, see pub_sub_subscribe.
+ * @warning
  * There is a chance that a subscriber could still receive a message after unsubscribing from it if
  * the message is already in the subscriber's message queue
  *
  * @param subscriber Address of the subscriber
  * @param msg_id The message id to unsubscribe from
+ *
+ * @retval 0 Unsubscribed successfully
+ * @retval -ENOMEM The subscriber's subscription set is a full range list and unsubscribing would
+ * split a range, see CONFIG_PUB_SUB_SUBS_SETS
  */
-static inline void pub_sub_unsubscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id)
-{
-	__ASSERT(subscriber != NULL, "");
-	__ASSERT(subscriber->subs_bitarray != NULL, "");
-	__ASSERT(msg_id <= subscriber->max_pub_msg_id, "");
-	atomic_clear_bit(subscriber->subs_bitarray, msg_id);
-}
+int pub_sub_unsubscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id);
+
+/**
+ * @brief Subscribe to a range of message ids
+ *
+ * The subscriptions bit array is updated a whole word at a time which is much faster than
+ * subscribing to each message id in the range individually.
+ *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING or a subscription
+ * set, see pub_sub_subscribe.
+ *
+ * @param subscriber Address of the subscriber
+ * @param first_msg_id The first message id of the range to subscribe to
+ * @param last_msg_id The last message id of the range to subscribe to, inclusive
+ *
+ * @retval 0 Subscribed successfully
+ * @retval -ENOMEM The subscriber's subscription set does not have space for the range, none of it
+ * is subscribed to, see CONFIG_PUB_SUB_SUBS_SETS
+ */
+int pub_sub_subscribe_range(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+			    uint16_t last_msg_id);
+
+/**
+ * @brief Unsubscribe from a range of message ids
+ *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING or a subscription
+ * set, see pub_sub_subscribe.
+ * @warning
+ * There is a chance that a subscriber could still receive a message after unsubscribing from it if
+ * the message is already in the subscriber's message queue
+ *
+ * @param subscriber Address of the subscriber
+ * @param first_msg_id The first message id of the range to unsubscribe from
+ * @param last_msg_id The last message id of the range to unsubscribe from, inclusive
+ *
+ * @retval 0 Unsubscribed successfully
+ * @retval -ENOMEM The subscriber's subscription set is a full range list and unsubscribing would
+ * split a range, see CONFIG_PUB_SUB_SUBS_SETS
+ */
+int pub_sub_unsubscribe_range(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+			      uint16_t last_msg_id);
+
+/**
+ * @brief Subscribe to every message id that is set in a bitmap
+ *
+ * The bitmap has the same layout as a subscriptions bit array, bit 'n' is message id 'n'. It is
+ * merged into the subscriber's existing subscriptions a whole word at a time.
+ *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING or a subscription
+ * set, see pub_sub_subscribe.
+ *
+ * @param subscriber Address of the subscriber
+ * @param bitmap Address of the bitmap of message ids to subscribe to
+ * @param max_msg_id The maximum message id in the bitmap, must not be greater than the subscriber's
+ * maximum public message id
+ *
+ * @retval 0 Subscribed successfully
+ * @retval -ENOMEM The subscriber's subscription set filled part way through the bitmap, each run
+ * of consecutive message ids is either fully subscribed to or not at all, see
+ * CONFIG_PUB_SUB_SUBS_SETS
+ */
+int pub_sub_subscribe_bitmap(struct pub_sub_subscriber *subscriber, const atomic_t *bitmap,
+			     uint16_t max_msg_id);
+
+/**
+ * @brief Define a constant subscriptions template
+ *
+ * A template is a subscriptions bit array that can be placed in ROM and copied into a subscriber
+ * with pub_sub_subscribe_from_template.
+ *
+ * @param name The name of the created template
+ * @param max_msg_id The maximum public message id of the subscribers that will use the template
+ */
+#define PUB_SUB_SUBS_TEMPLATE_DEFINE(name, max_msg_id)                                             \
+	const PUB_SUB_SUBS_BITARRAY_DEFINE(name, max_msg_id)
+
+/**
+ * @brief Initialize a subscriber's subscriptions from a template
+ *
+ * Replaces all of the subscriber's subscriptions with a single copy of the template, it is intended
+ * for subscribers with many fixed subscriptions that are set up at initialization.
+ *
+ * @warning
+ * Must be called before the subscriber is added to a broker. Only subscribers that track their
+ * subscriptions in a bit array can use a template.
+ *
+ * @param subscriber Address of the subscriber
+ * @param subs_template Address of a template defined with PUB_SUB_SUBS_TEMPLATE_DEFINE using the
+ * subscriber's maximum public message id
+ */
+void pub_sub_subscribe_from_template(struct pub_sub_subscriber *subscriber,
+				     const atomic_t *subs_template);
+
+#ifdef CONFIG_PUB_SUB_TOPICS
+/**
+ * @brief Subscribe to every message id in a topic namespace
+ *
+ * A prefix subscription is stored as a single bit per namespace, independent of the number of
+ * message ids in the namespace. Message ids in the namespace that are greater than the subscriber's
+ * maximum public message id are not received.
+ *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING, see
+ * pub_sub_subscribe.
+ *
+ * @param subscriber Address of the subscriber
+ * @param msg_id Any message id within the namespace, see PUB_SUB_TOPIC_MSG_ID
+ * @param num_levels The number of namespace levels of 'msg_id' to match, 1 matches the level 1
+ * namespace and 2 matches the level 1 and level 2 namespaces
+ */
+void pub_sub_subscribe_prefix(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+			      uint8_t num_levels);
+
+/**
+ * @brief Unsubscribe from a topic namespace
+ *
+ * Only removes the prefix subscription, message ids in the namespace that were subscribed to
+ * individually or by a prefix with a different number of levels are still received.
+ *
+ * @warning
+ * Must not be called from an ISR with CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING, see
+ * pub_sub_subscribe.
+ * @warning
+ * There is a chance that a subscriber could still receive a message after unsubscribing from it if
+ * the message is already in the subscriber's message queue
+ *
+ * @param subscriber Address of the subscriber
+ * @param msg_id Any message id within the namespace, see PUB_SUB_TOPIC_MSG_ID
+ * @param num_levels The number of namespace levels the prefix subscription matched
+ */
+void pub_sub_unsubscribe_prefix(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+				uint8_t num_levels);
+#endif // CONFIG_PUB_SUB_TOPICS
 
 /**
  * @brief Set a subscriber's message handler function and data
@@ -189,6 +491,164 @@ static inline void pub_sub_subscriber_set_priority(struct pub_sub_subscriber *su
 	subscriber->priority = priority;
 }
 
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+/**
+ * @brief Track a subscriber's subscriptions in a compact subscription set
+ *
+ * A subscription set only uses memory for the message ids that are subscribed to, instead of a bit
+ * for every message id up to the subscriber's maximum public message id. A subscriber that uses a
+ * subscription set can be initialized with a NULL subscriptions bit array.
+ *
+ * @warning
+ * Must be called before the subscriber subscribes to any message ids or is added to a broker.
+ *
+ * @param subscriber Address of the subscriber
+ * @param subs_set Address of the initialized subscription set
+ */
+static inline void pub_sub_subscriber_set_subs_set(struct pub_sub_subscriber *subscriber,
+						   struct pub_sub_subs_set *subs_set)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(subs_set != NULL, "");
+	__ASSERT(subscriber->broker == NULL, "");
+	subscriber->subs_set = subs_set;
+}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+/**
+ * @brief Add a content filter for every message id to a subscriber
+ *
+ * The broker calls the filter function with each message the subscriber is subscribed to before
+ * acquiring a reference to it or queuing it. The subscriber only receives the message if the
+ * function returns true, so messages the subscriber would discard never wake it up or take up
+ * space in its queue. The filter function receives the same read only message as the subscriber's
+ * handler function and must not block.
+ *
+ * @warning
+ * Must be called before the subscriber is added to a broker.
+ *
+ * @param subscriber Address of the subscriber
+ * @param filter Address of the filter, it must remain valid while the subscriber is in use
+ * @param filter_fn The filter function
+ * @param user_data Passed to the filter function
+ */
+void pub_sub_subscriber_add_filter(struct pub_sub_subscriber *subscriber,
+				   struct pub_sub_filter *filter, pub_sub_filter_fn filter_fn,
+				   void *user_data);
+
+/**
+ * @brief Add a content filter for a single message id to a subscriber
+ *
+ * The same as pub_sub_subscriber_add_filter except that the filter is only run for messages with
+ * the id 'msg_id'. A message must be accepted by every filter that applies to it.
+ *
+ * @warning
+ * Must be called before the subscriber is added to a broker.
+ *
+ * @param subscriber Address of the subscriber
+ * @param filter Address of the filter, it must remain valid while the subscriber is in use
+ * @param msg_id The message id the filter applies to
+ * @param filter_fn The filter function
+ * @param user_data Passed to the filter function
+ */
+void pub_sub_subscriber_add_msg_filter(struct pub_sub_subscriber *subscriber,
+				       struct pub_sub_filter *filter, uint16_t msg_id,
+				       pub_sub_filter_fn filter_fn, void *user_data);
+
+/**
+ * @brief Get the number of messages a filter has accepted
+ *
+ * @param filter Address of the filter
+ *
+ * @retval The number of accepted messages
+ */
+static inline atomic_val_t pub_sub_filter_hits(struct pub_sub_filter *filter)
+{
+	__ASSERT(filter != NULL, "");
+	return atomic_get(&filter->hits);
+}
+
+/**
+ * @brief Get the number of messages a filter has rejected
+ *
+ * @param filter Address of the filter
+ *
+ * @retval The number of rejected messages
+ */
+static inline atomic_val_t pub_sub_filter_misses(struct pub_sub_filter *filter)
+{
+	__ASSERT(filter != NULL, "");
+	return atomic_get(&filter->misses);
+}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+/**
+ * @brief Set what happens when a message is sent to a msgq subscriber with a full message queue
+ *
+ * By default the broker waits for space in the message queue which stalls the delivery of
+ * published messages to every subscriber. Dropping a message releases the reference the
+ * subscriber would have received.
+ *
+ * @param subscriber Address of the msgq subscriber
+ * @param policy The overflow policy
+ * @param drop_level With PUB_SUB_MSGQ_OVERFLOW_DROP_ABOVE_LEVEL messages with an id greater than
+ * this are dropped, it is ignored by the other policies
+ */
+static inline void
+pub_sub_subscriber_set_msgq_overflow_policy(struct pub_sub_subscriber *subscriber,
+					    enum pub_sub_msgq_overflow_policy policy,
+					    uint16_t drop_level)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(subscriber->rx_type == PUB_SUB_RX_TYPE_MSGQ, "");
+	subscriber->msgq_drop_level = drop_level;
+	subscriber->msgq_overflow_policy = policy;
+}
+
+/**
+ * @brief Get the number of messages a msgq subscriber has dropped because its queue was full
+ *
+ * @param subscriber Address of the msgq subscriber
+ *
+ * @retval The number of dropped messages
+ */
+static inline atomic_val_t pub_sub_subscriber_msgq_dropped(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	return atomic_get(&subscriber->msgq_dropped);
+}
+
+/**
+ * @brief Get the number of times sending to a msgq subscriber had to wait for space in its queue
+ *
+ * @param subscriber Address of the msgq subscriber
+ *
+ * @retval The number of messages that had to wait
+ */
+static inline atomic_val_t pub_sub_subscriber_msgq_blocked(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	return atomic_get(&subscriber->msgq_blocked);
+}
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+/**
+ * @brief Get the number of messages a fifo subscriber has dropped because no envelope was free
+ *
+ * @param subscriber Address of the fifo subscriber
+ *
+ * @retval The number of dropped messages
+ */
+static inline atomic_val_t pub_sub_subscriber_fifo_dropped(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	return atomic_get(&subscriber->fifo_dropped);
+}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
 /**
  * @brief Handle a message for a subscriber
  *
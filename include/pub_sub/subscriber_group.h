@@ -0,0 +1,107 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_SUBSCRIBER_GROUP_H_
+#define PUB_SUB_SUBSCRIBER_GROUP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pub_sub/subscriber.h>
+
+// How a subscriber group chooses the member that receives a message
+enum pub_sub_group_policy {
+	// Each message goes to the next member in turn
+	PUB_SUB_GROUP_ROUND_ROBIN,
+	// Each message goes to the member with the fewest queued messages
+	PUB_SUB_GROUP_LEAST_QUEUED,
+	// Messages go to a member chosen by a hash of a key, messages with the same key always go
+	// to the same member so they are handled in order
+	PUB_SUB_GROUP_KEY_HASH,
+};
+
+/**
+ * @brief Returns the key used to choose the member that receives a message
+ *
+ * Called by the broker so it must not block.
+ *
+ * @param msg_id The message id of the message
+ * @param msg The read only message
+ * @param user_data The user data the key function was set with
+ */
+typedef uint32_t (*pub_sub_group_key_fn)(uint16_t msg_id, const void *msg, void *user_data);
+
+// A group of msgq or fifo subscribers that a broker treats as a single subscriber, each message the
+// group is subscribed to is sent to exactly one of its members
+struct pub_sub_subscriber_group {
+	// The subscriber that is added to a broker and holds the group's subscriptions
+	struct pub_sub_subscriber subscriber;
+	struct pub_sub_subscriber *const *members;
+	uint16_t num_members;
+	enum pub_sub_group_policy policy;
+	pub_sub_group_key_fn key_fn;
+	void *key_user_data;
+	atomic_t next_member;
+};
+
+/**
+ * @brief Internal implementation, only exposed for the broker
+ *
+ * Queues a message on one of a group's members, passing the ownership of the message's reference
+ * to the member.
+ */
+void pub_sub_subscriber_group_put(struct pub_sub_subscriber *subscriber, void *msg);
+
+/**
+ * @brief Initialize a subscriber group
+ *
+ * The group's subscriber, 'group->subscriber', is used to subscribe the group to message ids and
+ * to add it to a broker in the same way as any other subscriber. It does not have a handler
+ * function or a queue of its own, each message is queued on one of the members.
+ *
+ * The members must be initialized msgq subscribers, or with CONFIG_PUB_SUB_FIFO_FANOUT fifo
+ * subscribers, with their handler functions set. They must not be added to a broker and their own
+ * subscriptions are not used. Each member is expected to be serviced by a different thread with
+ * pub_sub_handle_queued_msg.
+ *
+ * @param group Address of the subscriber group
+ * @param subs_bitarray The subscriptions bit array to use to track the group's subscriptions
+ * @param max_pub_msg_id The maximum message id that will be subscribed to
+ * @param members Array of the addresses of the members, it must remain valid while the group is
+ * in use
+ * @param num_members The number of members
+ * @param policy How the member that receives each message is chosen
+ */
+void pub_sub_init_subscriber_group(struct pub_sub_subscriber_group *group, atomic_t *subs_bitarray,
+				   uint16_t max_pub_msg_id,
+				   struct pub_sub_subscriber *const *members, uint16_t num_members,
+				   enum pub_sub_group_policy policy);
+
+/**
+ * @brief Set the function that returns the key of a message for PUB_SUB_GROUP_KEY_HASH
+ *
+ * Without a key function the message id is used as the key.
+ *
+ * @warning
+ * Must be called before the group is added to a broker.
+ *
+ * @param group Address of the subscriber group
+ * @param key_fn The key function
+ * @param user_data Passed to the key function
+ */
+static inline void pub_sub_subscriber_group_set_key_fn(struct pub_sub_subscriber_group *group,
+						       pub_sub_group_key_fn key_fn, void *user_data)
+{
+	__ASSERT(group != NULL, "");
+	__ASSERT(key_fn != NULL, "");
+	__ASSERT(group->subscriber.broker == NULL, "");
+	group->key_fn = key_fn;
+	group->key_user_data = user_data;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_SUBSCRIBER_GROUP_H_ */
\ No newline at end of file
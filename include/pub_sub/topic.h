@@ -0,0 +1,80 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PUB_SUB_TOPIC_H_
+#define PUB_SUB_TOPIC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <zephyr/kernel.h>
+
+// Message ids are split into a level 1 namespace in the most significant bits, an optional level 2
+// namespace in the following bits and the topic's id within its namespace in the remaining bits
+#define PUB_SUB_TOPIC_MAX_LEVELS ((CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS > 0) ? 2 : 1)
+
+BUILD_ASSERT(CONFIG_PUB_SUB_TOPIC_LEVEL_1_BITS + CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS <= 12,
+	     "Topic namespaces must leave at least 4 bits of the message id");
+
+/**
+ * @brief The number of message id bits in a namespace prefix
+ *
+ * @param num_levels The number of namespace levels in the prefix, 1 or 2
+ */
+#define PUB_SUB_TOPIC_PREFIX_BITS(num_levels)                                                      \
+	(CONFIG_PUB_SUB_TOPIC_LEVEL_1_BITS +                                                       \
+	 (((num_levels) > 1) ? CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS : 0))
+
+#define PUB_SUB_TOPIC_PREFIX_SHIFT(num_levels) (16 - PUB_SUB_TOPIC_PREFIX_BITS(num_levels))
+
+/**
+ * @brief The number of distinct namespace prefixes with a number of levels
+ *
+ * @param num_levels The number of namespace levels in the prefix, 1 or 2
+ */
+#define PUB_SUB_TOPIC_NUM_PREFIXES(num_levels) BIT(PUB_SUB_TOPIC_PREFIX_BITS(num_levels))
+
+/**
+ * @brief Get the namespace prefix of a message id
+ *
+ * @param msg_id The message id
+ * @param num_levels The number of namespace levels in the prefix, 1 or 2
+ */
+#define PUB_SUB_TOPIC_PREFIX(msg_id, num_levels)                                                   \
+	((uint16_t)(msg_id) >> PUB_SUB_TOPIC_PREFIX_SHIFT(num_levels))
+
+/**
+ * @brief Get the first message id with a namespace prefix
+ *
+ * @param prefix The namespace prefix
+ * @param num_levels The number of namespace levels in the prefix, 1 or 2
+ */
+#define PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(prefix, num_levels)                                      \
+	((uint16_t)((prefix) << PUB_SUB_TOPIC_PREFIX_SHIFT(num_levels)))
+
+/**
+ * @brief Get the last message id with a namespace prefix
+ *
+ * @param prefix The namespace prefix
+ * @param num_levels The number of namespace levels in the prefix, 1 or 2
+ */
+#define PUB_SUB_TOPIC_PREFIX_LAST_MSG_ID(prefix, num_levels)                                       \
+	((uint16_t)(PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(prefix, num_levels) +                        \
+		    BIT(PUB_SUB_TOPIC_PREFIX_SHIFT(num_levels)) - 1))
+
+/**
+ * @brief Build a message id from its namespaces
+ *
+ * @param level_1 The level 1 namespace
+ * @param level_2 The level 2 namespace, must be 0 if CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS is 0
+ * @param topic The topic's id within its namespace
+ */
+#define PUB_SUB_TOPIC_MSG_ID(level_1, level_2, topic)                                              \
+	((uint16_t)(((level_1) << PUB_SUB_TOPIC_PREFIX_SHIFT(1)) |                                 \
+		    ((level_2) << PUB_SUB_TOPIC_PREFIX_SHIFT(2)) | (topic)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SUB_TOPIC_H_ */
\ No newline at end of file
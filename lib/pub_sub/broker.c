@@ -3,39 +3,881 @@
  */
 #include <pub_sub/pub_sub.h>
 #include <zephyr/init.h>
+#include <string.h>
+#ifdef CONFIG_PUB_SUB_LAZY_MSG
+#include <pub_sub/lazy_msg.h>
+#endif // CONFIG_PUB_SUB_LAZY_MSG
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+#include <pub_sub/subscriber_group.h>
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+static void broker_thread_fn(void *p1, void *p2, void *p3);
+static void set_thread_cpu_mask(k_tid_t tid, uint32_t cpu_mask);
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+static void shard_thread_fn(void *p1, void *p2, void *p3);
+static uint32_t shard_cpu_mask(uint32_t cpu_mask, uint8_t shard);
+static void publish_list_to_shards(struct pub_sub_broker *broker, sys_slist_t *list);
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+#else
 static void publish_work_handler(struct k_work *work);
-static void process_msg(struct pub_sub_broker *broker, uint16_t msg_id, void *msg);
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+// A thread routing messages for a broker, see enter_routing
+struct routing_thread {
+	sys_snode_t node;
+	k_tid_t tid;
+};
+
+static void common_broker_init(struct pub_sub_broker *broker);
+#if !defined(CONFIG_PUB_SUB_BROKER_THREAD) || defined(CONFIG_PUB_SUB_PUBLISH_LANES)
+static void init_publish_poll_events(struct pub_sub_broker *broker);
+static void dispatch_published_msgs(struct pub_sub_broker *broker);
+#endif
+static void *get_published_msg(struct pub_sub_broker *broker);
+static void *get_normal_lane_msg(struct pub_sub_broker *broker, k_timeout_t timeout);
+static size_t get_published_msgs(struct pub_sub_broker *broker, void **msgs, size_t max_msgs);
+static void process_msgs(struct pub_sub_broker *broker, void *const *msgs, size_t num_msgs);
+static void enter_routing(struct pub_sub_broker *broker, struct routing_thread *routing_thread);
+static void exit_routing(struct pub_sub_broker *broker, struct routing_thread *routing_thread);
+static bool is_routing_thread(struct pub_sub_broker *broker);
+static void route_msg(struct pub_sub_broker *broker, uint16_t msg_id, void *msg);
+#ifdef CONFIG_PUB_SUB_LAZY_MSG
+static void route_lazy_msg(struct pub_sub_broker *broker, void *lazy_msg);
+#endif // CONFIG_PUB_SUB_LAZY_MSG
+static bool has_subscribers(struct pub_sub_broker *broker, uint16_t msg_id);
+static bool send_to_subscriber(struct pub_sub_subscriber *sub, uint16_t msg_id, void *msg,
+			       bool fifo_sub_handled);
+static const struct pub_sub_sub_array *get_sub_array(struct pub_sub_broker *broker,
+						      uint16_t msg_id);
+static uint16_t find_subscriber(const struct pub_sub_sub_array *sub_array,
+				const struct pub_sub_subscriber *subscriber);
+static int update_sub_array(struct pub_sub_broker *broker);
+static void replace_sub_array(struct pub_sub_broker *broker, atomic_ptr_t *slot,
+			      struct pub_sub_sub_array *sub_array);
+static void insert_subscriber(struct pub_sub_broker *broker, struct pub_sub_subscriber *subscriber);
+static void reclaim_sub_arrays(struct pub_sub_broker *broker);
+static void synchronize_readers(struct pub_sub_broker *broker);
+static void wait_for_readers(struct pub_sub_broker *broker);
+static void free_sub_arrays(sys_slist_t *list);
+static void try_reclaim_sub_arrays(struct pub_sub_broker *broker);
+#ifdef CONFIG_PUB_SUB_MSG_RING
+static void put_on_msg_ring(struct pub_sub_broker *broker, void *msg);
+static void put_list_on_msg_ring(struct pub_sub_broker *broker, sys_slist_t *list);
+#endif // CONFIG_PUB_SUB_MSG_RING
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+static void add_lane_depth(struct pub_sub_broker *broker, enum pub_sub_publish_lane lane,
+			   atomic_val_t num_msgs);
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+static void update_subscriber_subscriptions(struct pub_sub_broker *broker,
+					    struct pub_sub_subscriber *subscriber);
+static void update_subscription(struct pub_sub_broker *broker, uint16_t msg_id);
+static uint16_t max_tracked_msg_id(void);
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+static void update_summary(struct pub_sub_broker *broker, uint16_t msg_id);
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+static void rebuild_route(struct pub_sub_broker *broker, uint16_t msg_id);
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_TOPICS
+static void rebuild_topic_route(struct pub_sub_broker *broker, uint16_t prefix);
+static bool in_topic_namespace(const struct pub_sub_subscriber *sub, uint16_t prefix);
+#endif // CONFIG_PUB_SUB_TOPICS
+#if defined(CONFIG_PUB_SUB_ROUTING_INDEX) || defined(CONFIG_PUB_SUB_TOPICS)
+static void build_route(struct pub_sub_broker *broker, atomic_ptr_t *slot,
+			bool (*includes)(const struct pub_sub_subscriber *sub, uint16_t key),
+			uint16_t key);
+
+// Used in place of a route when there was no space on the heap to allocate it. Messages with an
+// unindexed route are routed by checking the subscriptions of every subscriber on the broker.
+static struct pub_sub_sub_array unindexed_route;
+#endif
+
+// Readers treat a NULL subscriber array as an empty one
+static const struct pub_sub_sub_array empty_sub_array;
+
+K_HEAP_DEFINE(pub_sub_broker_heap, CONFIG_PUB_SUB_BROKER_HEAP_SIZE);
+
+static inline bool is_subscribed(const struct pub_sub_subscriber *sub, uint16_t msg_id)
+{
+	if (msg_id > sub->max_pub_msg_id) {
+		return false;
+	}
+#ifdef CONFIG_PUB_SUB_TOPICS
+	if (atomic_test_bit(sub->topic_prefixes_1, PUB_SUB_TOPIC_PREFIX(msg_id, 1)) ||
+	    ((PUB_SUB_TOPIC_MAX_LEVELS > 1) &&
+	     atomic_test_bit(sub->topic_prefixes_2, PUB_SUB_TOPIC_PREFIX(msg_id, 2)))) {
+		return true;
+	}
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	if (sub->subs_set != NULL) {
+		return pub_sub_subs_set_contains(sub->subs_set, msg_id);
+	}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+	return atomic_test_bit(sub->subs_bitarray, msg_id);
+}
+
+// Returns true if the message should be sent to the subscriber
+static inline bool wants_msg(struct pub_sub_broker *broker, struct pub_sub_subscriber *sub,
+			     uint16_t msg_id, const void *msg)
+{
+	// A subscriber removed from within a handler function can still be in the array being read
+	if ((sub->broker != broker) || !is_subscribed(sub, msg_id)) {
+		return false;
+	}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+	return pub_sub_subscriber_filter_msg(sub, msg_id, msg);
+#else
+	ARG_UNUSED(msg);
+	return true;
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+}
+
+#ifdef CONFIG_PUB_SUB_MSG_RING
+void pub_sub_broker_set_msg_ring(struct pub_sub_broker *broker, struct pub_sub_msg_ring *ring)
+{
+	__ASSERT(broker != NULL, "");
+	broker->msg_publish_ring = ring;
+}
+#endif // CONFIG_PUB_SUB_MSG_RING
 
 void pub_sub_init_broker(struct pub_sub_broker *broker)
+{
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD_CPU_MASK
+	uint32_t cpu_mask = CONFIG_PUB_SUB_BROKER_THREAD_CPU_MASK;
+#else
+	uint32_t cpu_mask = 0;
+#endif // CONFIG_PUB_SUB_BROKER_THREAD_CPU_MASK
+	pub_sub_init_broker_thread(broker, CONFIG_PUB_SUB_BROKER_THREAD_PRIORITY, cpu_mask);
+#else
+	pub_sub_init_broker_on_work_q(broker, &k_sys_work_q);
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+void pub_sub_init_broker_thread(struct pub_sub_broker *broker, int priority, uint32_t cpu_mask)
 {
 	__ASSERT(broker != NULL, "");
-	k_fifo_init(&broker->msg_publish_fifo);
+	common_broker_init(broker);
+	k_tid_t tid = k_thread_create(&broker->thread, broker->thread_stack,
+				      K_KERNEL_STACK_SIZEOF(broker->thread_stack), broker_thread_fn,
+				      broker, NULL, NULL, priority, 0, K_FOREVER);
+	k_thread_name_set(tid, "pub_sub_broker");
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	set_thread_cpu_mask(tid, shard_cpu_mask(cpu_mask, 0));
+	for (uint8_t i = 0; i < ARRAY_SIZE(broker->shards); i++) {
+		struct pub_sub_broker_shard *shard = &broker->shards[i];
+		k_tid_t shard_tid = k_thread_create(
+			&shard->thread, shard->thread_stack,
+			K_KERNEL_STACK_SIZEOF(shard->thread_stack), shard_thread_fn, broker, shard,
+			NULL, priority, 0, K_FOREVER);
+		k_thread_name_set(shard_tid, "pub_sub_shard");
+		set_thread_cpu_mask(shard_tid, shard_cpu_mask(cpu_mask, i + 1));
+		k_thread_start(shard_tid);
+	}
+#else
+	set_thread_cpu_mask(tid, cpu_mask);
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+	k_thread_start(tid);
+}
+#else
+void pub_sub_init_broker_on_work_q(struct pub_sub_broker *broker, struct k_work_q *work_q)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(work_q != NULL, "");
+	common_broker_init(broker);
+	broker->work_q = work_q;
 	k_work_poll_init(&broker->publish_work, publish_work_handler);
-	k_mutex_init(&broker->sub_list_mutex);
-	sys_slist_init(&broker->subscribers);
-	k_poll_event_init(&broker->publish_work_poll_event, K_POLL_TYPE_FIFO_DATA_AVAILABLE,
-			  K_POLL_MODE_NOTIFY_ONLY, &broker->msg_publish_fifo);
-	k_work_poll_submit(&broker->publish_work, &broker->publish_work_poll_event, 1, K_FOREVER);
+	k_work_poll_submit_to_queue(broker->work_q, &broker->publish_work,
+				    broker->publish_poll_events,
+				    ARRAY_SIZE(broker->publish_poll_events), K_FOREVER);
 }
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
 
-void pub_sub_add_subscriber_to_broker(struct pub_sub_broker *broker,
-				      struct pub_sub_subscriber *subscriber)
+int pub_sub_add_subscriber_to_broker(struct pub_sub_broker *broker,
+				     struct pub_sub_subscriber *subscriber)
 {
 	__ASSERT(broker != NULL, "");
 	__ASSERT(subscriber != NULL, "");
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	// A group's messages are handled by its members
+	__ASSERT((subscriber->handler_data.msg_handler != NULL) ||
+			 (subscriber->rx_type == PUB_SUB_RX_TYPE_GROUP),
+		 "");
+#else
 	__ASSERT(subscriber->handler_data.msg_handler != NULL, "");
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 	__ASSERT(subscriber->broker == NULL, "");
-	sys_snode_t *prev_node = NULL;
-	struct pub_sub_subscriber *current = NULL;
 	subscriber->broker = broker;
-	// Subscribers get sorted by type first: callbacks, msgq and then fifo.
-	// Then they are sorted by priority value for each type
 	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
-	// Search for the start of our rx_type
+	insert_subscriber(broker, subscriber);
+	int ret = update_sub_array(broker);
+	// Waiting for the readers frees all of the retired subscriber arrays so try again, unless
+	// called from within the broker's own read side critical section
+	if ((ret != 0) && !is_routing_thread(broker)) {
+		// The mutex is released while waiting so the subscriber is taken out of the list
+		// until it can be added to the broker's subscriber array
+		sys_slist_find_and_remove(&broker->subscribers, &subscriber->sub_list_node);
+		synchronize_readers(broker);
+		insert_subscriber(broker, subscriber);
+		ret = update_sub_array(broker);
+	}
+	if (ret == 0) {
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+		update_subscriber_subscriptions(broker, subscriber);
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+	} else {
+		sys_slist_find_and_remove(&broker->subscribers, &subscriber->sub_list_node);
+		subscriber->broker = NULL;
+	}
+	reclaim_sub_arrays(broker);
+	k_mutex_unlock(&broker->sub_list_mutex);
+	return ret;
+}
+
+int pub_sub_subscriber_remove_broker(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(subscriber->broker != NULL, "");
+	struct pub_sub_broker *broker = subscriber->broker;
+	// Waiting for the readers to finish from within a read side critical section would wait
+	// forever for itself
+	bool routing = is_routing_thread(broker);
+	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
+	sys_slist_find_and_remove(&broker->subscribers, &subscriber->sub_list_node);
+	int ret = update_sub_array(broker);
+	if ((ret != 0) && !routing) {
+		// Waiting for the readers frees all of the retired subscriber arrays so try again.
+		// The heap is shared with the other brokers so it can still be full.
+		synchronize_readers(broker);
+		ret = update_sub_array(broker);
+	}
+	if (ret != 0) {
+		// The published subscriber array still references the subscriber so it has to stay
+		// on the broker
+		insert_subscriber(broker, subscriber);
+		reclaim_sub_arrays(broker);
+		k_mutex_unlock(&broker->sub_list_mutex);
+		return ret;
+	}
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+	update_subscriber_subscriptions(broker, subscriber);
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+	// Readers could still be using the old subscriber arrays, once they have finished the
+	// subscriber is no longer referenced by the broker and can be re-used. When routing the old
+	// arrays are freed once the broker has finished instead.
+	subscriber->broker = NULL;
+	if (routing) {
+		reclaim_sub_arrays(broker);
+	} else {
+		synchronize_readers(broker);
+	}
+	k_mutex_unlock(&broker->sub_list_mutex);
+	return 0;
+}
+
+void pub_sub_publish_batch_to_broker(struct pub_sub_broker *broker, void *const *msgs,
+				     size_t num_msgs)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(msgs != NULL, "");
+	sys_slist_t list;
+	sys_slist_init(&list);
+	for (size_t i = 0; i < num_msgs; i++) {
+		pub_sub_msg_list_append(&list, msgs[i]);
+	}
+	pub_sub_publish_list_to_broker(broker, &list);
+}
+
+void pub_sub_publish_list_to_broker(struct pub_sub_broker *broker, sys_slist_t *list)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(list != NULL, "");
+	if (sys_slist_is_empty(list)) {
+		return;
+	}
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	add_lane_depth(broker, PUB_SUB_PUBLISH_LANE_NORMAL, sys_slist_len(list));
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+#ifdef CONFIG_PUB_SUB_MSG_RING
+	if (broker->msg_publish_ring != NULL) {
+		put_list_on_msg_ring(broker, list);
+		return;
+	}
+#endif // CONFIG_PUB_SUB_MSG_RING
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	publish_list_to_shards(broker, list);
+#else
+	k_fifo_put_slist(&broker->msg_publish_fifo, list);
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+}
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+void pub_sub_publish_to_broker_prio(struct pub_sub_broker *broker, void *msg,
+				    enum pub_sub_publish_lane lane)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(msg != NULL, "");
+	__ASSERT(lane < PUB_SUB_PUBLISH_NUM_LANES, "");
+	// The depth is increased before the message is queued so that it can't go negative when the
+	// broker dequeues the message
+	add_lane_depth(broker, lane, 1);
+	switch (lane) {
+	case PUB_SUB_PUBLISH_LANE_URGENT:
+		pub_sub_msg_fifo_put(&broker->msg_urgent_fifo, msg);
+		break;
+	case PUB_SUB_PUBLISH_LANE_BULK:
+		pub_sub_msg_fifo_put(&broker->msg_bulk_fifo, msg);
+		break;
+	default:
+#ifdef CONFIG_PUB_SUB_MSG_RING
+		if (broker->msg_publish_ring != NULL) {
+			put_on_msg_ring(broker, msg);
+			break;
+		}
+#endif // CONFIG_PUB_SUB_MSG_RING
+		pub_sub_msg_fifo_put(&broker->msg_publish_fifo, msg);
+		break;
+	}
+}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
+bool pub_sub_broker_has_subscribers(struct pub_sub_broker *broker, uint16_t msg_id)
+{
+	__ASSERT(broker != NULL, "");
+	uint8_t read_key = pub_sub_broker_read_lock(broker);
+	bool ret = has_subscribers(broker, msg_id);
+	pub_sub_broker_read_unlock(broker, read_key);
+	return ret;
+}
+
+void pub_sub_publish_direct_to_broker(struct pub_sub_broker *broker, void *msg)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(msg != NULL, "");
+	__ASSERT(!k_is_in_isr(), "");
+	process_msgs(broker, &msg, 1);
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+static void broker_thread_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+	struct pub_sub_broker *broker = p1;
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	// Each lane has its own queue so the thread has to poll all of them
+	for (;;) {
+		(void)k_poll(broker->publish_poll_events, ARRAY_SIZE(broker->publish_poll_events),
+			     K_FOREVER);
+		dispatch_published_msgs(broker);
+	}
+#else
+	void *msgs[CONFIG_PUB_SUB_BROKER_DISPATCH_BATCH_SIZE];
+
+	for (;;) {
+		msgs[0] = get_normal_lane_msg(broker, K_FOREVER);
+		size_t num_msgs = 1 + get_published_msgs(broker, &msgs[1], ARRAY_SIZE(msgs) - 1);
+		process_msgs(broker, msgs, num_msgs);
+	}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+}
+
+static void set_thread_cpu_mask(k_tid_t tid, uint32_t cpu_mask)
+{
+#ifdef CONFIG_SCHED_CPU_MASK
+	if (cpu_mask != 0) {
+		k_thread_cpu_mask_clear(tid);
+		for (int cpu = 0; cpu < CONFIG_MP_MAX_NUM_CPUS; cpu++) {
+			if ((cpu_mask & BIT(cpu)) != 0) {
+				k_thread_cpu_mask_enable(tid, cpu);
+			}
+		}
+	}
+#else
+	ARG_UNUSED(tid);
+	ARG_UNUSED(cpu_mask);
+#endif // CONFIG_SCHED_CPU_MASK
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+// Shards only have a single publish queue so they block on it directly
+static void shard_thread_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p3);
+	struct pub_sub_broker *broker = p1;
+	struct pub_sub_broker_shard *shard = p2;
+	void *msgs[CONFIG_PUB_SUB_BROKER_DISPATCH_BATCH_SIZE];
+
+	for (;;) {
+		msgs[0] = pub_sub_msg_fifo_get(&shard->msg_publish_fifo, K_FOREVER);
+		size_t num_msgs = 1;
+		while (num_msgs < ARRAY_SIZE(msgs)) {
+			void *msg = pub_sub_msg_fifo_get(&shard->msg_publish_fifo, K_NO_WAIT);
+			if (msg == NULL) {
+				break;
+			}
+			msgs[num_msgs++] = msg;
+		}
+		process_msgs(broker, msgs, num_msgs);
+	}
+}
+
+// Returns the mask of the single CPU a shard's thread is pinned to, shards are assigned to the
+// CPUs in 'cpu_mask', or all of the CPUs if it is 0, in turn
+static uint32_t shard_cpu_mask(uint32_t cpu_mask, uint8_t shard)
+{
+	if (cpu_mask == 0) {
+		cpu_mask = BIT_MASK(CONFIG_MP_MAX_NUM_CPUS);
+	}
+	uint8_t n = shard % POPCOUNT(cpu_mask);
+	for (int cpu = 0; cpu < 32; cpu++) {
+		if ((cpu_mask & BIT(cpu)) != 0) {
+			if (n == 0) {
+				return BIT(cpu);
+			}
+			n--;
+		}
+	}
+	return 0;
+}
+
+// Splits a list of messages into a list per shard, keyed by message id, so each shard is only
+// woken once and the messages keep their relative order within each shard
+static void publish_list_to_shards(struct pub_sub_broker *broker, sys_slist_t *list)
+{
+	sys_slist_t shard_lists[CONFIG_PUB_SUB_BROKER_NUM_SHARDS];
+	for (uint8_t i = 0; i < ARRAY_SIZE(shard_lists); i++) {
+		sys_slist_init(&shard_lists[i]);
+	}
+	void *msg = pub_sub_msg_list_get(list);
+	while (msg != NULL) {
+		uint8_t shard = pub_sub_broker_shard_index(pub_sub_msg_get_msg_id(msg));
+		pub_sub_msg_list_append(&shard_lists[shard], msg);
+		msg = pub_sub_msg_list_get(list);
+	}
+	for (uint8_t i = 0; i < ARRAY_SIZE(shard_lists); i++) {
+		if (!sys_slist_is_empty(&shard_lists[i])) {
+			k_fifo_put_slist(pub_sub_broker_shard_fifo(broker, i), &shard_lists[i]);
+		}
+	}
+}
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+#else
+static void publish_work_handler(struct k_work *work)
+{
+	struct pub_sub_broker *broker = CONTAINER_OF(CONTAINER_OF(work, struct k_work_poll, work),
+						     struct pub_sub_broker, publish_work);
+
+	dispatch_published_msgs(broker);
+	k_work_poll_submit_to_queue(broker->work_q, &broker->publish_work,
+				    broker->publish_poll_events,
+				    ARRAY_SIZE(broker->publish_poll_events), K_FOREVER);
+}
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+
+#if !defined(CONFIG_PUB_SUB_BROKER_THREAD) || defined(CONFIG_PUB_SUB_PUBLISH_LANES)
+static void init_publish_poll_events(struct pub_sub_broker *broker)
+{
+	struct k_poll_event *event = broker->publish_poll_events;
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	k_poll_event_init(event++, K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+			  &broker->msg_urgent_fifo);
+	k_poll_event_init(event++, K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+			  &broker->msg_bulk_fifo);
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+#ifdef CONFIG_PUB_SUB_MSG_RING
+	if (broker->msg_publish_ring != NULL) {
+		k_poll_event_init(event, K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+				  &broker->msg_publish_ring->signal);
+		return;
+	}
+#endif // CONFIG_PUB_SUB_MSG_RING
+	k_poll_event_init(event, K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+			  &broker->msg_publish_fifo);
+}
+
+// Dispatches published messages until all of the publish queues are empty
+static void dispatch_published_msgs(struct pub_sub_broker *broker)
+{
+	void *msgs[CONFIG_PUB_SUB_BROKER_DISPATCH_BATCH_SIZE];
+
+	size_t num_msgs = get_published_msgs(broker, msgs, ARRAY_SIZE(msgs));
+	while (num_msgs > 0) {
+		process_msgs(broker, msgs, num_msgs);
+		num_msgs = get_published_msgs(broker, msgs, ARRAY_SIZE(msgs));
+	}
+	// Any message published after a queue was found to be empty makes its poll event ready
+	// again when the events are next polled
+	for (size_t i = 0; i < ARRAY_SIZE(broker->publish_poll_events); i++) {
+		broker->publish_poll_events[i].state = K_POLL_STATE_NOT_READY;
+	}
+}
+#endif
+
+// Higher priority lanes are always checked first
+static void *get_published_msg(struct pub_sub_broker *broker)
+{
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	void *msg = pub_sub_msg_fifo_get(&broker->msg_urgent_fifo, K_NO_WAIT);
+	enum pub_sub_publish_lane lane = PUB_SUB_PUBLISH_LANE_URGENT;
+	if (msg == NULL) {
+		msg = get_normal_lane_msg(broker, K_NO_WAIT);
+		lane = PUB_SUB_PUBLISH_LANE_NORMAL;
+	}
+	if (msg == NULL) {
+		msg = pub_sub_msg_fifo_get(&broker->msg_bulk_fifo, K_NO_WAIT);
+		lane = PUB_SUB_PUBLISH_LANE_BULK;
+	}
+	if (msg != NULL) {
+		atomic_dec(&broker->lane_depth[lane]);
+	}
+	return msg;
+#else
+	return get_normal_lane_msg(broker, K_NO_WAIT);
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+}
+
+static void *get_normal_lane_msg(struct pub_sub_broker *broker, k_timeout_t timeout)
+{
+#ifdef CONFIG_PUB_SUB_MSG_RING
+	if (broker->msg_publish_ring != NULL) {
+		return pub_sub_msg_ring_get(broker->msg_publish_ring, timeout);
+	}
+#endif // CONFIG_PUB_SUB_MSG_RING
+	return pub_sub_msg_fifo_get(&broker->msg_publish_fifo, timeout);
+}
+
+// Dequeues up to 'max_msgs' published messages without waiting
+static size_t get_published_msgs(struct pub_sub_broker *broker, void **msgs, size_t max_msgs)
+{
+	size_t num_msgs = 0;
+	while (num_msgs < max_msgs) {
+		void *msg = get_published_msg(broker);
+		if (msg == NULL) {
+			break;
+		}
+		msgs[num_msgs++] = msg;
+	}
+	return num_msgs;
+}
+
+static void common_broker_init(struct pub_sub_broker *broker)
+{
+	k_fifo_init(&broker->msg_publish_fifo);
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	for (size_t i = 0; i < ARRAY_SIZE(broker->shards); i++) {
+		k_fifo_init(&broker->shards[i].msg_publish_fifo);
+	}
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	k_fifo_init(&broker->msg_urgent_fifo);
+	k_fifo_init(&broker->msg_bulk_fifo);
+	for (size_t i = 0; i < PUB_SUB_PUBLISH_NUM_LANES; i++) {
+		atomic_set(&broker->lane_depth[i], 0);
+		atomic_set(&broker->lane_peak_depth[i], 0);
+	}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+#if !defined(CONFIG_PUB_SUB_BROKER_THREAD) || defined(CONFIG_PUB_SUB_PUBLISH_LANES)
+	init_publish_poll_events(broker);
+#endif
+	k_mutex_init(&broker->sub_list_mutex);
+	sys_slist_init(&broker->subscribers);
+	atomic_ptr_set(&broker->sub_array, NULL);
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+	memset(broker->routes, 0, sizeof(broker->routes));
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_TOPICS
+	memset(broker->topic_routes, 0, sizeof(broker->topic_routes));
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	memset(broker->subs_summary, 0, sizeof(broker->subs_summary));
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	atomic_set(&broker->read_epoch, 0);
+	for (size_t i = 0; i < ARRAY_SIZE(broker->readers); i++) {
+		atomic_set(&broker->readers[i], 0);
+		atomic_set(&broker->num_waiters[i], 0);
+		k_sem_init(&broker->readers_done[i], 0, 1);
+	}
+	sys_slist_init(&broker->retired);
+	sys_slist_init(&broker->reclaiming);
+	broker->reclaiming_key = 0;
+	atomic_set(&broker->reclaim_pending, 0);
+	broker->num_synchronizing = 0;
+	sys_slist_init(&broker->routing_threads);
+#ifdef CONFIG_PUB_SUB_STATS
+	memset(&broker->stats, 0, sizeof(broker->stats));
+	pub_sub_stats_register_broker(broker);
+#endif // CONFIG_PUB_SUB_STATS
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+void pub_sub_broker_update_subscriptions(struct pub_sub_broker *broker, uint16_t first_msg_id,
+					 uint16_t last_msg_id)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
+	// Only the message ids that are indexed or summarized need updating individually
+	uint16_t last_tracked_msg_id = MIN(last_msg_id, max_tracked_msg_id());
+	for (uint32_t msg_id = first_msg_id; msg_id <= last_tracked_msg_id; msg_id++) {
+		update_subscription(broker, msg_id);
+	}
+#ifdef CONFIG_PUB_SUB_TOPICS
+	for (uint32_t prefix = PUB_SUB_TOPIC_PREFIX(first_msg_id, 1);
+	     prefix <= PUB_SUB_TOPIC_PREFIX(last_msg_id, 1); prefix++) {
+		rebuild_topic_route(broker, prefix);
+	}
+#endif // CONFIG_PUB_SUB_TOPICS
+	reclaim_sub_arrays(broker);
+	k_mutex_unlock(&broker->sub_list_mutex);
+}
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+
+#ifndef CONFIG_PUB_SUB_FIFO_FANOUT
+struct pub_sub_subscriber *pub_sub_broker_next_fifo_subscriber(struct pub_sub_broker *broker,
+							       struct pub_sub_subscriber *subscriber,
+							       uint16_t msg_id, const void *msg)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(subscriber != NULL, "");
+	const struct pub_sub_sub_array *sub_array = get_sub_array(broker, msg_id);
+	uint16_t i = find_subscriber(sub_array, subscriber);
+#if defined(CONFIG_PUB_SUB_ROUTING_INDEX) || defined(CONFIG_PUB_SUB_TOPICS)
+	// If 'subscriber' has unsubscribed since the message was queued it is no longer in the
+	// route so fall back to searching the list of all subscribers
+	if (i == sub_array->num_subs) {
+		sub_array = atomic_ptr_get(&broker->sub_array);
+		sub_array = sub_array != NULL ? sub_array : &empty_sub_array;
+		i = find_subscriber(sub_array, subscriber);
+	}
+#endif
+	// fifo subscribers are at the end of the list so we can just iterate until we hit either a
+	// subscription or the end of the list
+	for (i++; i < sub_array->num_subs; i++) {
+		if (wants_msg(broker, sub_array->subs[i], msg_id, msg)) {
+			return sub_array->subs[i];
+		}
+	}
+	return NULL;
+}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
+// Routes a batch of messages within a single read side critical section and then releases the
+// broker's references to them
+static void process_msgs(struct pub_sub_broker *broker, void *const *msgs, size_t num_msgs)
+{
+	struct routing_thread routing_thread;
+	enter_routing(broker, &routing_thread);
+	uint8_t read_key = pub_sub_broker_read_lock(broker);
+	for (size_t i = 0; i < num_msgs; i++) {
+#ifdef CONFIG_PUB_SUB_LAZY_MSG
+		if (pub_sub_msg_get_alloc_id(msgs[i]) == PUB_SUB_ALLOC_ID_LAZY_MSG) {
+			route_lazy_msg(broker, msgs[i]);
+			continue;
+		}
+#endif // CONFIG_PUB_SUB_LAZY_MSG
+		route_msg(broker, pub_sub_msg_get_msg_id(msgs[i]), msgs[i]);
+	}
+	pub_sub_broker_read_unlock(broker, read_key);
+	exit_routing(broker, &routing_thread);
+	try_reclaim_sub_arrays(broker);
+#ifdef CONFIG_PUB_SUB_STATS
+	pub_sub_stats_record_dispatch(broker, num_msgs);
+#endif // CONFIG_PUB_SUB_STATS
+	for (size_t i = 0; i < num_msgs; i++) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+// Handler functions, filters and lazy message producers run while the broker is routing. The
+// routing threads are tracked so that modifying the broker from within one of them can be detected
+// instead of waiting for itself to finish.
+static void enter_routing(struct pub_sub_broker *broker, struct routing_thread *routing_thread)
+{
+	routing_thread->tid = k_current_get();
+	K_SPINLOCK(&broker->routing_threads_lock) {
+		sys_slist_prepend(&broker->routing_threads, &routing_thread->node);
+	}
+}
+
+static void exit_routing(struct pub_sub_broker *broker, struct routing_thread *routing_thread)
+{
+	K_SPINLOCK(&broker->routing_threads_lock) {
+		sys_slist_find_and_remove(&broker->routing_threads, &routing_thread->node);
+	}
+}
+
+// Returns true if the current thread is routing messages for the broker
+static bool is_routing_thread(struct pub_sub_broker *broker)
+{
+	k_tid_t tid = k_current_get();
+	bool ret = false;
+	K_SPINLOCK(&broker->routing_threads_lock) {
+		struct routing_thread *routing_thread;
+		SYS_SLIST_FOR_EACH_CONTAINER(&broker->routing_threads, routing_thread, node) {
+			if (routing_thread->tid == tid) {
+				ret = true;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+// Must be called from within a read side critical section
+static void route_msg(struct pub_sub_broker *broker, uint16_t msg_id, void *msg)
+{
+	bool fifo_sub_handled = false;
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	if ((msg_id <= CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY_MAX_MSG_ID) &&
+	    !atomic_test_bit(broker->subs_summary, msg_id)) {
+		return;
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	const struct pub_sub_sub_array *sub_array = get_sub_array(broker, msg_id);
+	for (uint16_t i = 0; i < sub_array->num_subs; i++) {
+		struct pub_sub_subscriber *sub = sub_array->subs[i];
+		if (wants_msg(broker, sub, msg_id, msg)) {
+			fifo_sub_handled = send_to_subscriber(sub, msg_id, msg, fifo_sub_handled);
+			// Without fifo fan out a message can only be queued on a single fifo
+			// subscriber at a time and fifo subscribers are all at the end of the list.
+			// So if the message has been queued for a fifo subscriber we can just break
+			// out of the loop.
+			if (fifo_sub_handled) {
+				break;
+			}
+		}
+	}
+}
+
+#ifdef CONFIG_PUB_SUB_LAZY_MSG
+// Must be called from within a read side critical section. The message is only produced if a
+// subscriber will receive it, it is then routed in place of the lazy message.
+static void route_lazy_msg(struct pub_sub_broker *broker, void *lazy_msg)
+{
+	uint16_t msg_id = pub_sub_msg_get_msg_id(lazy_msg);
+	if (!has_subscribers(broker, msg_id)) {
+		return;
+	}
+	void *msg = pub_sub_lazy_msg_produce(lazy_msg);
+	if (msg != NULL) {
+		route_msg(broker, msg_id, msg);
+		pub_sub_release_msg(msg);
+	}
+}
+#endif // CONFIG_PUB_SUB_LAZY_MSG
+
+// Must be called from within a read side critical section
+static bool has_subscribers(struct pub_sub_broker *broker, uint16_t msg_id)
+{
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	if (msg_id <= CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY_MAX_MSG_ID) {
+		return atomic_test_bit(broker->subs_summary, msg_id);
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	const struct pub_sub_sub_array *sub_array = get_sub_array(broker, msg_id);
+	for (uint16_t i = 0; i < sub_array->num_subs; i++) {
+		if (is_subscribed(sub_array->subs[i], msg_id)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Returns true if the message was queued on a fifo subscriber
+static bool send_to_subscriber(struct pub_sub_subscriber *sub, uint16_t msg_id, void *msg,
+			       bool fifo_sub_handled)
+{
+	switch (sub->rx_type) {
+	case PUB_SUB_RX_TYPE_CALLBACK: {
+		pub_sub_subscriber_call_handler(sub, msg_id, msg);
+		break;
+	}
+	case PUB_SUB_RX_TYPE_MSGQ: {
+		pub_sub_acquire_msg(msg);
+		pub_sub_subscriber_msgq_put(sub, msg);
+		break;
+	}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	case PUB_SUB_RX_TYPE_GROUP: {
+		pub_sub_acquire_msg(msg);
+		pub_sub_subscriber_group_put(sub, msg);
+		break;
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	case PUB_SUB_RX_TYPE_FIFO: {
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+		// Every fifo subscriber gets its own envelope so the message is queued on all of
+		// them now rather than being passed along once each one has handled it
+		pub_sub_acquire_msg(msg);
+		pub_sub_subscriber_fifo_put(sub, msg);
+#else
+		if (!fifo_sub_handled) {
+			pub_sub_acquire_msg(msg);
+			pub_sub_subscriber_fifo_put(sub, msg);
+			fifo_sub_handled = true;
+		}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+		break;
+	}
+	}
+	return fifo_sub_handled;
+}
+
+// Must be called from within a read side critical section. Returns the route for 'msg_id' if there
+// is one, otherwise the route for its topic namespace or the list of all subscribers.
+static const struct pub_sub_sub_array *get_sub_array(struct pub_sub_broker *broker,
+						      uint16_t msg_id)
+{
+	const struct pub_sub_sub_array *sub_array;
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+	if (msg_id <= CONFIG_PUB_SUB_ROUTING_INDEX_MAX_MSG_ID) {
+		sub_array = atomic_ptr_get(&broker->routes[msg_id]);
+		if (sub_array != &unindexed_route) {
+			return sub_array != NULL ? sub_array : &empty_sub_array;
+		}
+	}
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_TOPICS
+	sub_array = atomic_ptr_get(&broker->topic_routes[PUB_SUB_TOPIC_PREFIX(msg_id, 1)]);
+	if (sub_array != &unindexed_route) {
+		return sub_array != NULL ? sub_array : &empty_sub_array;
+	}
+#endif // CONFIG_PUB_SUB_TOPICS
+	sub_array = atomic_ptr_get(&broker->sub_array);
+	return sub_array != NULL ? sub_array : &empty_sub_array;
+}
+
+// Returns the index of 'subscriber' within 'sub_array' or the array length if it is not found
+static uint16_t find_subscriber(const struct pub_sub_sub_array *sub_array,
+				const struct pub_sub_subscriber *subscriber)
+{
+	uint16_t i;
+	for (i = 0; i < sub_array->num_subs; i++) {
+		if (sub_array->subs[i] == subscriber) {
+			break;
+		}
+	}
+	return i;
+}
+
+// Must be called with the sub_list_mutex locked. Inserts the subscriber into the broker's list of
+// subscribers, which is sorted by type first, in the order of enum pub_sub_rx_type: callbacks,
+// msgq, groups and then fifo. Then they are sorted by priority value for each type.
+static void insert_subscriber(struct pub_sub_broker *broker, struct pub_sub_subscriber *subscriber)
+{
+	sys_snode_t *prev_node = NULL;
+	struct pub_sub_subscriber *current;
+	// Search for the start of our rx_type, or of the first rx_type after it if there are no
+	// subscribers of our rx_type yet
 	current = SYS_SLIST_PEEK_HEAD_CONTAINER(&broker->subscribers, current, sub_list_node);
 	while (current != NULL) {
-		if (current->rx_type == subscriber->rx_type) {
+		if (current->rx_type >= subscriber->rx_type) {
 			break;
 		}
 		prev_node = &current->sub_list_node;
@@ -51,83 +893,345 @@ void pub_sub_add_subscriber_to_broker(struct pub_sub_broker *broker,
 		prev_node = &current->sub_list_node;
 		current = SYS_SLIST_PEEK_NEXT_CONTAINER(current, sub_list_node);
 	}
-
 	sys_slist_insert(&broker->subscribers, prev_node, &subscriber->sub_list_node);
-	k_mutex_unlock(&broker->sub_list_mutex);
 }
 
-void pub_sub_subscriber_remove_broker(struct pub_sub_subscriber *subscriber)
+// Must be called with the sub_list_mutex locked. Replaces the broker's list of all subscribers
+// with a new array built from the subscriber list.
+static int update_sub_array(struct pub_sub_broker *broker)
 {
-	__ASSERT(subscriber != NULL, "");
-	__ASSERT(subscriber->broker != NULL, "");
-	struct pub_sub_broker *broker = subscriber->broker;
-	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
-	sys_slist_find_and_remove(&broker->subscribers, &subscriber->sub_list_node);
-	k_mutex_unlock(&broker->sub_list_mutex);
-	subscriber->broker = NULL;
+	struct pub_sub_sub_array *sub_array = NULL;
+	size_t num_subs = sys_slist_len(&broker->subscribers);
+	if (num_subs > 0) {
+		struct pub_sub_subscriber *sub;
+		sub_array = k_heap_alloc(&pub_sub_broker_heap,
+					 sizeof(*sub_array) + num_subs * sizeof(sub_array->subs[0]),
+					 K_NO_WAIT);
+		if (sub_array == NULL) {
+			return -ENOMEM;
+		}
+		sub_array->num_subs = 0;
+		SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, sub, sub_list_node) {
+			sub_array->subs[sub_array->num_subs++] = sub;
+		}
+	}
+	replace_sub_array(broker, &broker->sub_array, sub_array);
+	return 0;
 }
 
-static void publish_work_handler(struct k_work *work)
+// Must be called with the sub_list_mutex locked. Publishes the new array to the readers and
+// retires the old array until all of the readers that could be using it have finished.
+static void replace_sub_array(struct pub_sub_broker *broker, atomic_ptr_t *slot,
+			      struct pub_sub_sub_array *sub_array)
 {
-	struct pub_sub_broker *broker = CONTAINER_OF(CONTAINER_OF(work, struct k_work_poll, work),
-						     struct pub_sub_broker, publish_work);
+	struct pub_sub_sub_array *old_sub_array = atomic_ptr_set(slot, sub_array);
+#if defined(CONFIG_PUB_SUB_ROUTING_INDEX) || defined(CONFIG_PUB_SUB_TOPICS)
+	if (old_sub_array == &unindexed_route) {
+		return;
+	}
+#endif
+	if (old_sub_array != NULL) {
+		sys_slist_append(&broker->retired, &old_sub_array->retire_node);
+		atomic_set(&broker->reclaim_pending, 1);
+	}
+}
 
-	void *msg = pub_sub_msg_fifo_get(&broker->msg_publish_fifo, K_NO_WAIT);
-	while (msg != NULL) {
-		uint16_t msg_id = pub_sub_msg_get_msg_id(msg);
-		process_msg(broker, msg_id, msg);
-		msg = pub_sub_msg_fifo_get(&broker->msg_publish_fifo, K_NO_WAIT);
+// Increments the read epoch so that new readers use the other reader count and returns the key
+// of the reader count used by readers that started before the grace period
+static uint8_t start_grace_period(struct pub_sub_broker *broker)
+{
+	return atomic_inc(&broker->read_epoch) & 1;
+}
+
+// Must be called with the sub_list_mutex locked. Frees the subscriber arrays whose grace period
+// has finished and starts a grace period for any newly retired arrays. It never blocks so it can
+// be called from within a handler function.
+static void reclaim_sub_arrays(struct pub_sub_broker *broker)
+{
+	// A grace period only finishes once the previous one has, which isn't known while other
+	// threads are waiting for the readers, so the retired arrays are left until they finish
+	if (broker->num_synchronizing > 0) {
+		return;
+	}
+	if (!sys_slist_is_empty(&broker->reclaiming) &&
+	    (atomic_get(&broker->readers[broker->reclaiming_key]) == 0)) {
+		free_sub_arrays(&broker->reclaiming);
+	}
+	if (sys_slist_is_empty(&broker->reclaiming) && !sys_slist_is_empty(&broker->retired)) {
+		sys_slist_merge_slist(&broker->reclaiming, &broker->retired);
+		broker->reclaiming_key = start_grace_period(broker);
+	}
+	if (sys_slist_is_empty(&broker->reclaiming)) {
+		atomic_set(&broker->reclaim_pending, 0);
 	}
-	broker->publish_work_poll_event.state = K_POLL_STATE_NOT_READY;
-	k_work_poll_submit(&broker->publish_work, &broker->publish_work_poll_event, 1, K_FOREVER);
 }
 
-static void process_msg(struct pub_sub_broker *broker, uint16_t msg_id, void *msg)
+// Frees the retired subscriber arrays after routing, unless another thread is changing the
+// broker's subscribers in which case it reclaims them instead
+static void try_reclaim_sub_arrays(struct pub_sub_broker *broker)
 {
-	bool fifo_sub_handled = false;
-	struct pub_sub_subscriber *sub, *tmp;
+	if (atomic_get(&broker->reclaim_pending) &&
+	    (k_mutex_lock(&broker->sub_list_mutex, K_NO_WAIT) == 0)) {
+		reclaim_sub_arrays(broker);
+		k_mutex_unlock(&broker->sub_list_mutex);
+	}
+}
+
+// Must be called with the sub_list_mutex locked. Waits for every reader that started before the
+// call to finish and then frees the subscriber arrays that were retired before the call. The mutex
+// is released while waiting so that a reader can modify the broker's subscribers without
+// deadlocking.
+static void synchronize_readers(struct pub_sub_broker *broker)
+{
+	sys_slist_t sub_arrays;
+	sys_slist_init(&sub_arrays);
+	sys_slist_merge_slist(&sub_arrays, &broker->reclaiming);
+	sys_slist_merge_slist(&sub_arrays, &broker->retired);
+	atomic_set(&broker->reclaim_pending, 0);
+	broker->num_synchronizing++;
+	k_mutex_unlock(&broker->sub_list_mutex);
+	wait_for_readers(broker);
+	free_sub_arrays(&sub_arrays);
 	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&broker->subscribers, sub, tmp, sub_list_node) {
-		if ((msg_id <= sub->max_pub_msg_id) &&
-		    atomic_test_bit(sub->subs_bitarray, msg_id)) {
-			switch (sub->rx_type) {
-			case PUB_SUB_RX_TYPE_CALLBACK: {
-				__ASSERT(sub->handler_data.msg_handler != NULL, "");
-				sub->handler_data.msg_handler(msg_id, msg,
-							      sub->handler_data.user_data);
-				break;
-			}
-			case PUB_SUB_RX_TYPE_MSGQ: {
-				pub_sub_acquire_msg(msg);
-				k_msgq_put(sub->msgq, &msg, K_FOREVER);
-				break;
+	broker->num_synchronizing--;
+}
+
+// A reader could have started with either key, and other threads can be waiting at the same time,
+// so both reader counts need to be seen at 0. A grace period is started first so that new readers
+// use the other count. The last reader using a count wakes a waiter, which wakes the next one.
+static void wait_for_readers(struct pub_sub_broker *broker)
+{
+	for (uint8_t read_key = 0; read_key < 2; read_key++) {
+		if ((atomic_get(&broker->read_epoch) & 1) == read_key) {
+			(void)start_grace_period(broker);
+		}
+		atomic_inc(&broker->num_waiters[read_key]);
+		while (atomic_get(&broker->readers[read_key]) != 0) {
+			(void)k_sem_take(&broker->readers_done[read_key], K_FOREVER);
+		}
+		if (atomic_dec(&broker->num_waiters[read_key]) > 1) {
+			k_sem_give(&broker->readers_done[read_key]);
+		}
+	}
+}
+
+static void free_sub_arrays(sys_slist_t *list)
+{
+	sys_snode_t *node;
+	while ((node = sys_slist_get(list)) != NULL) {
+		k_heap_free(&pub_sub_broker_heap,
+			    CONTAINER_OF(node, struct pub_sub_sub_array, retire_node));
+	}
+}
+
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+// Must be called with the sub_list_mutex locked
+static void update_subscriber_subscriptions(struct pub_sub_broker *broker,
+					    struct pub_sub_subscriber *subscriber)
+{
+	uint16_t max_msg_id = MIN(subscriber->max_pub_msg_id, max_tracked_msg_id());
+	for (uint32_t msg_id = 0; msg_id <= max_msg_id; msg_id++) {
+		if (is_subscribed(subscriber, msg_id)) {
+			update_subscription(broker, msg_id);
+		}
+	}
+#ifdef CONFIG_PUB_SUB_TOPICS
+	for (uint32_t prefix = 0; prefix < PUB_SUB_TOPIC_NUM_PREFIXES(1); prefix++) {
+		if (in_topic_namespace(subscriber, prefix)) {
+			rebuild_topic_route(broker, prefix);
+		}
+	}
+#endif // CONFIG_PUB_SUB_TOPICS
+}
+
+// The largest message id that has a route or a summary bit
+static uint16_t max_tracked_msg_id(void)
+{
+	uint16_t max_msg_id = 0;
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+	max_msg_id = MAX(max_msg_id, CONFIG_PUB_SUB_ROUTING_INDEX_MAX_MSG_ID);
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	max_msg_id = MAX(max_msg_id, CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY_MAX_MSG_ID);
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	return max_msg_id;
+}
+
+// Must be called with the sub_list_mutex locked
+static void update_subscription(struct pub_sub_broker *broker, uint16_t msg_id)
+{
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+	if (msg_id <= CONFIG_PUB_SUB_ROUTING_INDEX_MAX_MSG_ID) {
+		rebuild_route(broker, msg_id);
+	}
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+	if (msg_id <= CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY_MAX_MSG_ID) {
+		update_summary(broker, msg_id);
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+}
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+// Must be called with the sub_list_mutex locked. Subscribing sets the subscriber's bit before the
+// summary is updated so the bit is always seen here.
+static void update_summary(struct pub_sub_broker *broker, uint16_t msg_id)
+{
+	struct pub_sub_subscriber *sub;
+	SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, sub, sub_list_node) {
+		if (is_subscribed(sub, msg_id)) {
+			atomic_set_bit(broker->subs_summary, msg_id);
+			return;
+		}
+	}
+	atomic_clear_bit(broker->subs_summary, msg_id);
+}
+#endif // CONFIG_PUB_SUB_SUBSCRIPTION_SUMMARY
+
+#ifdef CONFIG_PUB_SUB_ROUTING_INDEX
+
+// Must be called with the sub_list_mutex locked
+static void rebuild_route(struct pub_sub_broker *broker, uint16_t msg_id)
+{
+	build_route(broker, &broker->routes[msg_id], is_subscribed, msg_id);
+}
+#endif // CONFIG_PUB_SUB_ROUTING_INDEX
+
+#ifdef CONFIG_PUB_SUB_TOPICS
+// Must be called with the sub_list_mutex locked
+static void rebuild_topic_route(struct pub_sub_broker *broker, uint16_t prefix)
+{
+	build_route(broker, &broker->topic_routes[prefix], in_topic_namespace, prefix);
+}
+
+// Returns true if the subscriber could be subscribed to a message id in the level 1 namespace
+// 'prefix'. Subscribers using a subscription set are always included, the route is still filtered
+// by their subscriptions when a message is routed.
+static bool in_topic_namespace(const struct pub_sub_subscriber *sub, uint16_t prefix)
+{
+	uint16_t first_msg_id = PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(prefix, 1);
+	if (first_msg_id > sub->max_pub_msg_id) {
+		return false;
+	}
+	if (atomic_test_bit(sub->topic_prefixes_1, prefix)) {
+		return true;
+	}
+	if (PUB_SUB_TOPIC_MAX_LEVELS > 1) {
+		uint16_t first_prefix = prefix << CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS;
+		for (uint16_t i = 0; i < BIT(CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS); i++) {
+			if (atomic_test_bit(sub->topic_prefixes_2, first_prefix + i)) {
+				return true;
 			}
-			case PUB_SUB_RX_TYPE_FIFO: {
-				if (!fifo_sub_handled) {
-					pub_sub_acquire_msg(msg);
-					pub_sub_msg_fifo_put(&sub->fifo, msg);
-					fifo_sub_handled = true;
+		}
+	}
+	uint16_t last_msg_id = MIN(PUB_SUB_TOPIC_PREFIX_LAST_MSG_ID(prefix, 1), sub->max_pub_msg_id);
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	if (sub->subs_set != NULL) {
+		return pub_sub_subs_set_contains_any(sub->subs_set, first_msg_id, last_msg_id);
+	}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+	// Namespaces are whole bit array words so only the final word can extend past the maximum
+	// public message id, and those bits are never set
+	for (size_t i = first_msg_id / ATOMIC_BITS; i <= last_msg_id / ATOMIC_BITS; i++) {
+		if (atomic_get(&sub->subs_bitarray[i]) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif // CONFIG_PUB_SUB_TOPICS
+
+#if defined(CONFIG_PUB_SUB_ROUTING_INDEX) || defined(CONFIG_PUB_SUB_TOPICS)
+// Must be called with the sub_list_mutex locked. Replaces the route in 'slot' with the priority
+// ordered array of subscribers that 'includes' returns true for.
+static void build_route(struct pub_sub_broker *broker, atomic_ptr_t *slot,
+			bool (*includes)(const struct pub_sub_subscriber *sub, uint16_t key),
+			uint16_t key)
+{
+	struct pub_sub_sub_array *route = NULL;
+	struct pub_sub_subscriber *sub;
+	uint16_t num_subs = 0;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, sub, sub_list_node) {
+		if (includes(sub, key)) {
+			num_subs++;
+		}
+	}
+
+	if (num_subs > 0) {
+		route = k_heap_alloc(&pub_sub_broker_heap,
+				     sizeof(*route) + num_subs * sizeof(route->subs[0]), K_NO_WAIT);
+		if (route != NULL) {
+			route->num_subs = 0;
+			SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, sub, sub_list_node) {
+				if (includes(sub, key)) {
+					route->subs[route->num_subs++] = sub;
 				}
-				break;
-			}
-			}
-			// A message can only be queued on a single fifo subscriber at a time and
-			// fifo subscribers are all at the end of the list. So if the message has
-			// been queued for a fifo subscriber we can just break out of the loop.
-			if (fifo_sub_handled) {
-				break;
 			}
+		} else {
+			route = &unindexed_route;
 		}
 	}
-	k_mutex_unlock(&broker->sub_list_mutex);
-	pub_sub_release_msg(msg);
+	replace_sub_array(broker, slot, route);
+}
+#endif
+
+#ifdef CONFIG_PUB_SUB_MSG_RING
+static void put_on_msg_ring(struct pub_sub_broker *broker, void *msg)
+{
+	int ret = pub_sub_msg_ring_put(broker->msg_publish_ring, msg);
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	// The message was dropped so it no longer counts towards the lane's depth
+	if (ret != 0) {
+		atomic_dec(&broker->lane_depth[PUB_SUB_PUBLISH_LANE_NORMAL]);
+	}
+#else
+	ARG_UNUSED(ret);
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
 }
 
+static void put_list_on_msg_ring(struct pub_sub_broker *broker, sys_slist_t *list)
+{
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+	size_t num_msgs = sys_slist_len(list);
+	size_t num_put = pub_sub_msg_ring_put_list(broker->msg_publish_ring, list);
+	// The messages that were dropped no longer count towards the lane's depth
+	atomic_sub(&broker->lane_depth[PUB_SUB_PUBLISH_LANE_NORMAL], num_msgs - num_put);
+#else
+	pub_sub_msg_ring_put_list(broker->msg_publish_ring, list);
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+}
+#endif // CONFIG_PUB_SUB_MSG_RING
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+static void add_lane_depth(struct pub_sub_broker *broker, enum pub_sub_publish_lane lane,
+			   atomic_val_t num_msgs)
+{
+	atomic_val_t depth = atomic_add(&broker->lane_depth[lane], num_msgs) + num_msgs;
+	atomic_val_t peak_depth = atomic_get(&broker->lane_peak_depth[lane]);
+	while (depth > peak_depth) {
+		if (atomic_cas(&broker->lane_peak_depth[lane], peak_depth, depth)) {
+			break;
+		}
+		peak_depth = atomic_get(&broker->lane_peak_depth[lane]);
+	}
+}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
 #ifdef CONFIG_PUB_SUB_DEFAULT_BROKER
 struct pub_sub_broker g_pub_sub_default_broker;
 
+#if defined(CONFIG_PUB_SUB_MSG_RING) && CONFIG_PUB_SUB_DEFAULT_BROKER_MSG_RING_SIZE > 0
+PUB_SUB_MSG_RING_DEFINE(g_pub_sub_default_broker_msg_ring,
+			CONFIG_PUB_SUB_DEFAULT_BROKER_MSG_RING_SIZE);
+#endif
+
 static int pub_sub_init_default_broker(void)
 {
+#if defined(CONFIG_PUB_SUB_MSG_RING) && CONFIG_PUB_SUB_DEFAULT_BROKER_MSG_RING_SIZE > 0
+	pub_sub_broker_set_msg_ring(&g_pub_sub_default_broker, &g_pub_sub_default_broker_msg_ring);
+#endif
 	pub_sub_init_broker(&g_pub_sub_default_broker);
 	return 0;
 }
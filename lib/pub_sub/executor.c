@@ -0,0 +1,179 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/executor.h>
+
+// The scheduling state of a subscriber, guarded by its executor's lock
+enum exec_state {
+	EXEC_STATE_IDLE,
+	// On the ready list
+	EXEC_STATE_QUEUED,
+	// Being handled by a worker
+	EXEC_STATE_RUNNING,
+	// Being handled by a worker and a message was queued since the worker last checked
+	EXEC_STATE_RUNNING_PENDING,
+};
+
+static void worker_thread_fn(void *p1, void *p2, void *p3);
+static struct pub_sub_subscriber *take_ready_subscriber(struct pub_sub_executor *executor);
+static void finish_subscriber(struct pub_sub_executor *executor,
+			      struct pub_sub_subscriber *subscriber, bool budget_used);
+static void make_ready(struct pub_sub_executor *executor, struct pub_sub_subscriber *subscriber);
+static bool has_queued_msgs(struct pub_sub_subscriber *subscriber);
+
+void pub_sub_init_executor(struct pub_sub_executor *executor, int priority)
+{
+	__ASSERT(executor != NULL, "");
+	__ASSERT(executor->num_workers > 0, "");
+	sys_slist_init(&executor->ready);
+	k_sem_init(&executor->ready_sem, 0, K_SEM_MAX_LIMIT);
+	for (uint8_t i = 0; i < executor->num_workers; i++) {
+		k_tid_t tid = k_thread_create(&executor->threads[i],
+					      &executor->stacks[i * executor->stack_len],
+					      executor->stack_size, worker_thread_fn, executor,
+					      NULL, NULL, priority, 0, K_NO_WAIT);
+		k_thread_name_set(tid, "pub_sub_executor");
+	}
+}
+
+void pub_sub_executor_add_subscriber(struct pub_sub_executor *executor,
+				     struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(executor != NULL, "");
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT((subscriber->rx_type == PUB_SUB_RX_TYPE_MSGQ) ||
+			 (subscriber->rx_type == PUB_SUB_RX_TYPE_FIFO),
+		 "Only msgq and fifo subscribers have queued messages");
+	__ASSERT(subscriber->executor == NULL, "");
+	K_SPINLOCK(&executor->lock) {
+		subscriber->executor = executor;
+		subscriber->exec_state = EXEC_STATE_IDLE;
+		// Messages may have been queued before the subscriber was added
+		if (has_queued_msgs(subscriber)) {
+			make_ready(executor, subscriber);
+		}
+	}
+}
+
+void pub_sub_executor_remove_subscriber(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	struct pub_sub_executor *executor = subscriber->executor;
+	__ASSERT(executor != NULL, "");
+	bool running;
+	K_SPINLOCK(&executor->lock) {
+		subscriber->executor = NULL;
+		if (subscriber->exec_state == EXEC_STATE_QUEUED) {
+			// The ready semaphore has already been given, the worker it wakes finds one
+			// fewer subscriber on the ready list and goes back to waiting
+			sys_slist_find_and_remove(&executor->ready, &subscriber->ready_node);
+			subscriber->exec_state = EXEC_STATE_IDLE;
+		}
+		running = subscriber->exec_state != EXEC_STATE_IDLE;
+	}
+	// A worker that is running the subscriber sets it to idle when it finishes as the
+	// subscriber no longer has an executor
+	while (running) {
+		k_sleep(K_MSEC(1));
+		K_SPINLOCK(&executor->lock) {
+			running = subscriber->exec_state != EXEC_STATE_IDLE;
+		}
+	}
+}
+
+void pub_sub_executor_notify(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	struct pub_sub_executor *executor = subscriber->executor;
+	if (executor == NULL) {
+		return;
+	}
+	K_SPINLOCK(&executor->lock) {
+		// The subscriber may have been removed since its executor was read
+		if (subscriber->executor != executor) {
+			// Nothing to do
+		} else if (subscriber->exec_state == EXEC_STATE_IDLE) {
+			make_ready(executor, subscriber);
+		} else if (subscriber->exec_state == EXEC_STATE_RUNNING) {
+			subscriber->exec_state = EXEC_STATE_RUNNING_PENDING;
+		}
+	}
+}
+
+static void worker_thread_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+	struct pub_sub_executor *executor = p1;
+
+	for (;;) {
+		(void)k_sem_take(&executor->ready_sem, K_FOREVER);
+		struct pub_sub_subscriber *subscriber = take_ready_subscriber(executor);
+		if (subscriber == NULL) {
+			continue;
+		}
+		size_t num_handled = 0;
+		while (num_handled < CONFIG_PUB_SUB_EXECUTOR_BATCH_SIZE) {
+			if (pub_sub_handle_queued_msg(subscriber, K_NO_WAIT) != 0) {
+				break;
+			}
+			num_handled++;
+		}
+		finish_subscriber(executor, subscriber,
+				  num_handled == CONFIG_PUB_SUB_EXECUTOR_BATCH_SIZE);
+	}
+}
+
+static struct pub_sub_subscriber *take_ready_subscriber(struct pub_sub_executor *executor)
+{
+	struct pub_sub_subscriber *subscriber = NULL;
+	K_SPINLOCK(&executor->lock) {
+		sys_snode_t *node = sys_slist_get(&executor->ready);
+		if (node != NULL) {
+			subscriber = CONTAINER_OF(node, struct pub_sub_subscriber, ready_node);
+			subscriber->exec_state = EXEC_STATE_RUNNING;
+		}
+	}
+	return subscriber;
+}
+
+// If the worker used its whole budget, or a message was queued while it was running, the
+// subscriber goes to the back of its priority on the ready list so that the other runnable
+// subscribers get a turn first
+static void finish_subscriber(struct pub_sub_executor *executor,
+			      struct pub_sub_subscriber *subscriber, bool budget_used)
+{
+	K_SPINLOCK(&executor->lock) {
+		bool pending = budget_used ||
+			       (subscriber->exec_state == EXEC_STATE_RUNNING_PENDING);
+		subscriber->exec_state = EXEC_STATE_IDLE;
+		if (pending && (subscriber->executor == executor)) {
+			make_ready(executor, subscriber);
+		}
+	}
+}
+
+// Must be called with the executor's lock held
+static void make_ready(struct pub_sub_executor *executor, struct pub_sub_subscriber *subscriber)
+{
+	sys_snode_t *prev_node = NULL;
+	struct pub_sub_subscriber *current;
+	SYS_SLIST_FOR_EACH_CONTAINER(&executor->ready, current, ready_node) {
+		if (current->priority > subscriber->priority) {
+			break;
+		}
+		prev_node = &current->ready_node;
+	}
+	sys_slist_insert(&executor->ready, prev_node, &subscriber->ready_node);
+	subscriber->exec_state = EXEC_STATE_QUEUED;
+	k_sem_give(&executor->ready_sem);
+}
+
+static bool has_queued_msgs(struct pub_sub_subscriber *subscriber)
+{
+	if (subscriber->rx_type == PUB_SUB_RX_TYPE_MSGQ) {
+		return k_msgq_num_used_get(subscriber->msgq) > 0;
+	}
+	return !k_fifo_is_empty(&subscriber->fifo);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/lazy_msg.h>
+
+void pub_sub_lazy_msg_init(struct pub_sub_lazy_msg *lazy_msg, struct pub_sub_allocator *allocator,
+			   uint16_t msg_id, size_t msg_size_bytes,
+			   pub_sub_lazy_msg_produce_fn produce, void *user_data)
+{
+	__ASSERT(lazy_msg != NULL, "");
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(produce != NULL, "");
+	lazy_msg->allocator = allocator;
+	lazy_msg->produce = produce;
+	lazy_msg->user_data = user_data;
+	lazy_msg->msg_size_bytes = msg_size_bytes;
+	atomic_set(&lazy_msg->dropped, 0);
+	// The reference counter starts at 0 so the lazy message is free to be published
+	lazy_msg->pub_sub_msg.atomic_data =
+		PUB_SUB_MSG_ATOMIC_DATA_INIT(msg_id, PUB_SUB_ALLOC_ID_LAZY_MSG);
+}
+
+int pub_sub_publish_lazy_to_broker(struct pub_sub_broker *broker,
+				   struct pub_sub_lazy_msg *lazy_msg)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(lazy_msg != NULL, "");
+	// Taking the reference has to be atomic with checking that the lazy message is not already
+	// queued as it can be published from multiple contexts
+	atomic_val_t data = atomic_get(&lazy_msg->pub_sub_msg.atomic_data);
+	if ((FIELD_GET(PUB_SUB_MSG_REF_CNT_MASK, data) != 0) ||
+	    !atomic_cas(&lazy_msg->pub_sub_msg.atomic_data, data, data + 1)) {
+		return -EBUSY;
+	}
+	pub_sub_publish_to_broker(broker, lazy_msg->pub_sub_msg.msg);
+	return 0;
+}
+
+void *pub_sub_lazy_msg_produce(void *msg)
+{
+	__ASSERT(msg != NULL, "");
+	__ASSERT(pub_sub_msg_get_alloc_id(msg) == PUB_SUB_ALLOC_ID_LAZY_MSG, "");
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+	struct pub_sub_lazy_msg *lazy_msg =
+		CONTAINER_OF(ps_msg, struct pub_sub_lazy_msg, pub_sub_msg);
+	uint16_t msg_id = pub_sub_msg_get_msg_id(msg);
+	void *new_msg =
+		pub_sub_new_msg(lazy_msg->allocator, msg_id, lazy_msg->msg_size_bytes, K_NO_WAIT);
+	if (new_msg == NULL) {
+		atomic_inc(&lazy_msg->dropped);
+		return NULL;
+	}
+	lazy_msg->produce(msg_id, new_msg, lazy_msg->user_data);
+	return new_msg;
+}
\ No newline at end of file
@@ -3,10 +3,17 @@
  */
 #include <pub_sub/msg_alloc.h>
 #include <pub_sub/static_msg.h>
+#include <string.h>
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+#include <pub_sub/msg_alloc_stats.h>
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 
 #ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
 struct pub_sub_runtime_allocators {
 	struct pub_sub_allocator *allocators[CONFIG_PUB_SUB_RUNTIME_ALLOCATORS_MAX_NUM];
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+	struct pub_sub_allocator_counters counters[CONFIG_PUB_SUB_RUNTIME_ALLOCATORS_MAX_NUM];
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 	size_t num_allocators;
 	struct k_mutex mutex;
 };
@@ -20,29 +27,38 @@ void pub_sub_release_msg(const void *msg)
 	uint8_t prev_ref_cnt = pub_sub_msg_dec_ref_cnt(msg);
 	if (prev_ref_cnt == 1) {
 		uint8_t allocator_id = pub_sub_msg_get_alloc_id(msg);
-		if (allocator_id <= PUB_SUB_ALLOC_ID_LINK_SECTION_MAX_ID) {
-			struct pub_sub_allocator *allocator;
-			STRUCT_SECTION_GET(pub_sub_allocator, allocator_id, &allocator);
+		struct pub_sub_allocator *allocator = pub_sub_allocator_from_id(allocator_id);
+		if (allocator != NULL) {
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+			pub_sub_allocator_stats_record_free(allocator, pub_sub_msg_get_msg_id(msg));
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 			allocator->free(allocator->impl, msg);
-
-#ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
-		} else if ((allocator_id - PUB_SUB_ALLOC_ID_RUNTIME_OFFSET) <
-			   g_runtime_allocators.num_allocators) {
-			uint8_t runtime_id = allocator_id - PUB_SUB_ALLOC_ID_RUNTIME_OFFSET;
-			// Run time allocators can only be added and never removed so
-			// we don't need to lock the mutex to find a run time allocator
-			// from an allocator id as it can never change once assigned.
-			struct pub_sub_allocator *allocator =
-				g_runtime_allocators.allocators[runtime_id];
-			allocator->free(allocator->impl, msg);
-#endif // CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
-
 		} else if (allocator_id == PUB_SUB_ALLOC_ID_CALLBACK_MSG) {
 			pub_sub_free_callback_msg(msg);
 		}
 	}
 }
 
+struct pub_sub_allocator *pub_sub_allocator_from_id(uint8_t allocator_id)
+{
+	if (allocator_id <= PUB_SUB_ALLOC_ID_LINK_SECTION_MAX_ID) {
+		struct pub_sub_allocator *allocator;
+		STRUCT_SECTION_GET(pub_sub_allocator, allocator_id, &allocator);
+		return allocator;
+	}
+#ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
+	uint8_t runtime_id = allocator_id - PUB_SUB_ALLOC_ID_RUNTIME_OFFSET;
+	if (allocator_id >= PUB_SUB_ALLOC_ID_RUNTIME_OFFSET &&
+	    runtime_id < g_runtime_allocators.num_allocators) {
+		// Run time allocators can only be added and never removed so we don't need to lock
+		// the mutex to find a run time allocator from an allocator id as it can never
+		// change once assigned.
+		return g_runtime_allocators.allocators[runtime_id];
+	}
+#endif // CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
+	return NULL;
+}
+
 #ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
 int pub_sub_add_runtime_allocator(struct pub_sub_allocator *allocator)
 {
@@ -52,6 +68,10 @@ int pub_sub_add_runtime_allocator(struct pub_sub_allocator *allocator)
 	if (g_runtime_allocators.num_allocators < CONFIG_PUB_SUB_RUNTIME_ALLOCATORS_MAX_NUM) {
 		uint8_t allocator_id = g_runtime_allocators.num_allocators;
 		allocator->allocator_id = allocator_id + PUB_SUB_ALLOC_ID_RUNTIME_OFFSET;
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+		allocator->counters = &g_runtime_allocators.counters[allocator_id];
+		memset(allocator->counters, 0, sizeof(*allocator->counters));
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
 		g_runtime_allocators.allocators[allocator_id] = allocator;
 		g_runtime_allocators.num_allocators++;
 		ret = 0;
@@ -0,0 +1,83 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc_heap.h>
+
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+// The heap has no public query for its largest free chunk so its free lists are read directly
+// using the kernel heap's private header, its directory is added for this file by CMake
+#include <heap.h>
+
+static size_t largest_free_block(struct k_heap *heap);
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+
+void pub_sub_init_heap_allocator(struct pub_sub_allocator *allocator, struct k_heap *heap)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(heap != NULL, "");
+	allocator->allocate = pub_sub_allocate_from_heap;
+	allocator->free = pub_sub_free_for_heap;
+	allocator->allocator_id = PUB_SUB_ALLOC_ID_INVALID;
+	allocator->impl = heap;
+}
+
+void *pub_sub_allocate_from_heap(void *impl, size_t msg_size_bytes, k_timeout_t timeout)
+{
+	__ASSERT(impl != NULL, "");
+	struct k_heap *heap = impl;
+	struct pub_sub_msg *ps_msg =
+		k_heap_alloc(heap, msg_size_bytes + PUB_SUB_MSG_OVERHEAD_NUM_BYTES, timeout);
+	return ps_msg != NULL ? ps_msg->msg : NULL;
+}
+
+void pub_sub_free_for_heap(void *impl, const void *msg)
+{
+	__ASSERT(impl != NULL, "");
+	__ASSERT(msg != NULL, "");
+	struct k_heap *heap = impl;
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+	k_heap_free(heap, ps_msg);
+}
+
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+void pub_sub_heap_allocator_stats(const struct pub_sub_allocator *allocator,
+				  struct pub_sub_heap_allocator_stats *stats)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(stats != NULL, "");
+	struct k_heap *heap = allocator->impl;
+	struct sys_memory_stats heap_stats;
+
+	sys_heap_runtime_stats_get(&heap->heap, &heap_stats);
+	stats->free_bytes = heap_stats.free_bytes;
+	stats->allocated_bytes = heap_stats.allocated_bytes;
+	stats->max_allocated_bytes = heap_stats.max_allocated_bytes;
+	stats->largest_free_block = largest_free_block(heap);
+	if (heap_stats.free_bytes == 0) {
+		stats->fragmentation_percent = 0;
+	} else {
+		stats->fragmentation_percent =
+			100 - (stats->largest_free_block * 100) / heap_stats.free_bytes;
+	}
+}
+
+static size_t largest_free_block(struct k_heap *heap)
+{
+	// Free chunks are kept in buckets by the log2 of their size so the largest free chunk is in
+	// the highest non empty bucket and only that bucket's free list needs to be walked.
+	struct z_heap *h = heap->heap.heap;
+	chunksz_t largest = 0;
+	k_spinlock_key_t key = k_spin_lock(&heap->lock);
+	if (h->avail_buckets != 0) {
+		int bucket = 31 - __builtin_clz(h->avail_buckets);
+		chunkid_t first = h->buckets[bucket].next;
+		chunkid_t chunk = first;
+		do {
+			largest = MAX(largest, chunk_size(h, chunk));
+			chunk = next_free_chunk(h, chunk);
+		} while (chunk != first);
+	}
+	k_spin_unlock(&heap->lock, key);
+	return largest != 0 ? chunksz_to_bytes(h, largest) : 0;
+}
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
\ No newline at end of file
@@ -0,0 +1,99 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc_lock_free.h>
+
+#define TAG_INCREMENT ((uintptr_t)PUB_SUB_LOCK_FREE_POOL_INDEX_MASK + 1)
+
+static atomic_val_t next_head(atomic_val_t head, uint16_t index);
+static atomic_t *block_next(struct pub_sub_lock_free_pool *pool, uint16_t index);
+static void *carve_block(struct pub_sub_lock_free_pool *pool);
+
+void pub_sub_init_lock_free_allocator(struct pub_sub_allocator *allocator,
+				      struct pub_sub_lock_free_pool *pool, uint8_t *buffer,
+				      size_t msg_size, uint16_t num_msgs)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(pool != NULL, "");
+	__ASSERT(buffer != NULL, "");
+	__ASSERT(((uintptr_t)buffer % sizeof(uintptr_t)) == 0, "");
+	__ASSERT(num_msgs < PUB_SUB_LOCK_FREE_POOL_MAX_NUM_MSGS, "");
+	atomic_set(&pool->head, PUB_SUB_LOCK_FREE_POOL_EMPTY);
+	atomic_set(&pool->num_carved, 0);
+	pool->buffer = buffer;
+	pool->block_size = PUB_SUB_LOCK_FREE_ALLOCATOR_BLOCK_SIZE(msg_size);
+	pool->num_blocks = num_msgs;
+	allocator->allocate = pub_sub_allocate_from_lock_free_pool;
+	allocator->free = pub_sub_free_for_lock_free_pool;
+	allocator->allocator_id = PUB_SUB_ALLOC_ID_INVALID;
+	allocator->impl = pool;
+}
+
+void *pub_sub_allocate_from_lock_free_pool(void *impl, size_t msg_size_bytes, k_timeout_t timeout)
+{
+	__ASSERT(impl != NULL, "");
+	ARG_UNUSED(timeout);
+	struct pub_sub_lock_free_pool *pool = impl;
+	__ASSERT(msg_size_bytes <= pool->block_size - PUB_SUB_MSG_OVERHEAD_NUM_BYTES, "");
+	struct pub_sub_msg *ps_msg;
+	atomic_val_t head;
+	atomic_val_t new_head;
+	uint16_t index;
+
+	do {
+		head = atomic_get(&pool->head);
+		index = head & PUB_SUB_LOCK_FREE_POOL_INDEX_MASK;
+		if (index == PUB_SUB_LOCK_FREE_POOL_EMPTY) {
+			ps_msg = carve_block(pool);
+			return ps_msg != NULL ? ps_msg->msg : NULL;
+		}
+		// The block can be popped and rewritten by another CPU or ISR after reading the
+		// head, the next index is then stale but the changed tag fails the compare and swap
+		new_head = next_head(head, atomic_get(block_next(pool, index)));
+	} while (!atomic_cas(&pool->head, head, new_head));
+
+	ps_msg = (struct pub_sub_msg *)(pool->buffer + (size_t)index * pool->block_size);
+	return ps_msg->msg;
+}
+
+void pub_sub_free_for_lock_free_pool(void *impl, const void *msg)
+{
+	__ASSERT(impl != NULL, "");
+	__ASSERT(msg != NULL, "");
+	struct pub_sub_lock_free_pool *pool = impl;
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+	size_t offset = (uint8_t *)ps_msg - pool->buffer;
+	__ASSERT(offset % pool->block_size == 0, "");
+	uint16_t index = offset / pool->block_size;
+	__ASSERT(index < pool->num_blocks, "");
+	atomic_val_t head;
+
+	do {
+		head = atomic_get(&pool->head);
+		atomic_set(block_next(pool, index), head & PUB_SUB_LOCK_FREE_POOL_INDEX_MASK);
+	} while (!atomic_cas(&pool->head, head, next_head(head, index)));
+}
+
+static atomic_val_t next_head(atomic_val_t head, uint16_t index)
+{
+	uintptr_t tag = ((uintptr_t)head & ~(uintptr_t)PUB_SUB_LOCK_FREE_POOL_INDEX_MASK);
+	return (atomic_val_t)((tag + TAG_INCREMENT) | index);
+}
+
+static atomic_t *block_next(struct pub_sub_lock_free_pool *pool, uint16_t index)
+{
+	// A free block's first word, the header's reserved FIFO pointer, holds the next free index
+	return (atomic_t *)(pool->buffer + (size_t)index * pool->block_size);
+}
+
+static void *carve_block(struct pub_sub_lock_free_pool *pool)
+{
+	atomic_val_t num_carved;
+	do {
+		num_carved = atomic_get(&pool->num_carved);
+		if (num_carved >= pool->num_blocks) {
+			return NULL;
+		}
+	} while (!atomic_cas(&pool->num_carved, num_carved, num_carved + 1));
+	return pool->buffer + (size_t)num_carved * pool->block_size;
+}
\ No newline at end of file
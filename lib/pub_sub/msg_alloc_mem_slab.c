@@ -2,6 +2,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <pub_sub/msg_alloc_mem_slab.h>
+#include <string.h>
 
 void pub_sub_init_mem_slab_allocator(struct pub_sub_allocator *allocator,
 				     struct k_mem_slab *mem_slab)
@@ -31,4 +32,134 @@ void pub_sub_free_for_mem_slab(void *impl, const void *msg)
 	struct k_mem_slab *mem_slab = impl;
 	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
 	k_mem_slab_free(mem_slab, ps_msg);
-}
\ No newline at end of file
+}
+
+#ifdef CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+// The number of blocks moved between a magazine and the memory slab at a time, leaving a refilled
+// or flushed magazine half full so both allocations and frees can follow without the slab's lock
+#define MAGAZINE_BATCH_SIZE ((CONFIG_PUB_SUB_MEM_SLAB_MAGAZINE_SIZE + 1) / 2)
+
+static struct pub_sub_mem_slab_magazine *
+cpu_magazine(struct pub_sub_mem_slab_magazines *magazines);
+static void flush_magazine(struct k_mem_slab *mem_slab, struct pub_sub_mem_slab_magazine *magazine,
+			   uint8_t num_blocks);
+static void flush_all_magazines(struct pub_sub_mem_slab_magazines *magazines);
+
+void pub_sub_init_mem_slab_magazine_allocator(struct pub_sub_allocator *allocator,
+					      struct pub_sub_mem_slab_magazines *magazines,
+					      struct k_mem_slab *mem_slab)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(magazines != NULL, "");
+	__ASSERT(mem_slab != NULL, "");
+	ARRAY_FOR_EACH(magazines->cpus, i) {
+		magazines->cpus[i] = (struct pub_sub_mem_slab_magazine){0};
+	}
+	magazines->mem_slab = mem_slab;
+	atomic_set(&magazines->num_waiting, 0);
+	allocator->allocate = pub_sub_allocate_from_mem_slab_magazines;
+	allocator->free = pub_sub_free_for_mem_slab_magazines;
+	allocator->allocator_id = PUB_SUB_ALLOC_ID_INVALID;
+	allocator->impl = magazines;
+}
+
+void pub_sub_mem_slab_magazines_flush(const struct pub_sub_allocator *allocator)
+{
+	__ASSERT(allocator != NULL, "");
+	flush_all_magazines(allocator->impl);
+}
+
+void *pub_sub_allocate_from_mem_slab_magazines(void *impl, size_t msg_size_bytes,
+					       k_timeout_t timeout)
+{
+	__ASSERT(impl != NULL, "");
+	struct pub_sub_mem_slab_magazines *magazines = impl;
+	struct k_mem_slab *mem_slab = magazines->mem_slab;
+	__ASSERT(msg_size_bytes <= mem_slab->info.block_size - PUB_SUB_MSG_OVERHEAD_NUM_BYTES, "");
+	struct pub_sub_mem_slab_magazine *magazine = cpu_magazine(magazines);
+	struct pub_sub_msg *ps_msg = NULL;
+
+	K_SPINLOCK(&magazine->lock) {
+		if (magazine->num_blocks == 0) {
+			while (magazine->num_blocks < MAGAZINE_BATCH_SIZE &&
+			       k_mem_slab_alloc(mem_slab, &magazine->blocks[magazine->num_blocks],
+						K_NO_WAIT) == 0) {
+				magazine->num_blocks++;
+			}
+		}
+		if (magazine->num_blocks > 0) {
+			magazine->num_blocks--;
+			ps_msg = magazine->blocks[magazine->num_blocks];
+		}
+	}
+	if (ps_msg != NULL) {
+		return ps_msg->msg;
+	}
+
+	// The memory slab is empty, any free blocks are held by the other CPUs' magazines so return
+	// them to the memory slab before taking one or waiting on it. Frees see the waiting count
+	// under their magazine's lock, so a free either lands in a magazine before it is flushed
+	// or goes straight to the memory slab where it wakes the waiting allocation.
+	atomic_inc(&magazines->num_waiting);
+	flush_all_magazines(magazines);
+	int res = k_mem_slab_alloc(mem_slab, (void **)&ps_msg, timeout);
+	atomic_dec(&magazines->num_waiting);
+	return res == 0 ? ps_msg->msg : NULL;
+}
+
+void pub_sub_free_for_mem_slab_magazines(void *impl, const void *msg)
+{
+	__ASSERT(impl != NULL, "");
+	__ASSERT(msg != NULL, "");
+	struct pub_sub_mem_slab_magazines *magazines = impl;
+	struct k_mem_slab *mem_slab = magazines->mem_slab;
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+
+	struct pub_sub_mem_slab_magazine *magazine = cpu_magazine(magazines);
+	K_SPINLOCK(&magazine->lock) {
+		// While an allocation may be waiting on the memory slab blocks are freed straight to
+		// it so that the allocation is woken
+		if (atomic_get(&magazines->num_waiting) > 0) {
+			k_mem_slab_free(mem_slab, ps_msg);
+		} else {
+			if (magazine->num_blocks == CONFIG_PUB_SUB_MEM_SLAB_MAGAZINE_SIZE) {
+				flush_magazine(mem_slab, magazine, MAGAZINE_BATCH_SIZE);
+			}
+			magazine->blocks[magazine->num_blocks] = ps_msg;
+			magazine->num_blocks++;
+		}
+	}
+}
+
+static struct pub_sub_mem_slab_magazine *
+cpu_magazine(struct pub_sub_mem_slab_magazines *magazines)
+{
+	// The thread can move to another CPU straight after reading the CPU id, that only costs
+	// locality as each magazine is protected by its own lock
+	return &magazines->cpus[arch_curr_cpu()->id];
+}
+
+static void flush_magazine(struct k_mem_slab *mem_slab, struct pub_sub_mem_slab_magazine *magazine,
+			   uint8_t num_blocks)
+{
+	// Must be called with the magazine's lock held. The oldest blocks at the bottom of the
+	// magazine are flushed, keeping the most recently freed blocks that are likely still cached
+	__ASSERT(num_blocks <= magazine->num_blocks, "");
+	for (uint8_t i = 0; i < num_blocks; i++) {
+		k_mem_slab_free(mem_slab, magazine->blocks[i]);
+	}
+	magazine->num_blocks -= num_blocks;
+	memmove(&magazine->blocks[0], &magazine->blocks[num_blocks],
+		magazine->num_blocks * sizeof(magazine->blocks[0]));
+}
+
+static void flush_all_magazines(struct pub_sub_mem_slab_magazines *magazines)
+{
+	ARRAY_FOR_EACH(magazines->cpus, i) {
+		struct pub_sub_mem_slab_magazine *magazine = &magazines->cpus[i];
+		K_SPINLOCK(&magazine->lock) {
+			flush_magazine(magazines->mem_slab, magazine, magazine->num_blocks);
+		}
+	}
+}
+#endif // CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
\ No newline at end of file
@@ -0,0 +1,124 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc_size_class.h>
+
+static bool slab_owns_block(const struct k_mem_slab *mem_slab, const void *block);
+
+void pub_sub_init_size_class_allocator(struct pub_sub_allocator *allocator,
+				       struct pub_sub_size_class_allocator *size_classes,
+				       struct k_mem_slab *const *classes,
+				       struct pub_sub_size_class_counters *counters,
+				       uint8_t num_classes, bool fallback_to_larger)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(size_classes != NULL, "");
+	__ASSERT(classes != NULL, "");
+	__ASSERT(counters != NULL, "");
+	__ASSERT(num_classes > 0, "");
+	for (uint8_t i = 1; i < num_classes; i++) {
+		__ASSERT(classes[i - 1]->info.block_size <= classes[i]->info.block_size,
+			 "Size classes must be in order of increasing block size");
+	}
+	for (uint8_t i = 0; i < num_classes; i++) {
+		atomic_set(&counters[i].fallbacks, 0);
+		atomic_set(&counters[i].failures, 0);
+	}
+	size_classes->classes = classes;
+	size_classes->counters = counters;
+	size_classes->num_classes = num_classes;
+	size_classes->fallback = fallback_to_larger;
+	allocator->allocate = pub_sub_allocate_from_size_classes;
+	allocator->free = pub_sub_free_for_size_classes;
+	allocator->allocator_id = PUB_SUB_ALLOC_ID_INVALID;
+	allocator->impl = size_classes;
+}
+
+int pub_sub_size_class_allocator_stats(const struct pub_sub_allocator *allocator,
+				       uint8_t size_class, struct pub_sub_size_class_stats *stats)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(stats != NULL, "");
+	const struct pub_sub_size_class_allocator *size_classes = allocator->impl;
+	if (size_class >= size_classes->num_classes) {
+		return -EINVAL;
+	}
+	struct k_mem_slab *mem_slab = size_classes->classes[size_class];
+	struct pub_sub_size_class_counters *counters = &size_classes->counters[size_class];
+	stats->msg_size = mem_slab->info.block_size - PUB_SUB_MSG_OVERHEAD_NUM_BYTES;
+	stats->num_msgs = mem_slab->info.num_blocks;
+	stats->num_used = k_mem_slab_num_used_get(mem_slab);
+#ifdef CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION
+	stats->max_used = k_mem_slab_max_used_get(mem_slab);
+#endif // CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION
+	stats->num_fallbacks = atomic_get(&counters->fallbacks);
+	stats->num_failures = atomic_get(&counters->failures);
+	return 0;
+}
+
+void *pub_sub_allocate_from_size_classes(void *impl, size_t msg_size_bytes, k_timeout_t timeout)
+{
+	__ASSERT(impl != NULL, "");
+	struct pub_sub_size_class_allocator *size_classes = impl;
+	const size_t block_size = msg_size_bytes + PUB_SUB_MSG_OVERHEAD_NUM_BYTES;
+	struct pub_sub_msg *ps_msg = NULL;
+
+	// The classes are sorted so the first one large enough is the best fit
+	uint8_t best_fit = 0;
+	while (best_fit < size_classes->num_classes &&
+	       size_classes->classes[best_fit]->info.block_size < block_size) {
+		best_fit++;
+	}
+	__ASSERT(best_fit < size_classes->num_classes, "Message too large for all size classes");
+	if (best_fit >= size_classes->num_classes) {
+		return NULL;
+	}
+
+	if (size_classes->fallback) {
+		// Take a free block from the smallest class that has one without waiting, only
+		// waiting on the best fitting class if every larger class is also empty
+		for (uint8_t i = best_fit; i < size_classes->num_classes; i++) {
+			if (k_mem_slab_alloc(size_classes->classes[i], (void **)&ps_msg,
+					     K_NO_WAIT) == 0) {
+				if (i != best_fit) {
+					atomic_inc(&size_classes->counters[best_fit].fallbacks);
+				}
+				return ps_msg->msg;
+			}
+		}
+		if (K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+			atomic_inc(&size_classes->counters[best_fit].failures);
+			return NULL;
+		}
+	}
+
+	if (k_mem_slab_alloc(size_classes->classes[best_fit], (void **)&ps_msg, timeout) != 0) {
+		atomic_inc(&size_classes->counters[best_fit].failures);
+		return NULL;
+	}
+	return ps_msg->msg;
+}
+
+void pub_sub_free_for_size_classes(void *impl, const void *msg)
+{
+	__ASSERT(impl != NULL, "");
+	__ASSERT(msg != NULL, "");
+	struct pub_sub_size_class_allocator *size_classes = impl;
+	struct pub_sub_msg *ps_msg = CONTAINER_OF(msg, struct pub_sub_msg, msg);
+	// The message header does not record the class so find the memory slab whose buffer holds
+	// the message
+	for (uint8_t i = 0; i < size_classes->num_classes; i++) {
+		if (slab_owns_block(size_classes->classes[i], ps_msg)) {
+			k_mem_slab_free(size_classes->classes[i], ps_msg);
+			return;
+		}
+	}
+	__ASSERT(false, "Message does not belong to any size class");
+}
+
+static bool slab_owns_block(const struct k_mem_slab *mem_slab, const void *block)
+{
+	const char *start = mem_slab->buffer;
+	const char *end = start + (size_t)mem_slab->info.num_blocks * mem_slab->info.block_size;
+	return (const char *)block >= start && (const char *)block < end;
+}
\ No newline at end of file
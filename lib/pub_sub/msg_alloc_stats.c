@@ -0,0 +1,125 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc_stats.h>
+
+#define LIVE_MSGS_OTHER_INDEX (CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID + 1)
+
+static struct pub_sub_allocator_counters *get_counters(const struct pub_sub_allocator *allocator);
+static size_t live_msgs_index(uint16_t msg_id);
+static uint64_t blocked_timestamp_ns(void);
+
+void pub_sub_allocator_stats_get(const struct pub_sub_allocator *allocator,
+				 struct pub_sub_allocator_stats *stats)
+{
+	__ASSERT(allocator != NULL, "");
+	__ASSERT(stats != NULL, "");
+	struct pub_sub_allocator_counters *counters = get_counters(allocator);
+	stats->in_use = atomic_get(&counters->in_use);
+	stats->peak_in_use = atomic_get(&counters->peak_in_use);
+	stats->allocations = atomic_get(&counters->allocations);
+	stats->failures = atomic_get(&counters->failures);
+	K_SPINLOCK(&counters->lock) {
+		stats->blocked_ns = counters->blocked_ns;
+	}
+}
+
+uint32_t pub_sub_allocator_stats_live_msgs(const struct pub_sub_allocator *allocator,
+					   uint16_t msg_id)
+{
+	__ASSERT(allocator != NULL, "");
+	struct pub_sub_allocator_counters *counters = get_counters(allocator);
+	return atomic_get(&counters->live_msgs[live_msgs_index(msg_id)]);
+}
+
+void pub_sub_allocator_stats_reset(const struct pub_sub_allocator *allocator)
+{
+	__ASSERT(allocator != NULL, "");
+	struct pub_sub_allocator_counters *counters = get_counters(allocator);
+	atomic_set(&counters->peak_in_use, atomic_get(&counters->in_use));
+	atomic_set(&counters->allocations, 0);
+	atomic_set(&counters->failures, 0);
+	K_SPINLOCK(&counters->lock) {
+		counters->blocked_ns = 0;
+	}
+}
+
+void pub_sub_allocator_stats_foreach(void (*fn)(const struct pub_sub_allocator *allocator,
+						void *user_data),
+				     void *user_data)
+{
+	__ASSERT(fn != NULL, "");
+	STRUCT_SECTION_FOREACH(pub_sub_allocator, allocator) {
+		fn(allocator, user_data);
+	}
+#ifdef CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
+	for (uint8_t i = 0; i < CONFIG_PUB_SUB_RUNTIME_ALLOCATORS_MAX_NUM; i++) {
+		struct pub_sub_allocator *allocator =
+			pub_sub_allocator_from_id(i + PUB_SUB_ALLOC_ID_RUNTIME_OFFSET);
+		if (allocator == NULL) {
+			break;
+		}
+		fn(allocator, user_data);
+	}
+#endif // CONFIG_PUB_SUB_RUNTIME_ALLOCATORS
+}
+
+void *pub_sub_allocator_stats_allocate(struct pub_sub_allocator *allocator, uint16_t msg_id,
+				       size_t msg_size_bytes, k_timeout_t timeout)
+{
+	struct pub_sub_allocator_counters *counters = get_counters(allocator);
+	// Only the time spent waiting for a message to be freed is counted as blocked, so the
+	// allocation is tried without waiting first
+	void *msg = allocator->allocate(allocator->impl, msg_size_bytes, K_NO_WAIT);
+	if ((msg == NULL) && !K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+		uint64_t start_ns = blocked_timestamp_ns();
+		msg = allocator->allocate(allocator->impl, msg_size_bytes, timeout);
+		uint64_t blocked_ns = blocked_timestamp_ns() - start_ns;
+		K_SPINLOCK(&counters->lock) {
+			counters->blocked_ns += blocked_ns;
+		}
+	}
+	if (msg == NULL) {
+		atomic_inc(&counters->failures);
+		return NULL;
+	}
+	atomic_inc(&counters->allocations);
+	atomic_inc(&counters->live_msgs[live_msgs_index(msg_id)]);
+	atomic_val_t in_use = atomic_inc(&counters->in_use) + 1;
+	atomic_val_t peak = atomic_get(&counters->peak_in_use);
+	while (in_use > peak && !atomic_cas(&counters->peak_in_use, peak, in_use)) {
+		peak = atomic_get(&counters->peak_in_use);
+	}
+	return msg;
+}
+
+void pub_sub_allocator_stats_record_free(const struct pub_sub_allocator *allocator,
+					 uint16_t msg_id)
+{
+	struct pub_sub_allocator_counters *counters = get_counters(allocator);
+	atomic_dec(&counters->live_msgs[live_msgs_index(msg_id)]);
+	atomic_dec(&counters->in_use);
+}
+
+static struct pub_sub_allocator_counters *get_counters(const struct pub_sub_allocator *allocator)
+{
+	// A runtime allocator is only given its counters when it is added
+	__ASSERT(allocator->allocator_id != PUB_SUB_ALLOC_ID_INVALID, "");
+	__ASSERT(allocator->counters != NULL, "");
+	return allocator->counters;
+}
+
+static size_t live_msgs_index(uint16_t msg_id)
+{
+	return MIN(msg_id, LIVE_MSGS_OTHER_INDEX);
+}
+
+// A 64 bit timestamp so that long waits can not wrap around
+static uint64_t blocked_timestamp_ns(void)
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+	return k_cyc_to_ns_floor64(k_cycle_get_64());
+#else
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+#endif // CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+}
\ No newline at end of file
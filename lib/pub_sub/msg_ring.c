@@ -0,0 +1,108 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_ring.h>
+#include <pub_sub/msg_alloc.h>
+
+static size_t reserve_slots(struct pub_sub_msg_ring *ring, size_t num_msgs, atomic_val_t *head);
+static void *take_msg(struct pub_sub_msg_ring *ring);
+
+void pub_sub_msg_ring_init(struct pub_sub_msg_ring *ring, atomic_ptr_t *slots, size_t num_msgs)
+{
+	__ASSERT(ring != NULL, "");
+	__ASSERT(slots != NULL, "");
+	__ASSERT(IS_POWER_OF_TWO(num_msgs), "Message ring size must be a power of 2");
+	for (size_t i = 0; i < num_msgs; i++) {
+		atomic_ptr_set(&slots[i], NULL);
+	}
+	ring->slots = slots;
+	ring->mask = num_msgs - 1;
+	atomic_set(&ring->head, 0);
+	atomic_set(&ring->tail, 0);
+	atomic_set(&ring->dropped, 0);
+	k_sem_init(&ring->signal, 0, 1);
+}
+
+int pub_sub_msg_ring_put(struct pub_sub_msg_ring *ring, void *msg)
+{
+	__ASSERT(ring != NULL, "");
+	__ASSERT(msg != NULL, "");
+	atomic_val_t head;
+	if (reserve_slots(ring, 1, &head) == 0) {
+		atomic_inc(&ring->dropped);
+		pub_sub_release_msg(msg);
+		return -ENOBUFS;
+	}
+	atomic_ptr_set(&ring->slots[head & ring->mask], msg);
+	k_sem_give(&ring->signal);
+	return 0;
+}
+
+size_t pub_sub_msg_ring_put_list(struct pub_sub_msg_ring *ring, sys_slist_t *list)
+{
+	__ASSERT(ring != NULL, "");
+	__ASSERT(list != NULL, "");
+	atomic_val_t head;
+	size_t num_reserved = reserve_slots(ring, sys_slist_len(list), &head);
+	for (size_t i = 0; i < num_reserved; i++) {
+		atomic_ptr_set(&ring->slots[(head + i) & ring->mask], pub_sub_msg_list_get(list));
+	}
+	if (num_reserved > 0) {
+		k_sem_give(&ring->signal);
+	}
+	void *msg = pub_sub_msg_list_get(list);
+	while (msg != NULL) {
+		atomic_inc(&ring->dropped);
+		pub_sub_release_msg(msg);
+		msg = pub_sub_msg_list_get(list);
+	}
+	return num_reserved;
+}
+
+void *pub_sub_msg_ring_get(struct pub_sub_msg_ring *ring, k_timeout_t timeout)
+{
+	__ASSERT(ring != NULL, "");
+	void *msg = take_msg(ring);
+	// A producer gives the semaphore after storing its message so the ring is checked again
+	// every time the semaphore is taken. This also leaves the semaphore empty whenever NULL is
+	// returned so polling on it only reports new messages.
+	while (msg == NULL) {
+		if (k_sem_take(&ring->signal, timeout) != 0) {
+			break;
+		}
+		msg = take_msg(ring);
+	}
+	return msg;
+}
+
+// Reserves up to 'num_msgs' consecutive slots starting at 'head', returns the number reserved
+static size_t reserve_slots(struct pub_sub_msg_ring *ring, size_t num_msgs, atomic_val_t *head)
+{
+	size_t num_reserved;
+	do {
+		// The tail is read first so that it can not have passed the head that is read after
+		// it. The consumer only advances the tail after it has emptied the slot, so any slot
+		// within the ring size of the tail is guaranteed to be empty.
+		atomic_val_t tail = atomic_get(&ring->tail);
+		*head = atomic_get(&ring->head);
+		uint32_t num_used = *head - tail;
+		uint32_t num_free = num_used > (uint32_t)ring->mask ? 0 : ring->mask + 1 - num_used;
+		num_reserved = MIN(num_msgs, num_free);
+		if (num_reserved == 0) {
+			return 0;
+		}
+	} while (!atomic_cas(&ring->head, *head, *head + num_reserved));
+	return num_reserved;
+}
+
+static void *take_msg(struct pub_sub_msg_ring *ring)
+{
+	atomic_val_t tail = atomic_get(&ring->tail);
+	// An empty slot is either the end of the ring or a slot that has been reserved by a
+	// producer that has not stored its message yet, in both cases there is nothing to take
+	void *msg = atomic_ptr_clear(&ring->slots[tail & ring->mask]);
+	if (msg != NULL) {
+		atomic_set(&ring->tail, tail + 1);
+	}
+	return msg;
+}
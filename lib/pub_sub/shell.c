@@ -0,0 +1,147 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <zephyr/shell/shell.h>
+#include <inttypes.h>
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+#include <pub_sub/msg_alloc_stats.h>
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
+
+#ifdef CONFIG_PUB_SUB_STATS
+static const char *const rx_type_names[] = {
+	[PUB_SUB_RX_TYPE_CALLBACK] = "callback",
+	[PUB_SUB_RX_TYPE_MSGQ] = "msgq",
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	[PUB_SUB_RX_TYPE_GROUP] = "group",
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	[PUB_SUB_RX_TYPE_FIFO] = "fifo",
+};
+
+static void print_broker_stats(struct pub_sub_broker *broker, void *user_data)
+{
+	const struct shell *sh = user_data;
+	struct pub_sub_broker_stats broker_stats;
+	struct pub_sub_subscriber_stats sub_stats;
+	struct pub_sub_subscriber *subscriber;
+
+	pub_sub_broker_stats_get(broker, &broker_stats);
+	shell_print(sh, "broker %p: dispatched %" PRIu32 ", msgq blocked %" PRIu64 " us", (void *)broker,
+		    broker_stats.msgs_dispatched, broker_stats.msgq_blocked_ns / NSEC_PER_USEC);
+	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
+	SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, subscriber, sub_list_node) {
+		pub_sub_subscriber_stats_get(subscriber, &sub_stats);
+		shell_print(sh,
+			    "  %s %p prio %u: queued %" PRIu32 ", depth %" PRIu32 ", peak %" PRIu32
+			    ", msgq blocked %" PRIu64 " us, handled %" PRIu32 ", handler %" PRIu64
+			    " us",
+			    rx_type_names[subscriber->rx_type], (void *)subscriber,
+			    subscriber->priority, sub_stats.msgs_queued, sub_stats.queue_depth,
+			    sub_stats.queue_peak, sub_stats.msgq_blocked_ns / NSEC_PER_USEC,
+			    sub_stats.handler_calls, sub_stats.handler_ns / NSEC_PER_USEC);
+	}
+	k_mutex_unlock(&broker->sub_list_mutex);
+}
+
+static void reset_broker_stats(struct pub_sub_broker *broker, void *user_data)
+{
+	ARG_UNUSED(user_data);
+	struct pub_sub_subscriber *subscriber;
+
+	pub_sub_broker_stats_reset(broker);
+	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
+	SYS_SLIST_FOR_EACH_CONTAINER(&broker->subscribers, subscriber, sub_list_node) {
+		pub_sub_subscriber_stats_reset(subscriber);
+	}
+	k_mutex_unlock(&broker->sub_list_mutex);
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	pub_sub_stats_foreach_broker(print_broker_stats, (void *)sh);
+	return 0;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	pub_sub_stats_foreach_broker(reset_broker_stats, NULL);
+	shell_print(sh, "Statistics reset");
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_pub_sub_stats,
+			       SHELL_CMD(reset, NULL, "Reset all statistics", cmd_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+#endif // CONFIG_PUB_SUB_STATS
+
+#ifdef CONFIG_PUB_SUB_ALLOCATOR_STATS
+static void print_allocator_stats(const struct pub_sub_allocator *allocator, void *user_data)
+{
+	const struct shell *sh = user_data;
+	struct pub_sub_allocator_stats stats;
+
+	pub_sub_allocator_stats_get(allocator, &stats);
+	shell_print(sh,
+		    "allocator %u %p: in use %" PRIu32 ", peak %" PRIu32 ", allocations %" PRIu32
+		    ", failures %" PRIu32 ", blocked %" PRIu64 " us",
+		    pub_sub_allocator_get_id(allocator), (void *)allocator, stats.in_use,
+		    stats.peak_in_use, stats.allocations, stats.failures,
+		    stats.blocked_ns / NSEC_PER_USEC);
+	for (uint16_t msg_id = 0; msg_id <= CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID; msg_id++) {
+		uint32_t live_msgs = pub_sub_allocator_stats_live_msgs(allocator, msg_id);
+		if (live_msgs > 0) {
+			shell_print(sh, "  msg id %u: %" PRIu32 " live", msg_id, live_msgs);
+		}
+	}
+	uint32_t other_live_msgs = pub_sub_allocator_stats_live_msgs(
+		allocator, CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID + 1);
+	if (other_live_msgs > 0) {
+		shell_print(sh, "  msg ids > %u: %" PRIu32 " live",
+			    CONFIG_PUB_SUB_ALLOCATOR_STATS_MAX_MSG_ID, other_live_msgs);
+	}
+}
+
+static void reset_allocator_stats(const struct pub_sub_allocator *allocator, void *user_data)
+{
+	ARG_UNUSED(user_data);
+	pub_sub_allocator_stats_reset(allocator);
+}
+
+static int cmd_allocators(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	pub_sub_allocator_stats_foreach(print_allocator_stats, (void *)sh);
+	return 0;
+}
+
+static int cmd_allocators_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	pub_sub_allocator_stats_foreach(reset_allocator_stats, NULL);
+	shell_print(sh, "Allocator statistics reset");
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_pub_sub_allocators,
+			       SHELL_CMD(print, NULL, "Print message allocator statistics",
+					 cmd_allocators),
+			       SHELL_CMD(reset, NULL, "Reset all allocator statistics",
+					 cmd_allocators_reset),
+			       SHELL_SUBCMD_SET_END);
+#endif // CONFIG_PUB_SUB_ALLOCATOR_STATS
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+	sub_pub_sub,
+	SHELL_COND_CMD(CONFIG_PUB_SUB_STATS, stats, &sub_pub_sub_stats,
+		       "Print broker and subscriber statistics", cmd_stats),
+	SHELL_COND_CMD(CONFIG_PUB_SUB_ALLOCATOR_STATS, allocators, &sub_pub_sub_allocators,
+		       "Print message allocator statistics", cmd_allocators),
+	SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(pub_sub, &sub_pub_sub, "Publish subscribe commands", NULL);
\ No newline at end of file
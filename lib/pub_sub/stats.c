@@ -0,0 +1,132 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <string.h>
+
+static uint32_t queue_depth(struct pub_sub_subscriber *subscriber);
+static void update_queue_peak(struct pub_sub_subscriber_stats *stats, uint32_t queue_depth);
+
+// Every broker that has been initialized, brokers are never removed
+static sys_slist_t brokers = SYS_SLIST_STATIC_INIT(&brokers);
+static K_MUTEX_DEFINE(brokers_mutex);
+
+void pub_sub_broker_stats_get(struct pub_sub_broker *broker, struct pub_sub_broker_stats *stats)
+{
+	__ASSERT(broker != NULL, "");
+	__ASSERT(stats != NULL, "");
+	K_SPINLOCK(&broker->stats_lock) {
+		*stats = broker->stats;
+	}
+}
+
+void pub_sub_broker_stats_reset(struct pub_sub_broker *broker)
+{
+	__ASSERT(broker != NULL, "");
+	K_SPINLOCK(&broker->stats_lock) {
+		memset(&broker->stats, 0, sizeof(broker->stats));
+	}
+}
+
+void pub_sub_subscriber_stats_get(struct pub_sub_subscriber *subscriber,
+				  struct pub_sub_subscriber_stats *stats)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(stats != NULL, "");
+	K_SPINLOCK(&subscriber->stats_lock) {
+		*stats = subscriber->stats;
+	}
+	stats->queue_depth = queue_depth(subscriber);
+}
+
+void pub_sub_subscriber_stats_reset(struct pub_sub_subscriber *subscriber)
+{
+	__ASSERT(subscriber != NULL, "");
+	K_SPINLOCK(&subscriber->stats_lock) {
+		memset(&subscriber->stats, 0, sizeof(subscriber->stats));
+		subscriber->stats.queue_peak = queue_depth(subscriber);
+	}
+}
+
+void pub_sub_stats_foreach_broker(void (*fn)(struct pub_sub_broker *broker, void *user_data),
+				  void *user_data)
+{
+	__ASSERT(fn != NULL, "");
+	struct pub_sub_broker *broker;
+	k_mutex_lock(&brokers_mutex, K_FOREVER);
+	SYS_SLIST_FOR_EACH_CONTAINER(&brokers, broker, stats_node) {
+		fn(broker, user_data);
+	}
+	k_mutex_unlock(&brokers_mutex);
+}
+
+void pub_sub_stats_register_broker(struct pub_sub_broker *broker)
+{
+	__ASSERT(broker != NULL, "");
+	sys_snode_t *prev;
+	k_mutex_lock(&brokers_mutex, K_FOREVER);
+	// A broker can be initialized more than once
+	if (!sys_slist_find(&brokers, &broker->stats_node, &prev)) {
+		sys_slist_append(&brokers, &broker->stats_node);
+	}
+	k_mutex_unlock(&brokers_mutex);
+}
+
+void pub_sub_stats_record_dispatch(struct pub_sub_broker *broker, size_t num_msgs)
+{
+	K_SPINLOCK(&broker->stats_lock) {
+		broker->stats.msgs_dispatched += num_msgs;
+	}
+}
+
+void pub_sub_stats_record_queued(struct pub_sub_subscriber *subscriber)
+{
+	K_SPINLOCK(&subscriber->stats_lock) {
+		struct pub_sub_subscriber_stats *stats = &subscriber->stats;
+		stats->msgs_queued++;
+		update_queue_peak(stats, queue_depth(subscriber));
+	}
+}
+
+void pub_sub_stats_record_msgq_blocked(struct pub_sub_subscriber *subscriber, uint32_t cycles)
+{
+	uint64_t blocked_ns = k_cyc_to_ns_floor64(cycles);
+	K_SPINLOCK(&subscriber->stats_lock) {
+		subscriber->stats.msgq_blocked_ns += blocked_ns;
+	}
+	struct pub_sub_broker *broker = subscriber->broker;
+	if (broker != NULL) {
+		K_SPINLOCK(&broker->stats_lock) {
+			broker->stats.msgq_blocked_ns += blocked_ns;
+		}
+	}
+}
+
+void pub_sub_stats_record_handler(struct pub_sub_subscriber *subscriber, uint32_t cycles)
+{
+	uint64_t handler_ns = k_cyc_to_ns_floor64(cycles);
+	K_SPINLOCK(&subscriber->stats_lock) {
+		subscriber->stats.handler_calls++;
+		subscriber->stats.handler_ns += handler_ns;
+	}
+}
+
+// The depth of a fifo subscriber is the same counter that subscriber groups read
+static uint32_t queue_depth(struct pub_sub_subscriber *subscriber)
+{
+	switch (subscriber->rx_type) {
+	case PUB_SUB_RX_TYPE_MSGQ:
+		return k_msgq_num_used_get(subscriber->msgq);
+	case PUB_SUB_RX_TYPE_FIFO:
+		return atomic_get(&subscriber->fifo_depth);
+	default:
+		return 0;
+	}
+}
+
+static void update_queue_peak(struct pub_sub_subscriber_stats *stats, uint32_t queue_depth)
+{
+	if (queue_depth > stats->queue_peak) {
+		stats->queue_peak = queue_depth;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,466 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/subs_set.h>
+#include <zephyr/sys/barrier.h>
+#include <string.h>
+
+#define CHUNK_KEY(msg_id) ((msg_id) / PUB_SUB_SUBS_CHUNK_NUM_IDS)
+#define CHUNK_BIT(msg_id) ((msg_id) % PUB_SUB_SUBS_CHUNK_NUM_IDS)
+
+// One of the two copies of a set's entries
+struct subs_copy {
+	union {
+		void *entries;
+		uint16_t *ids;
+		struct pub_sub_subs_range *ranges;
+		struct pub_sub_subs_chunk *chunks;
+	};
+	uint16_t num_entries;
+	uint16_t max_entries;
+	uint8_t index;
+};
+
+static struct subs_copy get_copy(struct pub_sub_subs_set *subs_set, uint8_t index);
+static void begin_modify(struct pub_sub_subs_set *subs_set, struct subs_copy *copy);
+static void end_modify(struct pub_sub_subs_set *subs_set, struct subs_copy *copy, bool changed);
+static size_t entry_num_bytes(enum pub_sub_subs_set_type type);
+static int update_each_id(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id,
+			  int (*update)(struct subs_copy *copy, uint16_t msg_id));
+static int sorted_array_add(struct subs_copy *copy, uint16_t msg_id);
+static int sorted_array_remove(struct subs_copy *copy, uint16_t msg_id);
+static bool sorted_array_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+				      uint16_t last_msg_id);
+static uint16_t sorted_array_find(struct subs_copy *copy, uint16_t msg_id);
+static int range_list_add(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id);
+static int range_list_remove(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id);
+static bool range_list_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+				    uint16_t last_msg_id);
+static uint16_t range_list_find(struct subs_copy *copy, uint16_t msg_id);
+static int chunked_bitmap_add(struct subs_copy *copy, uint16_t msg_id);
+static int chunked_bitmap_remove(struct subs_copy *copy, uint16_t msg_id);
+static bool chunked_bitmap_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+					uint16_t last_msg_id);
+static uint16_t chunked_bitmap_find(struct subs_copy *copy, uint16_t key);
+static bool insert_entry(struct subs_copy *copy, void *entries, size_t entry_size, uint16_t i);
+static void remove_entries(struct subs_copy *copy, void *entries, size_t entry_size, uint16_t i,
+			   uint16_t num);
+
+void pub_sub_subs_set_init(struct pub_sub_subs_set *subs_set, enum pub_sub_subs_set_type type,
+			   void *storage, uint16_t max_entries)
+{
+	__ASSERT(subs_set != NULL, "");
+	__ASSERT(storage != NULL, "");
+	k_mutex_init(&subs_set->mutex);
+	subs_set->type = type;
+	atomic_set(&subs_set->published, 0);
+	atomic_set(&subs_set->seqs[0], 0);
+	atomic_set(&subs_set->seqs[1], 0);
+	subs_set->num_entries[0] = 0;
+	subs_set->num_entries[1] = 0;
+	subs_set->max_entries = max_entries;
+	switch (type) {
+	case PUB_SUB_SUBS_SET_SORTED_ARRAY:
+		subs_set->ids = storage;
+		break;
+	case PUB_SUB_SUBS_SET_RANGE_LIST:
+		subs_set->ranges = storage;
+		break;
+	case PUB_SUB_SUBS_SET_CHUNKED_BITMAP:
+		subs_set->chunks = storage;
+		break;
+	}
+}
+
+int pub_sub_subs_set_add(struct pub_sub_subs_set *subs_set, uint16_t msg_id)
+{
+	return pub_sub_subs_set_add_range(subs_set, msg_id, msg_id);
+}
+
+int pub_sub_subs_set_remove(struct pub_sub_subs_set *subs_set, uint16_t msg_id)
+{
+	return pub_sub_subs_set_remove_range(subs_set, msg_id, msg_id);
+}
+
+int pub_sub_subs_set_add_range(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+			       uint16_t last_msg_id)
+{
+	__ASSERT(subs_set != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	__ASSERT(!k_is_in_isr(), "");
+	int ret = 0;
+	struct subs_copy copy;
+	k_mutex_lock(&subs_set->mutex, K_FOREVER);
+	begin_modify(subs_set, &copy);
+	switch (subs_set->type) {
+	case PUB_SUB_SUBS_SET_SORTED_ARRAY:
+		ret = update_each_id(&copy, first_msg_id, last_msg_id, sorted_array_add);
+		break;
+	case PUB_SUB_SUBS_SET_RANGE_LIST:
+		ret = range_list_add(&copy, first_msg_id, last_msg_id);
+		break;
+	case PUB_SUB_SUBS_SET_CHUNKED_BITMAP:
+		ret = update_each_id(&copy, first_msg_id, last_msg_id, chunked_bitmap_add);
+		break;
+	}
+	end_modify(subs_set, &copy, ret == 1);
+	k_mutex_unlock(&subs_set->mutex);
+	return ret;
+}
+
+int pub_sub_subs_set_remove_range(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+				  uint16_t last_msg_id)
+{
+	__ASSERT(subs_set != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	__ASSERT(!k_is_in_isr(), "");
+	int ret = 0;
+	struct subs_copy copy;
+	k_mutex_lock(&subs_set->mutex, K_FOREVER);
+	begin_modify(subs_set, &copy);
+	switch (subs_set->type) {
+	case PUB_SUB_SUBS_SET_SORTED_ARRAY:
+		ret = update_each_id(&copy, first_msg_id, last_msg_id, sorted_array_remove);
+		break;
+	case PUB_SUB_SUBS_SET_RANGE_LIST:
+		ret = range_list_remove(&copy, first_msg_id, last_msg_id);
+		break;
+	case PUB_SUB_SUBS_SET_CHUNKED_BITMAP:
+		ret = update_each_id(&copy, first_msg_id, last_msg_id, chunked_bitmap_remove);
+		break;
+	}
+	end_modify(subs_set, &copy, ret == 1);
+	k_mutex_unlock(&subs_set->mutex);
+	return ret;
+}
+
+bool pub_sub_subs_set_contains(struct pub_sub_subs_set *subs_set, uint16_t msg_id)
+{
+	return pub_sub_subs_set_contains_any(subs_set, msg_id, msg_id);
+}
+
+bool pub_sub_subs_set_contains_any(struct pub_sub_subs_set *subs_set, uint16_t first_msg_id,
+				   uint16_t last_msg_id)
+{
+	__ASSERT(subs_set != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	bool ret = false;
+	atomic_val_t seq;
+	struct subs_copy copy;
+	// The published copy is only written once a later modification starts reusing it, which
+	// changes its sequence, so a lookup that overlaps with that is repeated on the new copy
+	do {
+		uint8_t index = atomic_get(&subs_set->published);
+		seq = atomic_get(&subs_set->seqs[index]);
+		copy = get_copy(subs_set, index);
+		switch (subs_set->type) {
+		case PUB_SUB_SUBS_SET_SORTED_ARRAY:
+			ret = sorted_array_contains_any(&copy, first_msg_id, last_msg_id);
+			break;
+		case PUB_SUB_SUBS_SET_RANGE_LIST:
+			ret = range_list_contains_any(&copy, first_msg_id, last_msg_id);
+			break;
+		case PUB_SUB_SUBS_SET_CHUNKED_BITMAP:
+			ret = chunked_bitmap_contains_any(&copy, first_msg_id, last_msg_id);
+			break;
+		}
+		// The entries must be read before the sequence is checked again
+		barrier_dmem_fence_full();
+	} while (((seq & 1) != 0) || (atomic_get(&subs_set->seqs[copy.index]) != seq));
+	return ret;
+}
+
+static struct subs_copy get_copy(struct pub_sub_subs_set *subs_set, uint8_t index)
+{
+	uint16_t max_entries = subs_set->max_entries;
+	size_t copy_num_bytes = max_entries * entry_num_bytes(subs_set->type);
+	struct subs_copy copy = {
+		.entries = (uint8_t *)subs_set->ids + index * copy_num_bytes,
+		// Bounded so that reading a copy while it is being written stays within the storage
+		.num_entries = MIN(subs_set->num_entries[index], max_entries),
+		.max_entries = max_entries,
+		.index = index,
+	};
+	return copy;
+}
+
+// Copies the published entries into the other copy so that they can be modified while lookups
+// continue to read the published copy
+static void begin_modify(struct pub_sub_subs_set *subs_set, struct subs_copy *copy)
+{
+	uint8_t published = atomic_get(&subs_set->published);
+	struct subs_copy published_copy = get_copy(subs_set, published);
+	*copy = get_copy(subs_set, published ^ 1);
+	// Lookups that were overtaken by an earlier modification may still be reading this copy
+	atomic_inc(&subs_set->seqs[copy->index]);
+	memcpy(copy->entries, published_copy.entries,
+	       published_copy.num_entries * entry_num_bytes(subs_set->type));
+	copy->num_entries = published_copy.num_entries;
+}
+
+// Publishes the modified copy if it changed. A modification that failed part way through is not
+// published so that the set is left as it was.
+static void end_modify(struct pub_sub_subs_set *subs_set, struct subs_copy *copy, bool changed)
+{
+	subs_set->num_entries[copy->index] = copy->num_entries;
+	atomic_inc(&subs_set->seqs[copy->index]);
+	if (changed) {
+		atomic_set(&subs_set->published, copy->index);
+	}
+}
+
+static size_t entry_num_bytes(enum pub_sub_subs_set_type type)
+{
+	switch (type) {
+	case PUB_SUB_SUBS_SET_SORTED_ARRAY:
+		return sizeof(uint16_t);
+	case PUB_SUB_SUBS_SET_RANGE_LIST:
+		return sizeof(struct pub_sub_subs_range);
+	case PUB_SUB_SUBS_SET_CHUNKED_BITMAP:
+		return sizeof(struct pub_sub_subs_chunk);
+	}
+	return 0;
+}
+
+// Applies 'update' to each id in the range, returns 1 if any of them changed the set
+static int update_each_id(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id,
+			  int (*update)(struct subs_copy *copy, uint16_t msg_id))
+{
+	int changed = 0;
+	for (uint32_t msg_id = first_msg_id; msg_id <= last_msg_id; msg_id++) {
+		int ret = update(copy, msg_id);
+		if (ret < 0) {
+			return ret;
+		}
+		changed |= ret;
+	}
+	return changed;
+}
+
+static int sorted_array_add(struct subs_copy *copy, uint16_t msg_id)
+{
+	uint16_t i = sorted_array_find(copy, msg_id);
+	if ((i < copy->num_entries) && (copy->ids[i] == msg_id)) {
+		return 0;
+	}
+	if (!insert_entry(copy, copy->ids, sizeof(copy->ids[0]), i)) {
+		return -ENOMEM;
+	}
+	copy->ids[i] = msg_id;
+	return 1;
+}
+
+static int sorted_array_remove(struct subs_copy *copy, uint16_t msg_id)
+{
+	uint16_t i = sorted_array_find(copy, msg_id);
+	if ((i == copy->num_entries) || (copy->ids[i] != msg_id)) {
+		return 0;
+	}
+	remove_entries(copy, copy->ids, sizeof(copy->ids[0]), i, 1);
+	return 1;
+}
+
+static bool sorted_array_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+				      uint16_t last_msg_id)
+{
+	uint16_t i = sorted_array_find(copy, first_msg_id);
+	return (i < copy->num_entries) && (copy->ids[i] <= last_msg_id);
+}
+
+// Returns the index of the first id that is not less than 'msg_id'
+static uint16_t sorted_array_find(struct subs_copy *copy, uint16_t msg_id)
+{
+	uint16_t low = 0;
+	uint16_t high = copy->num_entries;
+	while (low < high) {
+		uint16_t mid = low + (high - low) / 2;
+		if (copy->ids[mid] < msg_id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// Merges the range with the ranges that it overlaps or is next to so that they share an entry
+static int range_list_add(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id)
+{
+	struct pub_sub_subs_range *ranges = copy->ranges;
+	uint16_t i = range_list_find(copy, (first_msg_id > 0) ? first_msg_id - 1 : 0);
+	uint16_t j = i;
+	while ((j < copy->num_entries) && (ranges[j].first <= (uint32_t)last_msg_id + 1)) {
+		j++;
+	}
+	if (i == j) {
+		if (!insert_entry(copy, ranges, sizeof(ranges[0]), i)) {
+			return -ENOMEM;
+		}
+		ranges[i].first = first_msg_id;
+		ranges[i].last = last_msg_id;
+		return 1;
+	}
+	if ((j == i + 1) && (ranges[i].first <= first_msg_id) && (ranges[i].last >= last_msg_id)) {
+		return 0;
+	}
+	ranges[i].first = MIN(ranges[i].first, first_msg_id);
+	ranges[i].last = MAX(ranges[j - 1].last, last_msg_id);
+	remove_entries(copy, ranges, sizeof(ranges[0]), i + 1, j - i - 1);
+	return 1;
+}
+
+// Trims the ranges that overlap either end of the removed range and removes those within it
+static int range_list_remove(struct subs_copy *copy, uint16_t first_msg_id, uint16_t last_msg_id)
+{
+	struct pub_sub_subs_range *ranges = copy->ranges;
+	uint16_t i = range_list_find(copy, first_msg_id);
+	if ((i == copy->num_entries) || (ranges[i].first > last_msg_id)) {
+		return 0;
+	}
+	if ((ranges[i].first < first_msg_id) && (ranges[i].last > last_msg_id)) {
+		// Removing ids from the middle of a range splits it in two
+		if (!insert_entry(copy, ranges, sizeof(ranges[0]), i + 1)) {
+			return -ENOMEM;
+		}
+		ranges[i + 1].first = last_msg_id + 1;
+		ranges[i + 1].last = ranges[i].last;
+		ranges[i].last = first_msg_id - 1;
+		return 1;
+	}
+	if (ranges[i].first < first_msg_id) {
+		ranges[i].last = first_msg_id - 1;
+		i++;
+	}
+	uint16_t j = i;
+	while ((j < copy->num_entries) && (ranges[j].last <= last_msg_id)) {
+		j++;
+	}
+	if ((j < copy->num_entries) && (ranges[j].first <= last_msg_id)) {
+		ranges[j].first = last_msg_id + 1;
+	}
+	remove_entries(copy, ranges, sizeof(ranges[0]), i, j - i);
+	return 1;
+}
+
+static bool range_list_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+				    uint16_t last_msg_id)
+{
+	uint16_t i = range_list_find(copy, first_msg_id);
+	return (i < copy->num_entries) && (copy->ranges[i].first <= last_msg_id);
+}
+
+// Returns the index of the first range that ends at or after 'msg_id'
+static uint16_t range_list_find(struct subs_copy *copy, uint16_t msg_id)
+{
+	uint16_t low = 0;
+	uint16_t high = copy->num_entries;
+	while (low < high) {
+		uint16_t mid = low + (high - low) / 2;
+		if (copy->ranges[mid].last < msg_id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+static int chunked_bitmap_add(struct subs_copy *copy, uint16_t msg_id)
+{
+	struct pub_sub_subs_chunk *chunks = copy->chunks;
+	uint16_t key = CHUNK_KEY(msg_id);
+	uint16_t i = chunked_bitmap_find(copy, key);
+	if ((i == copy->num_entries) || (chunks[i].key != key)) {
+		if (!insert_entry(copy, chunks, sizeof(chunks[0]), i)) {
+			return -ENOMEM;
+		}
+		memset(&chunks[i], 0, sizeof(chunks[i]));
+		chunks[i].key = key;
+	}
+	uint16_t bit = CHUNK_BIT(msg_id);
+	if ((chunks[i].bits[bit / 32] & BIT(bit % 32)) != 0) {
+		return 0;
+	}
+	chunks[i].bits[bit / 32] |= BIT(bit % 32);
+	return 1;
+}
+
+static int chunked_bitmap_remove(struct subs_copy *copy, uint16_t msg_id)
+{
+	struct pub_sub_subs_chunk *chunks = copy->chunks;
+	uint16_t key = CHUNK_KEY(msg_id);
+	uint16_t i = chunked_bitmap_find(copy, key);
+	uint16_t bit = CHUNK_BIT(msg_id);
+	if ((i == copy->num_entries) || (chunks[i].key != key) ||
+	    ((chunks[i].bits[bit / 32] & BIT(bit % 32)) == 0)) {
+		return 0;
+	}
+	chunks[i].bits[bit / 32] &= ~BIT(bit % 32);
+	// Empty chunks are removed so that the space can be used for another chunk
+	for (size_t j = 0; j < ARRAY_SIZE(chunks[i].bits); j++) {
+		if (chunks[i].bits[j] != 0) {
+			return 1;
+		}
+	}
+	remove_entries(copy, chunks, sizeof(chunks[0]), i, 1);
+	return 1;
+}
+
+// Only the chunks that overlap the range are checked, a word of bits at a time
+static bool chunked_bitmap_contains_any(struct subs_copy *copy, uint16_t first_msg_id,
+					uint16_t last_msg_id)
+{
+	struct pub_sub_subs_chunk *chunks = copy->chunks;
+	uint16_t last_key = CHUNK_KEY(last_msg_id);
+	for (uint16_t i = chunked_bitmap_find(copy, CHUNK_KEY(first_msg_id));
+	     (i < copy->num_entries) && (chunks[i].key <= last_key); i++) {
+		uint16_t first_bit = (chunks[i].key == CHUNK_KEY(first_msg_id))
+					     ? CHUNK_BIT(first_msg_id) : 0;
+		uint16_t last_bit = (chunks[i].key == last_key) ? CHUNK_BIT(last_msg_id)
+								 : PUB_SUB_SUBS_CHUNK_NUM_IDS - 1;
+		for (uint16_t word = first_bit / 32; word <= last_bit / 32; word++) {
+			uint32_t mask = GENMASK(MIN(last_bit, word * 32 + 31) % 32,
+						MAX(first_bit, word * 32) % 32);
+			if ((chunks[i].bits[word] & mask) != 0) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Returns the index of the first chunk whose key is not less than 'key'
+static uint16_t chunked_bitmap_find(struct subs_copy *copy, uint16_t key)
+{
+	uint16_t low = 0;
+	uint16_t high = copy->num_entries;
+	while (low < high) {
+		uint16_t mid = low + (high - low) / 2;
+		if (copy->chunks[mid].key < key) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// Makes space for a new entry at index 'i', returns false if the storage is full
+static bool insert_entry(struct subs_copy *copy, void *entries, size_t entry_size, uint16_t i)
+{
+	if (copy->num_entries == copy->max_entries) {
+		return false;
+	}
+	uint8_t *entry = (uint8_t *)entries + i * entry_size;
+	memmove(entry + entry_size, entry, (copy->num_entries - i) * entry_size);
+	copy->num_entries++;
+	return true;
+}
+
+static void remove_entries(struct subs_copy *copy, void *entries, size_t entry_size, uint16_t i,
+			   uint16_t num)
+{
+	uint8_t *entry = (uint8_t *)entries + i * entry_size;
+	copy->num_entries -= num;
+	memmove(entry, entry + num * entry_size, (copy->num_entries - i) * entry_size);
+}
\ No newline at end of file
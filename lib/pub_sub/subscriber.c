@@ -3,17 +3,59 @@
  */
 #include <pub_sub/pub_sub.h>
 #include <string.h>
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+#include <pub_sub/subscriber_group.h>
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+#include <pub_sub/executor.h>
+#endif // CONFIG_PUB_SUB_EXECUTOR
+
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+// Links a message into a fifo without using the fifo reserved word in the message's header, so a
+// message can be queued on every fifo subscriber at the same time
+struct fifo_envelope {
+	void *fifo_reserved;
+	void *msg;
+};
+
+K_MEM_SLAB_DEFINE_STATIC(fifo_envelope_slab, sizeof(struct fifo_envelope),
+			 CONFIG_PUB_SUB_FIFO_FANOUT_NUM_ENVELOPES, sizeof(void *));
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
 
 static void common_subscriber_init(struct pub_sub_subscriber *subscriber, atomic_t *subs_bitarray,
 				   uint16_t max_pub_msg_ids);
+static int update_subscriptions(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+				uint16_t last_msg_id, bool subscribe, bool *changed);
+static int add_bitmap_subscriptions(struct pub_sub_subscriber *subscriber, const atomic_t *bitmap,
+				    uint16_t max_msg_id, bool *changed);
+static bool update_bitarray_range(atomic_t *bitarray, uint16_t first_msg_id, uint16_t last_msg_id,
+				  bool set);
+static void update_broker_subscriptions(struct pub_sub_subscriber *subscriber,
+					uint16_t first_msg_id, uint16_t last_msg_id);
+#ifdef CONFIG_PUB_SUB_TOPICS
+static void update_prefix_subscription(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+				       uint8_t num_levels, bool subscribe);
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+static void add_filter(struct pub_sub_subscriber *subscriber, struct pub_sub_filter *filter,
+		       bool all_msg_ids, uint16_t msg_id, pub_sub_filter_fn filter_fn,
+		       void *user_data);
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+static void *fifo_get(struct pub_sub_subscriber *subscriber, k_timeout_t timeout);
+#ifndef CONFIG_PUB_SUB_FIFO_FANOUT
 static void send_to_next_fifo_subscriber(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
 					 void *msg);
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+static bool put_on_full_msgq(struct pub_sub_subscriber *subscriber, void *msg);
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+static void msgq_put_blocking(struct pub_sub_subscriber *subscriber, void *msg);
 
 void pub_sub_init_callback_subscriber(struct pub_sub_subscriber *subscriber,
 				      atomic_t *subs_bitarray, uint16_t max_pub_msg_id)
 {
 	__ASSERT(subscriber != NULL, "");
-	__ASSERT(subs_bitarray != NULL, "");
+	__ASSERT((subs_bitarray != NULL) || IS_ENABLED(CONFIG_PUB_SUB_SUBS_SETS), "");
 	common_subscriber_init(subscriber, subs_bitarray, max_pub_msg_id);
 	subscriber->rx_type = PUB_SUB_RX_TYPE_CALLBACK;
 }
@@ -23,21 +65,137 @@ void pub_sub_init_msgq_subscriber(struct pub_sub_subscriber *subscriber, atomic_
 {
 	__ASSERT(subscriber != NULL, "");
 	__ASSERT(msgq != NULL, "");
-	__ASSERT(subs_bitarray != NULL, "");
+	__ASSERT((subs_bitarray != NULL) || IS_ENABLED(CONFIG_PUB_SUB_SUBS_SETS), "");
 	common_subscriber_init(subscriber, subs_bitarray, max_pub_msg_id);
 	subscriber->msgq = msgq;
 	subscriber->rx_type = PUB_SUB_RX_TYPE_MSGQ;
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+	subscriber->msgq_overflow_policy = PUB_SUB_MSGQ_OVERFLOW_BLOCK;
+	subscriber->msgq_drop_level = 0;
+	atomic_set(&subscriber->msgq_dropped, 0);
+	atomic_set(&subscriber->msgq_blocked, 0);
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
 }
 
 void pub_sub_init_fifo_subscriber(struct pub_sub_subscriber *subscriber, atomic_t *subs_bitarray,
 				  uint16_t max_pub_msg_id)
 {
 	__ASSERT(subscriber != NULL, "");
-	__ASSERT(subs_bitarray != NULL, "");
+	__ASSERT((subs_bitarray != NULL) || IS_ENABLED(CONFIG_PUB_SUB_SUBS_SETS), "");
 	common_subscriber_init(subscriber, subs_bitarray, max_pub_msg_id);
 	k_fifo_init(&subscriber->fifo);
 	subscriber->rx_type = PUB_SUB_RX_TYPE_FIFO;
+#if defined(CONFIG_PUB_SUB_STATS) || defined(CONFIG_PUB_SUB_SUBSCRIBER_GROUPS)
+	atomic_set(&subscriber->fifo_depth, 0);
+#endif
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+	atomic_set(&subscriber->fifo_dropped, 0);
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+}
+
+int pub_sub_subscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id)
+{
+	return pub_sub_subscribe_range(subscriber, msg_id, msg_id);
+}
+
+int pub_sub_unsubscribe(struct pub_sub_subscriber *subscriber, uint16_t msg_id)
+{
+	return pub_sub_unsubscribe_range(subscriber, msg_id, msg_id);
+}
+
+int pub_sub_subscribe_range(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+			    uint16_t last_msg_id)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	__ASSERT(last_msg_id <= subscriber->max_pub_msg_id, "");
+	__ASSERT(!IS_ENABLED(CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING) || !k_is_in_isr(), "");
+	bool changed = false;
+	int ret = update_subscriptions(subscriber, first_msg_id, last_msg_id, true, &changed);
+	if (changed) {
+		update_broker_subscriptions(subscriber, first_msg_id, last_msg_id);
+	}
+	return ret;
+}
+
+int pub_sub_unsubscribe_range(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+			      uint16_t last_msg_id)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(first_msg_id <= last_msg_id, "");
+	__ASSERT(last_msg_id <= subscriber->max_pub_msg_id, "");
+	__ASSERT(!IS_ENABLED(CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING) || !k_is_in_isr(), "");
+	bool changed = false;
+	int ret = update_subscriptions(subscriber, first_msg_id, last_msg_id, false, &changed);
+	if (changed) {
+		update_broker_subscriptions(subscriber, first_msg_id, last_msg_id);
+	}
+	return ret;
+}
+
+int pub_sub_subscribe_bitmap(struct pub_sub_subscriber *subscriber, const atomic_t *bitmap,
+			     uint16_t max_msg_id)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(bitmap != NULL, "");
+	__ASSERT(max_msg_id <= subscriber->max_pub_msg_id, "");
+	__ASSERT(!IS_ENABLED(CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING) || !k_is_in_isr(), "");
+	bool changed = false;
+	int ret = add_bitmap_subscriptions(subscriber, bitmap, max_msg_id, &changed);
+	// A subscription set can fill part way through the bitmap so the broker is updated even when
+	// an error is returned
+	if (changed) {
+		update_broker_subscriptions(subscriber, 0, max_msg_id);
+	}
+	return ret;
+}
+
+void pub_sub_subscribe_from_template(struct pub_sub_subscriber *subscriber,
+				     const atomic_t *subs_template)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(subs_template != NULL, "");
+	__ASSERT(subscriber->broker == NULL, "");
+	__ASSERT(subscriber->subs_bitarray != NULL, "");
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	__ASSERT(subscriber->subs_set == NULL, "");
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+	// The subscriber is not on a broker yet, its routes are built when it is added
+	memcpy(subscriber->subs_bitarray, subs_template,
+	       PUB_SUB_SUBS_BITARRAY_BYTE_LEN(subscriber->max_pub_msg_id));
+}
+
+#ifdef CONFIG_PUB_SUB_TOPICS
+void pub_sub_subscribe_prefix(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+			      uint8_t num_levels)
+{
+	__ASSERT(subscriber != NULL, "");
+	update_prefix_subscription(subscriber, msg_id, num_levels, true);
+}
+
+void pub_sub_unsubscribe_prefix(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+				uint8_t num_levels)
+{
+	__ASSERT(subscriber != NULL, "");
+	update_prefix_subscription(subscriber, msg_id, num_levels, false);
+}
+#endif // CONFIG_PUB_SUB_TOPICS
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+void pub_sub_subscriber_add_filter(struct pub_sub_subscriber *subscriber,
+				   struct pub_sub_filter *filter, pub_sub_filter_fn filter_fn,
+				   void *user_data)
+{
+	add_filter(subscriber, filter, true, 0, filter_fn, user_data);
+}
+
+void pub_sub_subscriber_add_msg_filter(struct pub_sub_subscriber *subscriber,
+				       struct pub_sub_filter *filter, uint16_t msg_id,
+				       pub_sub_filter_fn filter_fn, void *user_data)
+{
+	add_filter(subscriber, filter, false, msg_id, filter_fn, user_data);
 }
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
 
 int pub_sub_populate_poll_evt(struct pub_sub_subscriber *subscriber, struct k_poll_event *poll_evt)
 {
@@ -49,6 +207,13 @@ int pub_sub_populate_poll_evt(struct pub_sub_subscriber *subscriber, struct k_po
 		ret = -EPERM;
 		break;
 	}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	case PUB_SUB_RX_TYPE_GROUP: {
+		// Messages are queued on the group's members
+		ret = -EPERM;
+		break;
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 	case PUB_SUB_RX_TYPE_MSGQ: {
 		k_poll_event_init(poll_evt, K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
 				  K_POLL_MODE_NOTIFY_ONLY, subscriber->msgq);
@@ -73,31 +238,36 @@ int pub_sub_handle_queued_msg(struct pub_sub_subscriber *subscriber, k_timeout_t
 		ret = -EPERM;
 		break;
 	}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	case PUB_SUB_RX_TYPE_GROUP: {
+		// Messages are queued on the group's members
+		ret = -EPERM;
+		break;
+	}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 	case PUB_SUB_RX_TYPE_MSGQ: {
 		void *msg;
 		ret = k_msgq_get(subscriber->msgq, &msg, timeout);
 		if (ret == 0) {
 			uint16_t msg_id = pub_sub_msg_get_msg_id(msg);
-			__ASSERT(subscriber->handler_data.msg_handler != NULL, "");
-			subscriber->handler_data.msg_handler(msg_id, msg,
-							     subscriber->handler_data.user_data);
+			pub_sub_subscriber_call_handler(subscriber, msg_id, msg);
 			pub_sub_release_msg(msg);
 		}
 		break;
 	}
 	case PUB_SUB_RX_TYPE_FIFO: {
-		void *msg = pub_sub_msg_fifo_get(&subscriber->fifo, timeout);
+		void *msg = fifo_get(subscriber, timeout);
 		if (msg != NULL) {
 			uint16_t msg_id = pub_sub_msg_get_msg_id(msg);
 			ret = 0;
-			__ASSERT(subscriber->handler_data.msg_handler != NULL, "");
+#ifndef CONFIG_PUB_SUB_FIFO_FANOUT
 			// If it is a public message pass it to any other fifo subscribers further
 			// down the list then handle the message
 			if (msg_id <= subscriber->max_pub_msg_id) {
 				send_to_next_fifo_subscriber(subscriber, msg_id, msg);
 			}
-			subscriber->handler_data.msg_handler(msg_id, msg,
-							     subscriber->handler_data.user_data);
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+			pub_sub_subscriber_call_handler(subscriber, msg_id, msg);
 			pub_sub_release_msg(msg);
 		}
 		break;
@@ -113,51 +283,334 @@ void pub_sub_publish_to_subscriber(struct pub_sub_subscriber *subscriber, void *
 		 "Public messages can not be published directly to subscriber");
 	switch (subscriber->rx_type) {
 	case PUB_SUB_RX_TYPE_CALLBACK: {
-		__ASSERT(subscriber->handler_data.msg_handler != NULL, "");
 		uint16_t msg_id = pub_sub_msg_get_msg_id(msg);
-		subscriber->handler_data.msg_handler(msg_id, msg,
-						     subscriber->handler_data.user_data);
+		pub_sub_subscriber_call_handler(subscriber, msg_id, msg);
 		pub_sub_release_msg(msg);
 		break;
 	}
 	case PUB_SUB_RX_TYPE_MSGQ: {
-		k_msgq_put(subscriber->msgq, &msg, K_FOREVER);
+		pub_sub_subscriber_msgq_put(subscriber, msg);
+		break;
+	}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+	case PUB_SUB_RX_TYPE_GROUP: {
+		pub_sub_subscriber_group_put(subscriber, msg);
 		break;
 	}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 	case PUB_SUB_RX_TYPE_FIFO: {
-		pub_sub_msg_fifo_put(&subscriber->fifo, msg);
+		pub_sub_subscriber_fifo_put(subscriber, msg);
 		break;
 	}
 	}
 }
 
+void pub_sub_subscriber_msgq_put(struct pub_sub_subscriber *subscriber, void *msg)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(msg != NULL, "");
+	if (k_msgq_put(subscriber->msgq, &msg, K_NO_WAIT) != 0) {
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+		if (!put_on_full_msgq(subscriber, msg)) {
+			return;
+		}
+#else
+		msgq_put_blocking(subscriber, msg);
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+	}
+#ifdef CONFIG_PUB_SUB_STATS
+	pub_sub_stats_record_queued(subscriber);
+#endif // CONFIG_PUB_SUB_STATS
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+	pub_sub_executor_notify(subscriber);
+#endif // CONFIG_PUB_SUB_EXECUTOR
+}
+
+void pub_sub_subscriber_fifo_put(struct pub_sub_subscriber *subscriber, void *msg)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(msg != NULL, "");
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+	struct fifo_envelope *envelope;
+	// The broker sends from within its read side critical section so it must not wait forever
+	k_timeout_t timeout = k_is_in_isr() ? K_NO_WAIT
+					    : K_MSEC(CONFIG_PUB_SUB_FIFO_FANOUT_ENVELOPE_TIMEOUT_MS);
+	if (k_mem_slab_alloc(&fifo_envelope_slab, (void **)&envelope, timeout) != 0) {
+		atomic_inc(&subscriber->fifo_dropped);
+		pub_sub_release_msg(msg);
+		return;
+	}
+	envelope->msg = msg;
+#if defined(CONFIG_PUB_SUB_STATS) || defined(CONFIG_PUB_SUB_SUBSCRIBER_GROUPS)
+	atomic_inc(&subscriber->fifo_depth);
+#endif
+#ifdef CONFIG_PUB_SUB_STATS
+	pub_sub_stats_record_queued(subscriber);
+#endif // CONFIG_PUB_SUB_STATS
+	k_fifo_put(&subscriber->fifo, envelope);
+#else
+#if defined(CONFIG_PUB_SUB_STATS) || defined(CONFIG_PUB_SUB_SUBSCRIBER_GROUPS)
+	atomic_inc(&subscriber->fifo_depth);
+#endif
+#ifdef CONFIG_PUB_SUB_STATS
+	pub_sub_stats_record_queued(subscriber);
+#endif // CONFIG_PUB_SUB_STATS
+	pub_sub_msg_fifo_put(&subscriber->fifo, msg);
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+	pub_sub_executor_notify(subscriber);
+#endif // CONFIG_PUB_SUB_EXECUTOR
+}
+
 static void common_subscriber_init(struct pub_sub_subscriber *subscriber, atomic_t *subs_bitarray,
 				   uint16_t max_pub_msg_id)
 {
-	memset(subs_bitarray, 0, PUB_SUB_SUBS_BITARRAY_BYTE_LEN(max_pub_msg_id));
+	if (subs_bitarray != NULL) {
+		memset(subs_bitarray, 0, PUB_SUB_SUBS_BITARRAY_BYTE_LEN(max_pub_msg_id));
+	}
 	subscriber->broker = NULL;
 	subscriber->subs_bitarray = subs_bitarray;
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	subscriber->subs_set = NULL;
+#endif // CONFIG_PUB_SUB_SUBS_SETS
 	subscriber->max_pub_msg_id = max_pub_msg_id;
 	subscriber->priority = 0;
+#ifdef CONFIG_PUB_SUB_EXECUTOR
+	subscriber->executor = NULL;
+	subscriber->exec_state = 0;
+#endif // CONFIG_PUB_SUB_EXECUTOR
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+	sys_slist_init(&subscriber->filters);
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+#ifdef CONFIG_PUB_SUB_TOPICS
+	memset(subscriber->topic_prefixes_1, 0, sizeof(subscriber->topic_prefixes_1));
+	memset(subscriber->topic_prefixes_2, 0, sizeof(subscriber->topic_prefixes_2));
+#endif // CONFIG_PUB_SUB_TOPICS
+#ifdef CONFIG_PUB_SUB_STATS
+	memset(&subscriber->stats, 0, sizeof(subscriber->stats));
+#endif // CONFIG_PUB_SUB_STATS
 }
 
+// Sets 'changed' if any subscription was added or removed. Returns 0 or a negative error code.
+static int update_subscriptions(struct pub_sub_subscriber *subscriber, uint16_t first_msg_id,
+				uint16_t last_msg_id, bool subscribe, bool *changed)
+{
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	if (subscriber->subs_set != NULL) {
+		int ret = subscribe ? pub_sub_subs_set_add_range(subscriber->subs_set, first_msg_id,
+								 last_msg_id)
+				    : pub_sub_subs_set_remove_range(subscriber->subs_set,
+								    first_msg_id, last_msg_id);
+		if (ret < 0) {
+			return ret;
+		}
+		*changed = ret > 0;
+		return 0;
+	}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+	__ASSERT(subscriber->subs_bitarray != NULL, "");
+	*changed = update_bitarray_range(subscriber->subs_bitarray, first_msg_id, last_msg_id,
+					 subscribe);
+	return 0;
+}
+
+// Sets 'changed' if any subscription was added. Returns 0 or a negative error code.
+static int add_bitmap_subscriptions(struct pub_sub_subscriber *subscriber, const atomic_t *bitmap,
+				    uint16_t max_msg_id, bool *changed)
+{
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+	if (subscriber->subs_set != NULL) {
+		// Each run of consecutive ids is added to the set in one modification
+		uint32_t msg_id = 0;
+		while (msg_id <= max_msg_id) {
+			if (!atomic_test_bit(bitmap, msg_id)) {
+				msg_id++;
+				continue;
+			}
+			uint32_t last_id = msg_id;
+			while ((last_id < max_msg_id) && atomic_test_bit(bitmap, last_id + 1)) {
+				last_id++;
+			}
+			int ret = pub_sub_subs_set_add_range(subscriber->subs_set, msg_id, last_id);
+			if (ret < 0) {
+				return ret;
+			}
+			*changed |= ret > 0;
+			msg_id = last_id + 1;
+		}
+		return 0;
+	}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+	__ASSERT(subscriber->subs_bitarray != NULL, "");
+	size_t num_words = ATOMIC_BITMAP_SIZE(max_msg_id + 1);
+	for (size_t i = 0; i < num_words; i++) {
+		atomic_val_t mask = atomic_get(&bitmap[i]);
+		// Ignore any bits past the maximum message id in the last word
+		if (i == (num_words - 1)) {
+			mask &= GENMASK(max_msg_id % ATOMIC_BITS, 0);
+		}
+		*changed |= (atomic_or(&subscriber->subs_bitarray[i], mask) & mask) != mask;
+	}
+	return 0;
+}
+
+// Sets or clears a range of bits a whole atomic word at a time. Returns true if any bit changed.
+static bool update_bitarray_range(atomic_t *bitarray, uint16_t first_msg_id, uint16_t last_msg_id,
+				  bool set)
+{
+	bool changed = false;
+	uint32_t msg_id = first_msg_id;
+	while (msg_id <= last_msg_id) {
+		uint32_t word_last_msg_id = MIN(last_msg_id, msg_id | (ATOMIC_BITS - 1));
+		atomic_val_t mask = GENMASK(word_last_msg_id % ATOMIC_BITS, msg_id % ATOMIC_BITS);
+		atomic_t *word = ATOMIC_ELEM(bitarray, msg_id);
+		if (set) {
+			changed |= (atomic_or(word, mask) & mask) != mask;
+		} else {
+			changed |= (atomic_and(word, ~mask) & mask) != 0;
+		}
+		msg_id = word_last_msg_id + 1;
+	}
+	return changed;
+}
+
+static void update_broker_subscriptions(struct pub_sub_subscriber *subscriber,
+					uint16_t first_msg_id, uint16_t last_msg_id)
+{
+#ifdef CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+	struct pub_sub_broker *broker = subscriber->broker;
+	if (broker != NULL) {
+		pub_sub_broker_update_subscriptions(broker, first_msg_id, last_msg_id);
+	}
+#else
+	ARG_UNUSED(subscriber);
+	ARG_UNUSED(first_msg_id);
+	ARG_UNUSED(last_msg_id);
+#endif // CONFIG_PUB_SUB_BROKER_SUBSCRIPTION_TRACKING
+}
+
+#ifdef CONFIG_PUB_SUB_TOPICS
+static void update_prefix_subscription(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
+				       uint8_t num_levels, bool subscribe)
+{
+	__ASSERT((num_levels >= 1) && (num_levels <= PUB_SUB_TOPIC_MAX_LEVELS), "");
+	// Topics always track subscriptions in the broker
+	__ASSERT(!k_is_in_isr(), "");
+	uint16_t prefix = PUB_SUB_TOPIC_PREFIX(msg_id, num_levels);
+	uint16_t first_msg_id = PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(prefix, num_levels);
+	uint16_t last_msg_id = PUB_SUB_TOPIC_PREFIX_LAST_MSG_ID(prefix, num_levels);
+	__ASSERT(first_msg_id <= subscriber->max_pub_msg_id, "");
+	atomic_t *prefixes =
+		(num_levels == 1) ? subscriber->topic_prefixes_1 : subscriber->topic_prefixes_2;
+	bool changed = subscribe ? !atomic_test_and_set_bit(prefixes, prefix)
+				 : atomic_test_and_clear_bit(prefixes, prefix);
+	if (changed) {
+		update_broker_subscriptions(subscriber, first_msg_id,
+					    MIN(last_msg_id, subscriber->max_pub_msg_id));
+	}
+}
+#endif // CONFIG_PUB_SUB_TOPICS
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+// The filter list is only modified before the subscriber is added to a broker so the broker can
+// read it without locking
+static void add_filter(struct pub_sub_subscriber *subscriber, struct pub_sub_filter *filter,
+		       bool all_msg_ids, uint16_t msg_id, pub_sub_filter_fn filter_fn,
+		       void *user_data)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(filter != NULL, "");
+	__ASSERT(filter_fn != NULL, "");
+	__ASSERT(subscriber->broker == NULL, "");
+	filter->filter = filter_fn;
+	filter->user_data = user_data;
+	filter->msg_id = msg_id;
+	filter->all_msg_ids = all_msg_ids;
+	atomic_set(&filter->hits, 0);
+	atomic_set(&filter->misses, 0);
+	sys_slist_append(&subscriber->filters, &filter->node);
+}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+
+static void *fifo_get(struct pub_sub_subscriber *subscriber, k_timeout_t timeout)
+{
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+	struct fifo_envelope *envelope = k_fifo_get(&subscriber->fifo, timeout);
+	if (envelope == NULL) {
+		return NULL;
+	}
+	void *msg = envelope->msg;
+	k_mem_slab_free(&fifo_envelope_slab, envelope);
+#else
+	void *msg = pub_sub_msg_fifo_get(&subscriber->fifo, timeout);
+	if (msg == NULL) {
+		return NULL;
+	}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+#if defined(CONFIG_PUB_SUB_STATS) || defined(CONFIG_PUB_SUB_SUBSCRIBER_GROUPS)
+	atomic_dec(&subscriber->fifo_depth);
+#endif
+	return msg;
+}
+
+#ifndef CONFIG_PUB_SUB_FIFO_FANOUT
 // This function assumes that 'subscriber' is also a fifo subscriber
 static void send_to_next_fifo_subscriber(struct pub_sub_subscriber *subscriber, uint16_t msg_id,
 					 void *msg)
 {
 	struct pub_sub_broker *broker = subscriber->broker;
-	k_mutex_lock(&broker->sub_list_mutex, K_FOREVER);
-	// fifo subscribers are at the end of the list so we can just iterate until we hit either a
-	// subscription or the end of the list
-	for (struct pub_sub_subscriber *next_sub =
-		     SYS_SLIST_PEEK_NEXT_CONTAINER(subscriber, sub_list_node);
-	     next_sub != NULL; next_sub = SYS_SLIST_PEEK_NEXT_CONTAINER(next_sub, sub_list_node)) {
-		if ((msg_id <= next_sub->max_pub_msg_id) &&
-		    atomic_test_bit(next_sub->subs_bitarray, msg_id)) {
-			pub_sub_acquire_msg(msg);
-			pub_sub_msg_fifo_put(&next_sub->fifo, msg);
-			break;
-		}
+	// The subscriber could have been removed from its broker after the message was queued
+	if (broker == NULL) {
+		return;
+	}
+	uint8_t read_key = pub_sub_broker_read_lock(broker);
+	struct pub_sub_subscriber *next_sub =
+		pub_sub_broker_next_fifo_subscriber(broker, subscriber, msg_id, msg);
+	if (next_sub != NULL) {
+		pub_sub_acquire_msg(msg);
+		pub_sub_subscriber_fifo_put(next_sub, msg);
+	}
+	pub_sub_broker_read_unlock(broker, read_key);
+}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+// Returns false if the message was dropped
+static bool put_on_full_msgq(struct pub_sub_subscriber *subscriber, void *msg)
+{
+	enum pub_sub_msgq_overflow_policy policy = subscriber->msgq_overflow_policy;
+	if ((policy == PUB_SUB_MSGQ_OVERFLOW_DROP_NEWEST) ||
+	    ((policy == PUB_SUB_MSGQ_OVERFLOW_DROP_ABOVE_LEVEL) &&
+	     (pub_sub_msg_get_msg_id(msg) > subscriber->msgq_drop_level))) {
+		atomic_inc(&subscriber->msgq_dropped);
+		pub_sub_release_msg(msg);
+		return false;
+	}
+	if (policy == PUB_SUB_MSGQ_OVERFLOW_DROP_OLDEST) {
+		// The subscriber could empty the queue, or something else could fill it, between
+		// the attempts so keep trying until the message is queued
+		do {
+			void *oldest_msg;
+			if (k_msgq_get(subscriber->msgq, &oldest_msg, K_NO_WAIT) == 0) {
+				atomic_inc(&subscriber->msgq_dropped);
+				pub_sub_release_msg(oldest_msg);
+			}
+		} while (k_msgq_put(subscriber->msgq, &msg, K_NO_WAIT) != 0);
+		return true;
 	}
-	k_mutex_unlock(&broker->sub_list_mutex);
+	atomic_inc(&subscriber->msgq_blocked);
+	msgq_put_blocking(subscriber, msg);
+	return true;
+}
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+
+static void msgq_put_blocking(struct pub_sub_subscriber *subscriber, void *msg)
+{
+#ifdef CONFIG_PUB_SUB_STATS
+	uint32_t start = k_cycle_get_32();
+	k_msgq_put(subscriber->msgq, &msg, K_FOREVER);
+	pub_sub_stats_record_msgq_blocked(subscriber, k_cycle_get_32() - start);
+#else
+	k_msgq_put(subscriber->msgq, &msg, K_FOREVER);
+#endif // CONFIG_PUB_SUB_STATS
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/subscriber_group.h>
+
+static struct pub_sub_subscriber *select_member(struct pub_sub_subscriber_group *group,
+						uint16_t msg_id, const void *msg);
+static uint32_t member_queue_depth(struct pub_sub_subscriber *member);
+
+void pub_sub_init_subscriber_group(struct pub_sub_subscriber_group *group, atomic_t *subs_bitarray,
+				   uint16_t max_pub_msg_id,
+				   struct pub_sub_subscriber *const *members, uint16_t num_members,
+				   enum pub_sub_group_policy policy)
+{
+	__ASSERT(group != NULL, "");
+	__ASSERT(members != NULL, "");
+	__ASSERT(num_members > 0, "");
+	for (uint16_t i = 0; i < num_members; i++) {
+		__ASSERT(members[i]->broker == NULL, "Group members must not be added to a broker");
+		__ASSERT((members[i]->rx_type == PUB_SUB_RX_TYPE_MSGQ) ||
+				 (IS_ENABLED(CONFIG_PUB_SUB_FIFO_FANOUT) &&
+				  (members[i]->rx_type == PUB_SUB_RX_TYPE_FIFO)),
+			 "Group members must be msgq subscribers, or fifo subscribers with "
+			 "CONFIG_PUB_SUB_FIFO_FANOUT");
+	}
+	// Initialized as a callback subscriber for the common fields
+	pub_sub_init_callback_subscriber(&group->subscriber, subs_bitarray, max_pub_msg_id);
+	group->subscriber.rx_type = PUB_SUB_RX_TYPE_GROUP;
+	group->members = members;
+	group->num_members = num_members;
+	group->policy = policy;
+	group->key_fn = NULL;
+	group->key_user_data = NULL;
+	atomic_set(&group->next_member, 0);
+}
+
+void pub_sub_subscriber_group_put(struct pub_sub_subscriber *subscriber, void *msg)
+{
+	__ASSERT(subscriber != NULL, "");
+	__ASSERT(subscriber->rx_type == PUB_SUB_RX_TYPE_GROUP, "");
+	struct pub_sub_subscriber_group *group =
+		CONTAINER_OF(subscriber, struct pub_sub_subscriber_group, subscriber);
+	struct pub_sub_subscriber *member =
+		select_member(group, pub_sub_msg_get_msg_id(msg), msg);
+	if (member->rx_type == PUB_SUB_RX_TYPE_MSGQ) {
+		pub_sub_subscriber_msgq_put(member, msg);
+	} else {
+		pub_sub_subscriber_fifo_put(member, msg);
+	}
+}
+
+static struct pub_sub_subscriber *select_member(struct pub_sub_subscriber_group *group,
+						uint16_t msg_id, const void *msg)
+{
+	uint16_t index = 0;
+	switch (group->policy) {
+	case PUB_SUB_GROUP_ROUND_ROBIN: {
+		index = (uint32_t)atomic_inc(&group->next_member) % group->num_members;
+		break;
+	}
+	case PUB_SUB_GROUP_LEAST_QUEUED: {
+		// Start the search from a different member each time so that ties are spread across
+		// the members instead of always going to the first one
+		uint16_t start = (uint32_t)atomic_inc(&group->next_member) % group->num_members;
+		uint32_t min_depth = UINT32_MAX;
+		for (uint16_t i = 0; i < group->num_members; i++) {
+			uint16_t candidate = (start + i) % group->num_members;
+			uint32_t depth = member_queue_depth(group->members[candidate]);
+			if (depth < min_depth) {
+				min_depth = depth;
+				index = candidate;
+			}
+		}
+		break;
+	}
+	case PUB_SUB_GROUP_KEY_HASH: {
+		uint32_t key = msg_id;
+		if (group->key_fn != NULL) {
+			key = group->key_fn(msg_id, msg, group->key_user_data);
+		}
+		index = pub_sub_hash_index(key, group->num_members);
+		break;
+	}
+	}
+	return group->members[index];
+}
+
+static uint32_t member_queue_depth(struct pub_sub_subscriber *member)
+{
+	if (member->rx_type == PUB_SUB_RX_TYPE_MSGQ) {
+		return k_msgq_num_used_get(member->msgq);
+	}
+	return atomic_get(&member->fifo_depth);
+}
\ No newline at end of file
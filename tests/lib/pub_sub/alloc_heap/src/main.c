@@ -0,0 +1,190 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc.h>
+#include <pub_sub/msg_alloc_heap.h>
+#include <zephyr/ztest.h>
+#include <string.h>
+#include <helpers.h>
+
+#define HEAP_SIZE 1024
+
+PUB_SUB_HEAP_ALLOCATOR_DEFINE_STATIC(heap_allocator, HEAP_SIZE);
+
+K_HEAP_DEFINE(runtime_heap, 512);
+static struct pub_sub_allocator runtime_allocator;
+
+static void *held_msgs[HEAP_SIZE / 32];
+static struct k_work_delayable release_work;
+
+static size_t fill_heap(size_t msg_size)
+{
+	size_t num_msgs = 0;
+	while (num_msgs < ARRAY_SIZE(held_msgs)) {
+		held_msgs[num_msgs] = pub_sub_new_msg(&heap_allocator, 0, msg_size, K_NO_WAIT);
+		if (held_msgs[num_msgs] == NULL) {
+			break;
+		}
+		num_msgs++;
+	}
+	return num_msgs;
+}
+
+static void release_held_msgs(void)
+{
+	ARRAY_FOR_EACH(held_msgs, i) {
+		if (held_msgs[i] != NULL) {
+			pub_sub_release_msg(held_msgs[i]);
+			held_msgs[i] = NULL;
+		}
+	}
+}
+
+static void release_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+	pub_sub_release_msg(held_msgs[0]);
+	held_msgs[0] = NULL;
+}
+
+static void *heap_suite_setup(void)
+{
+	k_work_init_delayable(&release_work, release_work_fn);
+	pub_sub_init_heap_allocator(&runtime_allocator, &runtime_heap);
+	pub_sub_add_runtime_allocator(&runtime_allocator);
+	return NULL;
+}
+
+static void heap_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	release_held_msgs();
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+	// Check all of the heap has been freed to see if we have any leaks
+	struct pub_sub_heap_allocator_stats stats;
+	pub_sub_heap_allocator_stats(&heap_allocator, &stats);
+	zassert_equal(stats.allocated_bytes, 0);
+	pub_sub_heap_allocator_stats(&runtime_allocator, &stats);
+	zassert_equal(stats.allocated_bytes, 0);
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+}
+
+ZTEST(heap, test_variable_sizes)
+{
+	const size_t msg_sizes[] = {1, 13, 100, 250, 7};
+	void *msgs[ARRAY_SIZE(msg_sizes)];
+
+	ARRAY_FOR_EACH(msg_sizes, i) {
+		msgs[i] = pub_sub_new_msg(&heap_allocator, i, msg_sizes[i], K_NO_WAIT);
+		zassert_not_null(msgs[i], "msg size: %u", msg_sizes[i]);
+		zassert_equal(pub_sub_msg_get_alloc_id(msgs[i]), 0);
+		zassert_equal(pub_sub_msg_get_msg_id(msgs[i]), i);
+		memset(msgs[i], i, msg_sizes[i]);
+	}
+	// Writing the msgs does not corrupt each other
+	ARRAY_FOR_EACH(msg_sizes, i) {
+		uint8_t *bytes = msgs[i];
+		for (size_t j = 0; j < msg_sizes[i]; j++) {
+			zassert_equal(bytes[j], i, "msg: %u, byte: %u", i, j);
+		}
+		zassert_equal(pub_sub_msg_get_msg_id(msgs[i]), i);
+	}
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST(heap, test_exhaustion)
+{
+	size_t num_msgs = fill_heap(64);
+	zassert_true(num_msgs > 0);
+	zassert_true(num_msgs < HEAP_SIZE / 64, "num msgs: %u", num_msgs);
+	zassert_is_null(pub_sub_new_msg(&heap_allocator, 0, 64, K_NO_WAIT));
+
+	// Releasing a msg makes room for another one
+	pub_sub_release_msg(held_msgs[0]);
+	held_msgs[0] = pub_sub_new_msg(&heap_allocator, 0, 64, K_NO_WAIT);
+	zassert_not_null(held_msgs[0]);
+
+	// The ref count keeps the msg allocated
+	pub_sub_msg_inc_ref_cnt(held_msgs[0]);
+	pub_sub_release_msg(held_msgs[0]);
+	zassert_is_null(pub_sub_new_msg(&heap_allocator, 0, 64, K_NO_WAIT));
+}
+
+ZTEST(heap, test_timeout)
+{
+	zassert_true(fill_heap(64) > 0);
+
+	// The allocation waits for the timeout before failing
+	int64_t start = k_uptime_get();
+	zassert_is_null(pub_sub_new_msg(&heap_allocator, 0, 64, K_MSEC(20)));
+	zassert_true(k_uptime_get() - start >= 20);
+
+	// A waiting allocation succeeds once a msg is released
+	k_work_schedule(&release_work, K_MSEC(10));
+	void *msg = pub_sub_new_msg(&heap_allocator, 0, 64, K_MSEC(500));
+	zassert_not_null(msg);
+	zassert_is_null(held_msgs[0]);
+	pub_sub_release_msg(msg);
+}
+
+ZTEST(heap, test_runtime_allocator)
+{
+	void *msg = pub_sub_new_msg(&runtime_allocator, 0, 100, K_NO_WAIT);
+	zassert_not_null(msg);
+	uint8_t alloc_id = pub_sub_msg_get_alloc_id(msg);
+	zassert_equal(alloc_id, PUB_SUB_ALLOC_ID_RUNTIME_OFFSET, "alloc_id: %u", alloc_id);
+	// A msg larger than the heap can never be allocated
+	zassert_is_null(pub_sub_new_msg(&runtime_allocator, 0, 512, K_NO_WAIT));
+	pub_sub_release_msg(msg);
+}
+
+#ifdef CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+ZTEST(heap, test_stats)
+{
+	struct pub_sub_heap_allocator_stats stats;
+	struct k_heap *heap = heap_allocator.impl;
+
+	// An unused heap is a single free block and reading the stats doesn't allocate from it
+	sys_heap_runtime_stats_reset_max(&heap->heap);
+	pub_sub_heap_allocator_stats(&heap_allocator, &stats);
+	zassert_equal(stats.allocated_bytes, 0);
+	zassert_equal(stats.max_allocated_bytes, 0, "max allocated: %u",
+		      stats.max_allocated_bytes);
+	zassert_true(stats.largest_free_block <= stats.free_bytes);
+	zassert_true(stats.largest_free_block > HEAP_SIZE / 2);
+	zassert_true(stats.fragmentation_percent < 10, "fragmentation: %u",
+		     stats.fragmentation_percent);
+	// The largest free block can be allocated as a single msg
+	void *msg = pub_sub_new_msg(&heap_allocator, 0,
+				    stats.largest_free_block - PUB_SUB_MSG_OVERHEAD_NUM_BYTES,
+				    K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_release_msg(msg);
+
+	// Releasing every other msg leaves the free bytes split into small blocks
+	size_t num_msgs = fill_heap(32);
+	for (size_t i = 0; i < num_msgs; i += 2) {
+		pub_sub_release_msg(held_msgs[i]);
+		held_msgs[i] = NULL;
+	}
+	pub_sub_heap_allocator_stats(&heap_allocator, &stats);
+	zassert_true(stats.allocated_bytes > 0);
+	zassert_true(stats.max_allocated_bytes >= stats.allocated_bytes);
+	zassert_true(stats.largest_free_block < stats.free_bytes / 2,
+		     "largest free block: %u, free bytes: %u", stats.largest_free_block,
+		     stats.free_bytes);
+	zassert_true(stats.fragmentation_percent > 50, "fragmentation: %u",
+		     stats.fragmentation_percent);
+
+	// Once all of the msgs are released the free blocks merge again
+	release_held_msgs();
+	pub_sub_heap_allocator_stats(&heap_allocator, &stats);
+	zassert_equal(stats.allocated_bytes, 0);
+	zassert_true(stats.fragmentation_percent < 10, "fragmentation: %u",
+		     stats.fragmentation_percent);
+}
+#endif // CONFIG_PUB_SUB_HEAP_ALLOCATOR_STATS
+
+ZTEST_SUITE(heap, NULL, heap_suite_setup, NULL, heap_after_test, NULL);
\ No newline at end of file
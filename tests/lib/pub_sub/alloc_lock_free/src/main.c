@@ -0,0 +1,180 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc.h>
+#include <pub_sub/msg_alloc_lock_free.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <helpers.h>
+
+#define NUM_MSGS            8
+#define MSG_SIZE            16
+#define STRESS_STACK_SIZE   1024
+#define STRESS_ITERATIONS   1000
+#define BENCHMARK_NUM_PAIRS 1000
+
+PUB_SUB_LOCK_FREE_ALLOCATOR_DEFINE_STATIC(lock_free_allocator, MSG_SIZE, NUM_MSGS);
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(mem_slab_allocator, MSG_SIZE, NUM_MSGS);
+
+static uint8_t __aligned(sizeof(uintptr_t))
+	runtime_buffer[PUB_SUB_LOCK_FREE_ALLOCATOR_BUF_SIZE(MSG_SIZE, NUM_MSGS)];
+static struct pub_sub_lock_free_pool runtime_pool;
+static struct pub_sub_allocator runtime_allocator;
+
+static struct k_timer isr_timer;
+static struct k_sem isr_done;
+static size_t isr_num_allocated;
+
+K_THREAD_STACK_ARRAY_DEFINE(stress_stacks, 2, STRESS_STACK_SIZE);
+static struct k_thread stress_threads[2];
+static atomic_t stress_failures;
+
+// Allocates every msg then releases them, checking each msg is only handed out once
+static void check_all_msgs_allocatable(struct pub_sub_allocator *allocator)
+{
+	void *msgs[NUM_MSGS];
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT);
+		zassert_not_null(msgs[i], "allocation attempt: %u", i);
+		for (size_t j = 0; j < i; j++) {
+			zassert_not_equal(msgs[i], msgs[j]);
+		}
+	}
+	zassert_is_null(pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT));
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+static void isr_timer_fn(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	void *msgs[NUM_MSGS];
+	isr_num_allocated = 0;
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(&lock_free_allocator, 0, MSG_SIZE, K_NO_WAIT);
+		if (msgs[i] != NULL) {
+			isr_num_allocated++;
+		}
+	}
+	ARRAY_FOR_EACH(msgs, i) {
+		if (msgs[i] != NULL) {
+			pub_sub_release_msg(msgs[i]);
+		}
+	}
+	k_sem_give(&isr_done);
+}
+
+static void stress_thread_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+	for (size_t i = 0; i < STRESS_ITERATIONS; i++) {
+		void *msgs[NUM_MSGS / 2];
+		ARRAY_FOR_EACH(msgs, j) {
+			msgs[j] = pub_sub_new_msg(&lock_free_allocator, 0, MSG_SIZE, K_NO_WAIT);
+			if (msgs[j] == NULL) {
+				atomic_inc(&stress_failures);
+			}
+		}
+		k_yield();
+		ARRAY_FOR_EACH(msgs, j) {
+			if (msgs[j] != NULL) {
+				pub_sub_release_msg(msgs[j]);
+			}
+		}
+	}
+}
+
+static uint32_t benchmark_cycles(struct pub_sub_allocator *allocator)
+{
+	uint32_t start = k_cycle_get_32();
+	for (size_t i = 0; i < BENCHMARK_NUM_PAIRS; i++) {
+		void *msg = pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_release_msg(msg);
+	}
+	return k_cycle_get_32() - start;
+}
+
+static void *lock_free_suite_setup(void)
+{
+	k_timer_init(&isr_timer, isr_timer_fn, NULL);
+	k_sem_init(&isr_done, 0, 1);
+	pub_sub_init_lock_free_allocator(&runtime_allocator, &runtime_pool, runtime_buffer,
+					 MSG_SIZE, NUM_MSGS);
+	pub_sub_add_runtime_allocator(&runtime_allocator);
+	return NULL;
+}
+
+ZTEST(lock_free, test_static_allocator)
+{
+	check_all_msgs_allocatable(&lock_free_allocator);
+	// Again once the msgs are taken from the free list rather than carved from the buffer
+	check_all_msgs_allocatable(&lock_free_allocator);
+}
+
+ZTEST(lock_free, test_runtime_allocator)
+{
+	void *msg = pub_sub_new_msg(&runtime_allocator, 0, MSG_SIZE, K_NO_WAIT);
+	zassert_not_null(msg);
+	uint8_t alloc_id = pub_sub_msg_get_alloc_id(msg);
+	zassert_equal(alloc_id, PUB_SUB_ALLOC_ID_RUNTIME_OFFSET, "alloc_id: %u", alloc_id);
+	pub_sub_release_msg(msg);
+	check_all_msgs_allocatable(&runtime_allocator);
+}
+
+ZTEST(lock_free, test_reuse_and_ref_counts)
+{
+	void *msg = pub_sub_new_msg(&lock_free_allocator, 0, MSG_SIZE, K_NO_WAIT);
+	zassert_not_null(msg);
+
+	// The msg stays allocated while it is referenced
+	pub_sub_msg_inc_ref_cnt(msg);
+	pub_sub_release_msg(msg);
+	void *new_msg = pub_sub_new_msg(&lock_free_allocator, 0, MSG_SIZE, K_NO_WAIT);
+	zassert_not_null(new_msg);
+	zassert_not_equal(new_msg, msg);
+	pub_sub_release_msg(new_msg);
+
+	// The most recently released msg is the next one allocated
+	pub_sub_release_msg(msg);
+	new_msg = pub_sub_new_msg(&lock_free_allocator, 0, MSG_SIZE, K_NO_WAIT);
+	zassert_equal_ptr(new_msg, msg);
+	pub_sub_release_msg(new_msg);
+}
+
+ZTEST(lock_free, test_allocate_from_isr)
+{
+	k_timer_start(&isr_timer, K_MSEC(1), K_NO_WAIT);
+	zassert_ok(k_sem_take(&isr_done, K_MSEC(100)));
+	zassert_equal(isr_num_allocated, NUM_MSGS);
+	check_all_msgs_allocatable(&lock_free_allocator);
+}
+
+ZTEST(lock_free, test_concurrent_threads)
+{
+	atomic_set(&stress_failures, 0);
+	ARRAY_FOR_EACH(stress_threads, i) {
+		k_thread_create(&stress_threads[i], stress_stacks[i], STRESS_STACK_SIZE,
+				stress_thread_fn, NULL, NULL, NULL, K_PRIO_PREEMPT(1), 0,
+				K_NO_WAIT);
+	}
+	ARRAY_FOR_EACH(stress_threads, i) {
+		zassert_ok(k_thread_join(&stress_threads[i], K_FOREVER));
+	}
+	// Each thread only holds half of the msgs so no allocation fails and none are lost
+	zassert_equal(atomic_get(&stress_failures), 0);
+	check_all_msgs_allocatable(&lock_free_allocator);
+}
+
+ZTEST(lock_free, test_benchmark)
+{
+	uint32_t lock_free_cycles = benchmark_cycles(&lock_free_allocator);
+	uint32_t mem_slab_cycles = benchmark_cycles(&mem_slab_allocator);
+	TC_PRINT("%u allocate and release pairs, lock free: %u cycles, mem slab: %u cycles\n",
+		 BENCHMARK_NUM_PAIRS, lock_free_cycles, mem_slab_cycles);
+}
+
+ZTEST_SUITE(lock_free, NULL, lock_free_suite_setup, NULL, NULL, NULL);
\ No newline at end of file
@@ -18,6 +18,11 @@ PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_mem_slab_allocator_1, 4, 32);
 PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_mem_slab_allocator_2, 8, 16);
 PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_mem_slab_allocator_3, 16, 8);
 PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_mem_slab_allocator_4, 32, 4);
+#ifdef CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+#define MAGAZINE_ALLOCATOR_NUM_MSGS 12
+PUB_SUB_MEM_SLAB_MAGAZINE_ALLOCATOR_DEFINE_STATIC(static_mem_slab_magazine_allocator, 16,
+						  MAGAZINE_ALLOCATOR_NUM_MSGS);
+#endif // CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
 
 const struct static_allocator_info static_allocator_info[5] = {
 	{
@@ -85,6 +90,12 @@ static void mem_slab_after_test(void *fixture)
 	ARRAY_FOR_EACH(static_allocator_info, i) {
 		reset_mem_slab_allocator(static_allocator_info[i].allocator);
 	}
+#ifdef CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+	// Check all of the magazine allocator's msgs were released to see if we have any leaks
+	struct pub_sub_mem_slab_magazines *magazines = static_mem_slab_magazine_allocator.impl;
+	pub_sub_mem_slab_magazines_flush(&static_mem_slab_magazine_allocator);
+	zassert_equal(k_mem_slab_num_used_get(magazines->mem_slab), 0);
+#endif // CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
 }
 
 static void mem_slab_suite_teardown(void *fixture)
@@ -241,5 +252,80 @@ ZTEST_F(mem_slab, test_allocator_add)
 	zassert_equal(ret, -ENOMEM);
 }
 
+#ifdef CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+ZTEST(mem_slab, test_magazine_num_msgs)
+{
+	struct pub_sub_allocator *allocator = &static_mem_slab_magazine_allocator;
+	void *msgs[MAGAZINE_ALLOCATOR_NUM_MSGS];
+
+	// Every msg can be allocated even though the magazine caches free blocks
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT);
+		zassert_not_null(msgs[i], "allocation attempt: %u", i);
+	}
+	zassert_is_null(pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT));
+
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+	// Again after all of the msgs have been cached and flushed
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT);
+		zassert_not_null(msgs[i], "allocation attempt: %u", i);
+	}
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST(mem_slab, test_magazine_caching)
+{
+	struct pub_sub_allocator *allocator = &static_mem_slab_magazine_allocator;
+	struct pub_sub_mem_slab_magazines *magazines = allocator->impl;
+	struct k_mem_slab *mem_slab = magazines->mem_slab;
+	const uint32_t batch_size = (CONFIG_PUB_SUB_MEM_SLAB_MAGAZINE_SIZE + 1) / 2;
+
+	// An empty magazine is refilled with half a magazine of blocks from the memory slab
+	void *msg = pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT);
+	zassert_not_null(msg);
+	zassert_equal(k_mem_slab_num_used_get(mem_slab), batch_size);
+
+	// A released msg is kept in the magazine and is the next one allocated
+	pub_sub_release_msg(msg);
+	zassert_equal(k_mem_slab_num_used_get(mem_slab), batch_size);
+	void *new_msg = pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT);
+	zassert_equal_ptr(new_msg, msg);
+	zassert_equal(k_mem_slab_num_used_get(mem_slab), batch_size);
+	pub_sub_release_msg(new_msg);
+
+	// Flushing returns the cached blocks to the memory slab
+	pub_sub_mem_slab_magazines_flush(allocator);
+	zassert_equal(k_mem_slab_num_used_get(mem_slab), 0);
+}
+
+ZTEST(mem_slab, test_magazine_release_when_empty)
+{
+	struct pub_sub_allocator *allocator = &static_mem_slab_magazine_allocator;
+	struct pub_sub_mem_slab_magazines *magazines = allocator->impl;
+	struct k_mem_slab *mem_slab = magazines->mem_slab;
+	void *msgs[MAGAZINE_ALLOCATOR_NUM_MSGS];
+
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(allocator, 0, 16, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	// While the memory slab is empty a released msg goes straight back to it so it can wake a
+	// waiting allocation
+	pub_sub_release_msg(msgs[0]);
+	zassert_equal(k_mem_slab_num_used_get(mem_slab), MAGAZINE_ALLOCATOR_NUM_MSGS - 1);
+	msgs[0] = pub_sub_new_msg(allocator, 0, 16, K_MSEC(10));
+	zassert_not_null(msgs[0]);
+
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+#endif // CONFIG_PUB_SUB_MEM_SLAB_MAGAZINES
+
 ZTEST_SUITE(mem_slab, NULL, mem_slab_suite_setup, NULL, mem_slab_after_test,
 	    mem_slab_suite_teardown);
\ No newline at end of file
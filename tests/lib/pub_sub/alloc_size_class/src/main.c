@@ -0,0 +1,191 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc.h>
+#include <pub_sub/msg_alloc_size_class.h>
+#include <zephyr/ztest.h>
+#include <helpers.h>
+
+PUB_SUB_SIZE_CLASS_DEFINE_STATIC(small_class, 16, 4);
+PUB_SUB_SIZE_CLASS_DEFINE_STATIC(medium_class, 64, 2);
+PUB_SUB_SIZE_CLASS_DEFINE_STATIC(large_class, 256, 1);
+PUB_SUB_SIZE_CLASS_ALLOCATOR_DEFINE_STATIC(listed_allocator, true, &small_class, &medium_class,
+					   &large_class);
+
+PUB_SUB_SIZE_CLASS_ALLOCATOR_POW2_DEFINE_STATIC(pow2_allocator, false, 8, 3, 2);
+
+K_MEM_SLAB_DEFINE_STATIC(runtime_small_class, PUB_SUB_MEM_SLAB_ALLOCATOR_BLOCK_SIZE(8), 2,
+			 sizeof(uintptr_t));
+K_MEM_SLAB_DEFINE_STATIC(runtime_large_class, PUB_SUB_MEM_SLAB_ALLOCATOR_BLOCK_SIZE(32), 2,
+			 sizeof(uintptr_t));
+static struct k_mem_slab *const runtime_classes[] = {&runtime_small_class,
+						      &runtime_large_class};
+static struct pub_sub_size_class_counters runtime_counters[ARRAY_SIZE(runtime_classes)];
+static struct pub_sub_size_class_allocator runtime_size_classes;
+static struct pub_sub_allocator runtime_allocator;
+
+static uint32_t class_num_used(struct pub_sub_allocator *allocator, uint8_t size_class)
+{
+	struct pub_sub_size_class_stats stats;
+	zassert_ok(pub_sub_size_class_allocator_stats(allocator, size_class, &stats));
+	return stats.num_used;
+}
+
+static void reset_size_class_allocator(struct pub_sub_allocator *allocator)
+{
+	struct pub_sub_size_class_allocator *size_classes = allocator->impl;
+	for (uint8_t i = 0; i < size_classes->num_classes; i++) {
+		// Check all of the classes' blocks are free to see if we have any leaks
+		zassert_equal(k_mem_slab_num_used_get(size_classes->classes[i]), 0);
+		atomic_set(&size_classes->counters[i].fallbacks, 0);
+		atomic_set(&size_classes->counters[i].failures, 0);
+	}
+}
+
+static void *size_class_suite_setup(void)
+{
+	pub_sub_init_size_class_allocator(&runtime_allocator, &runtime_size_classes,
+					  runtime_classes, runtime_counters,
+					  ARRAY_SIZE(runtime_classes), true);
+	pub_sub_add_runtime_allocator(&runtime_allocator);
+	return NULL;
+}
+
+static void size_class_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_size_class_allocator(&listed_allocator);
+	reset_size_class_allocator(&pow2_allocator);
+	reset_size_class_allocator(&runtime_allocator);
+}
+
+ZTEST(size_class, test_best_fit)
+{
+	const size_t msg_sizes[] = {12, 16, 40, 64, 200};
+	const uint8_t expected_classes[] = {0, 0, 1, 1, 2};
+	void *msgs[ARRAY_SIZE(msg_sizes)];
+
+	zassert_equal(pub_sub_size_class_allocator_num_classes(&listed_allocator), 3);
+	// Each msg is allocated from the smallest class it fits in
+	ARRAY_FOR_EACH(msg_sizes, i) {
+		uint32_t num_used = class_num_used(&listed_allocator, expected_classes[i]);
+		msgs[i] = pub_sub_new_msg(&listed_allocator, i, msg_sizes[i], K_NO_WAIT);
+		zassert_not_null(msgs[i], "msg size: %u", msg_sizes[i]);
+		zassert_equal(class_num_used(&listed_allocator, expected_classes[i]), num_used + 1,
+			      "msg size: %u", msg_sizes[i]);
+		zassert_equal(pub_sub_msg_get_msg_id(msgs[i]), i);
+	}
+
+	// Releasing the msgs returns them to the class they were allocated from
+	ARRAY_FOR_EACH(msgs, i) {
+		uint32_t num_used = class_num_used(&listed_allocator, expected_classes[i]);
+		pub_sub_release_msg(msgs[i]);
+		zassert_equal(class_num_used(&listed_allocator, expected_classes[i]), num_used - 1,
+			      "msg size: %u", msg_sizes[i]);
+	}
+}
+
+ZTEST(size_class, test_fallback)
+{
+	struct pub_sub_size_class_stats stats;
+	void *msgs[7];
+
+	// Fill the smallest class
+	for (size_t i = 0; i < 4; i++) {
+		msgs[i] = pub_sub_new_msg(&listed_allocator, 0, 8, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	zassert_equal(class_num_used(&listed_allocator, 0), 4);
+
+	// Further small msgs fall back to the larger classes until all are empty
+	for (size_t i = 4; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i] = pub_sub_new_msg(&listed_allocator, 0, 8, K_NO_WAIT);
+		zassert_not_null(msgs[i], "allocation attempt: %u", i);
+	}
+	zassert_equal(class_num_used(&listed_allocator, 1), 2);
+	zassert_equal(class_num_used(&listed_allocator, 2), 1);
+	zassert_is_null(pub_sub_new_msg(&listed_allocator, 0, 8, K_NO_WAIT));
+	// A msg that only fits the largest class can not fall back
+	zassert_is_null(pub_sub_new_msg(&listed_allocator, 0, 128, K_NO_WAIT));
+
+	zassert_ok(pub_sub_size_class_allocator_stats(&listed_allocator, 0, &stats));
+	zassert_equal(stats.num_fallbacks, 3);
+	zassert_equal(stats.num_failures, 1);
+	zassert_ok(pub_sub_size_class_allocator_stats(&listed_allocator, 2, &stats));
+	zassert_equal(stats.num_fallbacks, 0);
+	zassert_equal(stats.num_failures, 1);
+
+	// Once a small class block is freed it is used again before the larger classes
+	pub_sub_release_msg(msgs[0]);
+	msgs[0] = pub_sub_new_msg(&listed_allocator, 0, 8, K_NO_WAIT);
+	zassert_not_null(msgs[0]);
+	zassert_equal(class_num_used(&listed_allocator, 0), 4);
+
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST(size_class, test_no_fallback)
+{
+	struct pub_sub_size_class_stats stats;
+	void *msgs[2];
+
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(&pow2_allocator, 0, 8, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	// The smallest class is empty and the larger classes are not used
+	zassert_is_null(pub_sub_new_msg(&pow2_allocator, 0, 8, K_NO_WAIT));
+	zassert_equal(class_num_used(&pow2_allocator, 1), 0);
+	zassert_equal(class_num_used(&pow2_allocator, 2), 0);
+	zassert_ok(pub_sub_size_class_allocator_stats(&pow2_allocator, 0, &stats));
+	zassert_equal(stats.num_fallbacks, 0);
+	zassert_equal(stats.num_failures, 1);
+
+	// A larger msg is still allocated from its own class
+	void *msg = pub_sub_new_msg(&pow2_allocator, 0, 9, K_NO_WAIT);
+	zassert_not_null(msg);
+	zassert_equal(class_num_used(&pow2_allocator, 1), 1);
+
+	pub_sub_release_msg(msg);
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST(size_class, test_pow2_classes)
+{
+	struct pub_sub_size_class_stats stats;
+
+	zassert_equal(pub_sub_size_class_allocator_num_classes(&pow2_allocator), 3);
+	for (uint8_t i = 0; i < 3; i++) {
+		zassert_ok(pub_sub_size_class_allocator_stats(&pow2_allocator, i, &stats));
+		zassert_true(stats.msg_size >= (8 << i), "class: %u, msg size: %u", i,
+			     stats.msg_size);
+		zassert_equal(stats.num_msgs, 2);
+		zassert_equal(stats.num_used, 0);
+	}
+	zassert_equal(pub_sub_size_class_allocator_stats(&pow2_allocator, 3, &stats), -EINVAL);
+}
+
+ZTEST(size_class, test_runtime_allocator)
+{
+	void *msgs[4];
+
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(&runtime_allocator, 0, 8, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+		uint8_t alloc_id = pub_sub_msg_get_alloc_id(msgs[i]);
+		zassert_equal(alloc_id, PUB_SUB_ALLOC_ID_RUNTIME_OFFSET, "alloc_id: %u", alloc_id);
+	}
+	zassert_is_null(pub_sub_new_msg(&runtime_allocator, 0, 8, K_NO_WAIT));
+	zassert_equal(class_num_used(&runtime_allocator, 0), 2);
+	zassert_equal(class_num_used(&runtime_allocator, 1), 2);
+
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST_SUITE(size_class, NULL, size_class_suite_setup, NULL, size_class_after_test, NULL);
\ No newline at end of file
@@ -0,0 +1,185 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/msg_alloc.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <pub_sub/msg_alloc_stats.h>
+#include <zephyr/ztest.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define NUM_MSGS 4
+#define MSG_SIZE 8
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_allocator_0, MSG_SIZE, NUM_MSGS);
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(static_allocator_1, MSG_SIZE, NUM_MSGS);
+
+struct alloc_stats_fixture {
+	struct pub_sub_allocator *runtime_allocator;
+};
+
+struct foreach_result {
+	const struct pub_sub_allocator *allocators[4];
+	size_t num_allocators;
+};
+
+static void record_allocator(const struct pub_sub_allocator *allocator, void *user_data)
+{
+	struct foreach_result *result = user_data;
+	if (result->num_allocators < ARRAY_SIZE(result->allocators)) {
+		result->allocators[result->num_allocators] = allocator;
+	}
+	result->num_allocators++;
+}
+
+static void check_and_reset_stats(const struct pub_sub_allocator *allocator, void *user_data)
+{
+	ARG_UNUSED(user_data);
+	struct pub_sub_allocator_stats stats;
+	pub_sub_allocator_stats_get(allocator, &stats);
+	// Check all of the msgs were released to see if we have any leaks
+	zassert_equal(stats.in_use, 0);
+	pub_sub_allocator_stats_reset(allocator);
+}
+
+static void *alloc_stats_suite_setup(void)
+{
+	struct alloc_stats_fixture *test_fixture = malloc(sizeof(struct alloc_stats_fixture));
+	test_fixture->runtime_allocator = malloc_mem_slab_allocator(MSG_SIZE, NUM_MSGS);
+	pub_sub_add_runtime_allocator(test_fixture->runtime_allocator);
+	return test_fixture;
+}
+
+static void alloc_stats_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	pub_sub_allocator_stats_foreach(check_and_reset_stats, NULL);
+}
+
+static void alloc_stats_suite_teardown(void *fixture)
+{
+	struct alloc_stats_fixture *test_fixture = fixture;
+	free_mem_slab_allocator(test_fixture->runtime_allocator);
+	free(test_fixture);
+}
+
+ZTEST_F(alloc_stats, test_in_use_and_peak)
+{
+	struct pub_sub_allocator *allocators[] = {&static_allocator_0, &static_allocator_1,
+						  fixture->runtime_allocator};
+	struct pub_sub_allocator_stats stats;
+	void *msgs[NUM_MSGS];
+
+	ARRAY_FOR_EACH(allocators, i) {
+		struct pub_sub_allocator *allocator = allocators[i];
+		ARRAY_FOR_EACH(msgs, j) {
+			msgs[j] = pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT);
+			zassert_not_null(msgs[j]);
+		}
+		zassert_is_null(pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT));
+		pub_sub_allocator_stats_get(allocator, &stats);
+		zassert_equal(stats.in_use, NUM_MSGS, "allocator: %u", i);
+		zassert_equal(stats.peak_in_use, NUM_MSGS, "allocator: %u", i);
+		zassert_equal(stats.allocations, NUM_MSGS, "allocator: %u", i);
+		zassert_equal(stats.failures, 1, "allocator: %u", i);
+		zassert_equal(stats.blocked_ns, 0, "allocator: %u", i);
+
+		// Only the final release of a msg frees it
+		pub_sub_msg_inc_ref_cnt(msgs[0]);
+		ARRAY_FOR_EACH(msgs, j) {
+			pub_sub_release_msg(msgs[j]);
+		}
+		pub_sub_allocator_stats_get(allocator, &stats);
+		zassert_equal(stats.in_use, 1, "allocator: %u", i);
+		zassert_equal(stats.peak_in_use, NUM_MSGS, "allocator: %u", i);
+		pub_sub_release_msg(msgs[0]);
+
+		// Resetting keeps the msgs in use as the new peak
+		msgs[0] = pub_sub_new_msg(allocator, 0, MSG_SIZE, K_NO_WAIT);
+		pub_sub_allocator_stats_reset(allocator);
+		pub_sub_allocator_stats_get(allocator, &stats);
+		zassert_equal(stats.in_use, 1, "allocator: %u", i);
+		zassert_equal(stats.peak_in_use, 1, "allocator: %u", i);
+		zassert_equal(stats.allocations, 0, "allocator: %u", i);
+		zassert_equal(stats.failures, 0, "allocator: %u", i);
+		pub_sub_release_msg(msgs[0]);
+	}
+
+	// The allocators' stats are independent
+	pub_sub_allocator_stats_get(&static_allocator_0, &stats);
+	zassert_equal(stats.in_use, 0);
+}
+
+ZTEST_F(alloc_stats, test_live_msgs_per_msg_id)
+{
+	const uint16_t msg_ids[NUM_MSGS] = {1, 1, 5, 100};
+	void *msgs[NUM_MSGS];
+
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(fixture->runtime_allocator, msg_ids[i], MSG_SIZE,
+					  K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 0), 0);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 1), 2);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 5), 1);
+	// Msg ids above the maximum are counted together
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 8), 1);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 100), 1);
+	// Other allocators are not affected
+	zassert_equal(pub_sub_allocator_stats_live_msgs(&static_allocator_0, 1), 0);
+
+	pub_sub_release_msg(msgs[0]);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 1), 1);
+	pub_sub_release_msg(msgs[3]);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 100), 0);
+	pub_sub_release_msg(msgs[1]);
+	pub_sub_release_msg(msgs[2]);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 1), 0);
+	zassert_equal(pub_sub_allocator_stats_live_msgs(fixture->runtime_allocator, 5), 0);
+}
+
+ZTEST_F(alloc_stats, test_blocked_time)
+{
+	struct pub_sub_allocator_stats stats;
+	void *msgs[NUM_MSGS];
+
+	// An allocation that is allowed to wait but does not need to is not counted as blocked
+	ARRAY_FOR_EACH(msgs, i) {
+		msgs[i] = pub_sub_new_msg(&static_allocator_1, 0, MSG_SIZE, K_MSEC(10));
+		zassert_not_null(msgs[i]);
+	}
+	pub_sub_allocator_stats_get(&static_allocator_1, &stats);
+	zassert_equal(stats.blocked_ns, 0);
+	// Waiting for a msg until the timeout is counted as blocked time
+	zassert_is_null(pub_sub_new_msg(&static_allocator_1, 0, MSG_SIZE, K_MSEC(10)));
+	pub_sub_allocator_stats_get(&static_allocator_1, &stats);
+	zassert_true(stats.blocked_ns >= 5 * NSEC_PER_MSEC, "blocked ns: %" PRIu64,
+		     stats.blocked_ns);
+	zassert_equal(stats.failures, 1);
+
+	ARRAY_FOR_EACH(msgs, i) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST_F(alloc_stats, test_foreach)
+{
+	struct foreach_result result = {0};
+
+	// Every linker section allocator and then every added runtime allocator
+	pub_sub_allocator_stats_foreach(record_allocator, &result);
+	zassert_equal(result.num_allocators, 3);
+	zassert_equal_ptr(result.allocators[0], &static_allocator_0);
+	zassert_equal_ptr(result.allocators[1], &static_allocator_1);
+	zassert_equal_ptr(result.allocators[2], fixture->runtime_allocator);
+	zassert_equal(pub_sub_allocator_get_id(result.allocators[1]), 1);
+	zassert_equal_ptr(pub_sub_allocator_from_id(1), &static_allocator_1);
+	zassert_equal_ptr(pub_sub_allocator_from_id(PUB_SUB_ALLOC_ID_RUNTIME_OFFSET),
+			  fixture->runtime_allocator);
+	zassert_is_null(pub_sub_allocator_from_id(PUB_SUB_ALLOC_ID_RUNTIME_OFFSET + 1));
+}
+
+ZTEST_SUITE(alloc_stats, NULL, alloc_stats_suite_setup, NULL, alloc_stats_after_test,
+	    alloc_stats_suite_teardown);
\ No newline at end of file
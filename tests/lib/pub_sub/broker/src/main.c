@@ -0,0 +1,277 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES   8
+#define PUBLISHER_STACK_SIZE  1024
+#define NUM_ADD_REMOVE_CYCLES 20
+// More subscribers than fit on the broker heap set in prj.conf
+#define MAX_NUM_SUBSCRIBERS   64
+
+enum msg_id {
+	MSG_ID_SUBSCRIBED_ID_0,
+	MSG_ID_NOT_SUBSCRIBED_ID_0,
+	MSG_ID_MAX_PUB_ID = MSG_ID_NOT_SUBSCRIBED_ID_0,
+};
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 16);
+
+// Defined by the broker, not part of its API
+extern struct k_heap pub_sub_broker_heap;
+
+K_THREAD_STACK_DEFINE(publisher_stack, PUBLISHER_STACK_SIZE);
+static struct k_thread publisher_thread;
+static atomic_t stop_publishing;
+
+static atomic_t subscriber_removed;
+static atomic_t handler_calls;
+static atomic_t late_handler_calls;
+static int remove_ret;
+
+static void broker_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+}
+
+static void broker_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+// Routes messages from its own thread so they are routed while the test adds and removes
+// subscribers
+static void publisher_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+	while (!atomic_get(&stop_publishing)) {
+		void *msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0,
+					    TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		if (msg != NULL) {
+			pub_sub_publish_direct(msg);
+		}
+		k_yield();
+	}
+}
+
+static void slow_msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	ARG_UNUSED(msg);
+	ARG_UNUSED(user_data);
+	// Gives the test a chance to remove the subscriber while the message is being routed
+	k_sleep(K_TICKS(1));
+	if (atomic_get(&subscriber_removed)) {
+		atomic_inc(&late_handler_calls);
+	}
+	atomic_inc(&handler_calls);
+}
+
+static void removing_msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	ARG_UNUSED(msg);
+	remove_ret = pub_sub_subscriber_remove_broker(user_data);
+}
+
+ZTEST(broker, test_remove_while_routing)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	pub_sub_subscriber_set_handler_data(subscriber, slow_msg_handler, NULL);
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	atomic_set(&handler_calls, 0);
+	atomic_set(&late_handler_calls, 0);
+	atomic_set(&stop_publishing, 0);
+
+	k_thread_create(&publisher_thread, publisher_stack, PUBLISHER_STACK_SIZE, publisher_fn,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	for (int i = 0; i < NUM_ADD_REMOVE_CYCLES; i++) {
+		atomic_set(&subscriber_removed, 0);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
+		k_sleep(K_MSEC(2));
+		// Once removed the subscriber's handler must never be called again
+		zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
+		atomic_set(&subscriber_removed, 1);
+		k_sleep(K_MSEC(1));
+	}
+	atomic_set(&stop_publishing, 1);
+	zassert_ok(k_thread_join(&publisher_thread, K_FOREVER));
+
+	zassert_true(atomic_get(&handler_calls) > 0);
+	zassert_equal(atomic_get(&late_handler_calls), 0);
+	free_callback_subscriber(c_subscriber);
+}
+
+ZTEST(broker, test_remove_from_handler)
+{
+	struct pub_sub_broker *broker = &g_pub_sub_default_broker;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct callback_subscriber *c_other = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	struct pub_sub_subscriber *other = &c_other->subscriber;
+	struct rx_msg rx_msg;
+	void *msg;
+
+	// The subscriber removes itself without waiting for its own handler to return, both when
+	// routed in the publisher's context and by the broker
+	pub_sub_subscriber_set_handler_data(subscriber, removing_msg_handler, subscriber);
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	remove_ret = -1;
+	msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+			      K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_direct(msg);
+	zassert_ok(remove_ret);
+	zassert_is_null(subscriber->broker);
+	// The old subscriber arrays are freed once routing has finished
+	zassert_true(sys_slist_is_empty(&broker->reclaiming));
+	zassert_true(sys_slist_is_empty(&broker->retired));
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	remove_ret = -1;
+	msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+			      K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish(msg);
+	k_sleep(K_MSEC(1));
+	zassert_ok(remove_ret);
+	zassert_is_null(subscriber->broker);
+
+	// A subscriber removed by another subscriber's handler isn't sent the message being routed
+	pub_sub_subscriber_set_handler_data(subscriber, removing_msg_handler, other);
+	pub_sub_subscriber_set_priority(subscriber, 0);
+	pub_sub_subscriber_set_priority(other, 1);
+	pub_sub_subscribe(other, MSG_ID_SUBSCRIBED_ID_0);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	zassert_ok(pub_sub_add_subscriber(other));
+	remove_ret = -1;
+	msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+			      K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_direct(msg);
+	zassert_ok(remove_ret);
+	zassert_is_null(other->broker);
+	zassert_not_ok(k_msgq_get(&c_other->msgq, &rx_msg, K_NO_WAIT));
+
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
+	free_callback_subscriber(c_subscriber);
+	free_callback_subscriber(c_other);
+}
+
+ZTEST(broker, test_add_no_memory)
+{
+	struct callback_subscriber *c_subscribers[MAX_NUM_SUBSCRIBERS];
+	size_t num_added = 0;
+	int ret = 0;
+
+	while (num_added < ARRAY_SIZE(c_subscribers)) {
+		c_subscribers[num_added] = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+		ret = pub_sub_add_subscriber(&c_subscribers[num_added]->subscriber);
+		if (ret != 0) {
+			break;
+		}
+		num_added++;
+	}
+	zassert_equal(ret, -ENOMEM);
+
+	// The subscriber that didn't fit is not left on the broker
+	struct pub_sub_subscriber *subscriber = &c_subscribers[num_added]->subscriber;
+	zassert_is_null(subscriber->broker);
+	zassert_equal(sys_slist_len(&g_pub_sub_default_broker.subscribers), num_added);
+
+	// Removing a subscriber makes space for it
+	zassert_ok(pub_sub_subscriber_remove_broker(&c_subscribers[0]->subscriber));
+	free_callback_subscriber(c_subscribers[0]);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+}
+
+ZTEST(broker, test_remove_no_memory)
+{
+	struct callback_subscriber *c_subscribers[2];
+	void *blocks[CONFIG_PUB_SUB_BROKER_HEAP_SIZE / 8];
+	size_t num_blocks = 0;
+	struct rx_msg rx_msg;
+
+	ARRAY_FOR_EACH(c_subscribers, i) {
+		c_subscribers[i] = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+		pub_sub_subscribe(&c_subscribers[i]->subscriber, MSG_ID_SUBSCRIBED_ID_0);
+		zassert_ok(pub_sub_add_subscriber(&c_subscribers[i]->subscriber));
+	}
+	// The heap is shared by all of the brokers so another broker can use up the space
+	while (num_blocks < ARRAY_SIZE(blocks)) {
+		blocks[num_blocks] = k_heap_alloc(&pub_sub_broker_heap, 8, K_NO_WAIT);
+		if (blocks[num_blocks] == NULL) {
+			break;
+		}
+		num_blocks++;
+	}
+
+	// The subscriber stays on the broker and still receives messages
+	struct pub_sub_subscriber *subscriber = &c_subscribers[0]->subscriber;
+	zassert_equal(pub_sub_subscriber_remove_broker(subscriber), -ENOMEM);
+	zassert_equal_ptr(subscriber->broker, &g_pub_sub_default_broker);
+	void *msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+				    K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_direct(msg);
+	zassert_ok(k_msgq_get(&c_subscribers[0]->msgq, &rx_msg, K_NO_WAIT));
+	pub_sub_release_msg(rx_msg.msg);
+	zassert_ok(k_msgq_get(&c_subscribers[1]->msgq, &rx_msg, K_NO_WAIT));
+	pub_sub_release_msg(rx_msg.msg);
+
+	for (size_t i = 0; i < num_blocks; i++) {
+		k_heap_free(&pub_sub_broker_heap, blocks[i]);
+	}
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
+	zassert_is_null(subscriber->broker);
+	free_callback_subscriber(c_subscribers[0]);
+}
+
+ZTEST(broker, test_reclaim)
+{
+	struct pub_sub_broker *broker = &g_pub_sub_default_broker;
+	struct callback_subscriber *c_subscribers[4];
+	ARRAY_FOR_EACH(c_subscribers, i) {
+		c_subscribers[i] = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	}
+
+	// Replaced subscriber arrays are kept while a reader could be using them
+	uint8_t read_key = pub_sub_broker_read_lock(broker);
+	for (size_t i = 0; i < 3; i++) {
+		zassert_ok(pub_sub_add_subscriber(&c_subscribers[i]->subscriber));
+	}
+	zassert_equal(sys_slist_len(&broker->reclaiming), 1);
+	zassert_equal(sys_slist_len(&broker->retired), 1);
+	pub_sub_broker_read_unlock(broker, read_key);
+
+	// Once the reader has finished they are freed by the next change to the subscribers
+	zassert_ok(pub_sub_add_subscriber(&c_subscribers[3]->subscriber));
+	zassert_equal(sys_slist_len(&broker->reclaiming), 2);
+	zassert_true(sys_slist_is_empty(&broker->retired));
+
+	// Removing a subscriber waits for the readers and frees all of them
+	zassert_ok(pub_sub_subscriber_remove_broker(&c_subscribers[3]->subscriber));
+	free_callback_subscriber(c_subscribers[3]);
+	zassert_true(sys_slist_is_empty(&broker->reclaiming));
+	zassert_true(sys_slist_is_empty(&broker->retired));
+
+	// Arrays are reclaimed as subscribers are added and removed so the heap never runs out
+	for (int i = 0; i < 10 * MAX_NUM_SUBSCRIBERS; i++) {
+		zassert_ok(pub_sub_subscriber_remove_broker(&c_subscribers[0]->subscriber));
+		zassert_ok(pub_sub_add_subscriber(&c_subscribers[0]->subscriber));
+	}
+}
+
+ZTEST_SUITE(broker, NULL, NULL, broker_before_test, broker_after_test, NULL);
\ No newline at end of file
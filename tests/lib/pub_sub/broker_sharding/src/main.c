@@ -0,0 +1,145 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MAX_PUB_ID 7
+#define TEST_NUM_MSGS   32
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, sizeof(uint32_t), TEST_NUM_MSGS);
+
+struct rx_seq {
+	size_t num_msgs;
+	uint16_t msg_ids[TEST_NUM_MSGS];
+	uint32_t seqs[TEST_NUM_MSGS];
+};
+
+static void broker_sharding_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+}
+
+static void broker_sharding_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+static void msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	struct rx_seq *rx_seq = user_data;
+	zassert_true(rx_seq->num_msgs < TEST_NUM_MSGS);
+	rx_seq->msg_ids[rx_seq->num_msgs] = msg_id;
+	rx_seq->seqs[rx_seq->num_msgs] = *(const uint32_t *)msg;
+	rx_seq->num_msgs++;
+}
+
+static struct pub_sub_subscriber *add_test_subscriber(struct rx_seq *rx_seq)
+{
+	struct msgq_subscriber *m_subscriber =
+		malloc_msgq_subscriber(TEST_MAX_PUB_ID, TEST_NUM_MSGS);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, rx_seq);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe_range(subscriber, 0, TEST_MAX_PUB_ID);
+	return subscriber;
+}
+
+static void *new_seq_msg(uint16_t msg_id, uint32_t seq)
+{
+	uint32_t *msg = pub_sub_new_msg(&test_allocator, msg_id, sizeof(uint32_t), K_NO_WAIT);
+	zassert_not_null(msg);
+	*msg = seq;
+	return msg;
+}
+
+static void handle_all_msgs(struct pub_sub_subscriber *subscriber)
+{
+	// Needs a small delay to allow the shard threads to run
+	while (pub_sub_handle_queued_msg(subscriber, K_MSEC(1)) == 0) {
+	}
+}
+
+// Messages of the same id must be received in the order they were published
+static void check_per_id_order(const struct rx_seq *rx_seq)
+{
+	zassert_equal(rx_seq->num_msgs, TEST_NUM_MSGS);
+	for (uint16_t msg_id = 0; msg_id <= TEST_MAX_PUB_ID; msg_id++) {
+		bool first = true;
+		uint32_t last_seq = 0;
+		for (size_t i = 0; i < rx_seq->num_msgs; i++) {
+			if (rx_seq->msg_ids[i] != msg_id) {
+				continue;
+			}
+			zassert_true(first || (rx_seq->seqs[i] > last_seq));
+			first = false;
+			last_seq = rx_seq->seqs[i];
+		}
+	}
+}
+
+ZTEST(broker_sharding, test_shard_index)
+{
+	// Consecutive keys are spread across all of the shards
+	uint32_t shard_used = 0;
+	for (uint32_t key = 0; key < CONFIG_PUB_SUB_BROKER_NUM_SHARDS * 4; key++) {
+		uint8_t shard = pub_sub_broker_shard_index(key);
+		zassert_true(shard < CONFIG_PUB_SUB_BROKER_NUM_SHARDS);
+		zassert_equal(pub_sub_broker_shard_index(key), shard);
+		shard_used |= BIT(shard);
+	}
+	zassert_equal(shard_used, BIT_MASK(CONFIG_PUB_SUB_BROKER_NUM_SHARDS));
+}
+
+ZTEST(broker_sharding, test_per_id_order)
+{
+	struct rx_seq rx_seq = {};
+	struct pub_sub_subscriber *subscriber = add_test_subscriber(&rx_seq);
+
+	for (uint32_t seq = 0; seq < TEST_NUM_MSGS; seq++) {
+		pub_sub_publish(new_seq_msg(seq % (TEST_MAX_PUB_ID + 1), seq));
+	}
+	handle_all_msgs(subscriber);
+	check_per_id_order(&rx_seq);
+}
+
+ZTEST(broker_sharding, test_keyed_order)
+{
+	struct rx_seq rx_seq = {};
+	struct pub_sub_subscriber *subscriber = add_test_subscriber(&rx_seq);
+
+	// Messages published with the same key are received in order whatever their id
+	for (uint32_t seq = 0; seq < TEST_NUM_MSGS; seq++) {
+		pub_sub_publish_keyed(new_seq_msg(seq % (TEST_MAX_PUB_ID + 1), seq), 42);
+	}
+	handle_all_msgs(subscriber);
+	zassert_equal(rx_seq.num_msgs, TEST_NUM_MSGS);
+	for (size_t i = 0; i < rx_seq.num_msgs; i++) {
+		zassert_equal(rx_seq.seqs[i], i);
+	}
+}
+
+ZTEST(broker_sharding, test_publish_batch)
+{
+	struct rx_seq rx_seq = {};
+	struct pub_sub_subscriber *subscriber = add_test_subscriber(&rx_seq);
+	void *msgs[TEST_NUM_MSGS];
+
+	// A batch is split between the shards without reordering the messages of each id
+	for (uint32_t seq = 0; seq < TEST_NUM_MSGS; seq++) {
+		msgs[seq] = new_seq_msg(seq % (TEST_MAX_PUB_ID + 1), seq);
+	}
+	pub_sub_publish_batch(msgs, ARRAY_SIZE(msgs));
+	handle_all_msgs(subscriber);
+	check_per_id_order(&rx_seq);
+}
+
+ZTEST_SUITE(broker_sharding, NULL, NULL, broker_sharding_before_test, broker_sharding_after_test,
+	    NULL);
\ No newline at end of file
@@ -57,7 +57,7 @@ ZTEST(delayable_msg, test_delayable_msg)
 
 	// Basic test that a subscriber receives a published delayable message
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	g_delayable_msg->test_data = 12345;
 	handler_data.data_value = 12345;
@@ -100,7 +100,7 @@ ZTEST(delayable_msg, test_delayable_abort)
 	pub_sub_delayable_msg_init(g_delayable_msg, subscriber, MSG_ID_TIMER_0);
 
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	pub_sub_delayable_msg_start(g_delayable_msg, K_MSEC(500));
 
@@ -149,7 +149,7 @@ ZTEST(delayable_msg, test_delayable_update)
 	pub_sub_delayable_msg_init(g_delayable_msg, subscriber, MSG_ID_TIMER_0);
 
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	g_delayable_msg->test_data = 234;
 	handler_data.data_value = 234;
@@ -213,7 +213,7 @@ ZTEST(delayable_msg, test_delayable_msg_handler_restart)
 
 	// Add the restart handler as the message handler
 	pub_sub_subscriber_set_handler_data(subscriber, msg_restart_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	g_delayable_msg->test_data = 12345;
 	handler_data.data_value = 12345;
@@ -0,0 +1,198 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/executor.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MAX_PUB_ID     4
+#define TEST_MSGQ_LEN       8
+#define TEST_STACK_SIZE     1024
+#define TEST_WORKER_PRIO    5
+#define TEST_NUM_MSGQ_SUBS  6
+#define TEST_NUM_FIFO_SUBS  2
+#define TEST_MSGS_PER_ID    4
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, sizeof(uint32_t), 32);
+PUB_SUB_EXECUTOR_DEFINE(test_executor, 2, TEST_STACK_SIZE);
+PUB_SUB_EXECUTOR_DEFINE(test_single_executor, 1, TEST_STACK_SIZE);
+
+struct handler_data {
+	atomic_t handled;
+	// Set while the handler is running
+	atomic_t active;
+	atomic_t overlapped;
+	uint32_t last_seq;
+	bool out_of_order;
+	// When set the handler waits for it to be given before returning
+	struct k_sem *block;
+	char name;
+};
+
+static char handled_order[8];
+static atomic_t num_handled_order;
+
+static void *executor_suite_setup(void)
+{
+	pub_sub_init_executor(&test_executor, TEST_WORKER_PRIO);
+	pub_sub_init_executor(&test_single_executor, TEST_WORKER_PRIO);
+	return NULL;
+}
+
+static void executor_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+	atomic_set(&num_handled_order, 0);
+}
+
+static void executor_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+static void msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	struct handler_data *data = user_data;
+	if (atomic_inc(&data->active) != 0) {
+		atomic_set(&data->overlapped, 1);
+	}
+	uint32_t seq = *(const uint32_t *)msg;
+	if ((atomic_get(&data->handled) != 0) && (seq <= data->last_seq)) {
+		data->out_of_order = true;
+	}
+	data->last_seq = seq;
+	atomic_val_t order = atomic_inc(&num_handled_order);
+	if (order < ARRAY_SIZE(handled_order)) {
+		handled_order[order] = data->name;
+	}
+	if (data->block != NULL) {
+		(void)k_sem_take(data->block, K_FOREVER);
+	} else {
+		// Give the other worker a chance to pick up the subscriber if it could
+		k_busy_wait(100);
+	}
+	atomic_inc(&data->handled);
+	atomic_dec(&data->active);
+}
+
+static void publish_msgs(uint16_t msg_id, size_t num_msgs)
+{
+	for (size_t i = 0; i < num_msgs; i++) {
+		uint32_t *msg =
+			pub_sub_new_msg(&test_allocator, msg_id, sizeof(uint32_t), K_NO_WAIT);
+		zassert_not_null(msg);
+		*msg = i;
+		pub_sub_publish(msg);
+	}
+}
+
+static struct pub_sub_subscriber *add_msgq_subscriber(struct pub_sub_executor *executor,
+						      struct handler_data *data, uint16_t msg_id,
+						      uint8_t priority)
+{
+	struct msgq_subscriber *m_subscriber =
+		malloc_msgq_subscriber(TEST_MAX_PUB_ID, TEST_MSGQ_LEN);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, data);
+	pub_sub_subscriber_set_priority(subscriber, priority);
+	pub_sub_executor_add_subscriber(executor, subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, msg_id);
+	return subscriber;
+}
+
+ZTEST(executor, test_shared_workers)
+{
+	struct pub_sub_subscriber *subscribers[TEST_NUM_MSGQ_SUBS + TEST_NUM_FIFO_SUBS];
+	struct handler_data data[ARRAY_SIZE(subscribers)] = {};
+
+	// Many subscribers are serviced by the executor's two workers
+	for (size_t i = 0; i < TEST_NUM_MSGQ_SUBS; i++) {
+		subscribers[i] = add_msgq_subscriber(&test_executor, &data[i], 1, 0);
+	}
+	for (size_t i = TEST_NUM_MSGQ_SUBS; i < ARRAY_SIZE(subscribers); i++) {
+		struct fifo_subscriber *f_subscriber = malloc_fifo_subscriber(TEST_MAX_PUB_ID);
+		subscribers[i] = &f_subscriber->subscriber;
+		pub_sub_subscriber_set_handler_data(subscribers[i], msg_handler, &data[i]);
+		pub_sub_executor_add_subscriber(&test_executor, subscribers[i]);
+		zassert_ok(pub_sub_add_subscriber(subscribers[i]));
+		pub_sub_subscribe(subscribers[i], 1);
+	}
+
+	publish_msgs(1, TEST_MSGS_PER_ID);
+	k_sleep(K_MSEC(20));
+	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+		zassert_equal(atomic_get(&data[i].handled), TEST_MSGS_PER_ID);
+		zassert_false(data[i].out_of_order);
+		zassert_equal(pub_sub_handle_queued_msg(subscribers[i], K_NO_WAIT), -ENOMSG);
+	}
+
+	// A removed subscriber's messages are left queued
+	pub_sub_executor_remove_subscriber(subscribers[0]);
+	publish_msgs(1, 1);
+	k_sleep(K_MSEC(5));
+	zassert_equal(atomic_get(&data[0].handled), TEST_MSGS_PER_ID);
+	zassert_ok(pub_sub_handle_queued_msg(subscribers[0], K_NO_WAIT));
+
+	for (size_t i = 1; i < ARRAY_SIZE(subscribers); i++) {
+		pub_sub_executor_remove_subscriber(subscribers[i]);
+	}
+}
+
+ZTEST(executor, test_serialized)
+{
+	struct handler_data data = {};
+	struct pub_sub_subscriber *subscriber = add_msgq_subscriber(&test_executor, &data, 1, 0);
+
+	// With two workers a subscriber's handler is still never run twice at the same time and its
+	// messages are handled in order
+	publish_msgs(1, TEST_MSGQ_LEN);
+	k_sleep(K_MSEC(20));
+	zassert_equal(atomic_get(&data.handled), TEST_MSGQ_LEN);
+	zassert_equal(atomic_get(&data.overlapped), 0);
+	zassert_false(data.out_of_order);
+
+	pub_sub_executor_remove_subscriber(subscriber);
+}
+
+ZTEST(executor, test_priority)
+{
+	struct k_sem block;
+	struct handler_data data_a = {.block = &block, .name = 'A'};
+	struct handler_data data_b = {.name = 'B'};
+	struct handler_data data_c = {.name = 'C'};
+
+	k_sem_init(&block, 0, 1);
+	struct pub_sub_executor *executor = &test_single_executor;
+	struct pub_sub_subscriber *sub_a = add_msgq_subscriber(executor, &data_a, 1, 0);
+	struct pub_sub_subscriber *sub_b = add_msgq_subscriber(executor, &data_b, 2, 10);
+	struct pub_sub_subscriber *sub_c = add_msgq_subscriber(executor, &data_c, 3, 1);
+
+	// Keep the only worker busy while the other subscribers become runnable
+	publish_msgs(1, 1);
+	k_sleep(K_MSEC(5));
+	publish_msgs(2, 1);
+	publish_msgs(3, 1);
+	k_sleep(K_MSEC(5));
+	zassert_equal(atomic_get(&num_handled_order), 1);
+
+	// The higher priority subscriber is handled first even though it became runnable last
+	k_sem_give(&block);
+	k_sleep(K_MSEC(5));
+	zassert_equal(atomic_get(&num_handled_order), 3);
+	zassert_mem_equal(handled_order, "ACB", 3);
+
+	pub_sub_executor_remove_subscriber(sub_a);
+	pub_sub_executor_remove_subscriber(sub_b);
+	pub_sub_executor_remove_subscriber(sub_c);
+}
+
+ZTEST_SUITE(executor, NULL, executor_suite_setup, executor_before_test, executor_after_test, NULL);
\ No newline at end of file
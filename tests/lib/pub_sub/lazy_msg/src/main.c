@@ -0,0 +1,158 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <pub_sub/lazy_msg.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES 8
+#define TEST_NUM_MSGS       2
+
+enum msg_id {
+	MSG_ID_LAZY,
+	MSG_ID_OTHER,
+	MSG_ID_MAX_PUB_ID = MSG_ID_OTHER,
+};
+
+struct produce_data {
+	uint32_t num_produced;
+};
+
+static void produce(uint16_t msg_id, void *msg, void *user_data);
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, TEST_NUM_MSGS);
+
+static struct produce_data produce_data;
+PUB_SUB_LAZY_MSG_DEFINE(test_lazy_msg, &test_allocator, MSG_ID_LAZY, TEST_MSG_SIZE_BYTES, produce,
+			&produce_data);
+
+static void lazy_msg_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+	produce_data.num_produced = 0;
+	pub_sub_lazy_msg_init(&test_lazy_msg, &test_allocator, MSG_ID_LAZY, TEST_MSG_SIZE_BYTES,
+			      produce, &produce_data);
+}
+
+static void lazy_msg_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+static void produce(uint16_t msg_id, void *msg, void *user_data)
+{
+	struct produce_data *data = user_data;
+	zassert_equal(msg_id, MSG_ID_LAZY);
+	data->num_produced++;
+	memset(msg, data->num_produced, TEST_MSG_SIZE_BYTES);
+}
+
+ZTEST(lazy_msg, test_not_subscribed)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	struct rx_msg rx_msg;
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_OTHER);
+
+	// Nobody is subscribed so the message is never produced
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_ok(ret);
+	// Needs a small delay to allow the worker thread to run
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_not_ok(ret);
+	zassert_equal(produce_data.num_produced, 0);
+
+	// Once dispatched the lazy message can be published again
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_ok(ret);
+	k_sleep(K_MSEC(1));
+	zassert_equal(produce_data.num_produced, 0);
+	zassert_equal(pub_sub_lazy_msg_dropped(&test_lazy_msg), 0);
+}
+
+ZTEST(lazy_msg, test_subscribed)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	struct rx_msg rx_msg;
+	uint8_t expected[TEST_MSG_SIZE_BYTES];
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_LAZY);
+
+	// A lazy message can only be queued once at a time, lock the scheduler so the broker can't
+	// dispatch it between the publishes
+	k_sched_lock();
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_ok(ret);
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_equal(ret, -EBUSY);
+	k_sched_unlock();
+
+	// Needs a small delay to allow the worker thread to run
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_ok(ret);
+	zassert_equal(rx_msg.msg_id, MSG_ID_LAZY);
+	zassert_equal(produce_data.num_produced, 1);
+	memset(expected, 1, sizeof(expected));
+	zassert_mem_equal(rx_msg.msg, expected, sizeof(expected));
+	pub_sub_release_msg(rx_msg.msg);
+
+	// Each publish produces a new message
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_ok(ret);
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_ok(ret);
+	zassert_equal(produce_data.num_produced, 2);
+	memset(expected, 2, sizeof(expected));
+	zassert_mem_equal(rx_msg.msg, expected, sizeof(expected));
+	pub_sub_release_msg(rx_msg.msg);
+
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_not_ok(ret);
+}
+
+ZTEST(lazy_msg, test_alloc_failure)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	void *msgs[TEST_NUM_MSGS];
+	struct rx_msg rx_msg;
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_LAZY);
+
+	// Use up the allocator so the message can't be produced
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i] = pub_sub_new_msg(&test_allocator, MSG_ID_OTHER, TEST_MSG_SIZE_BYTES,
+					  K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+
+	ret = pub_sub_publish_lazy(&test_lazy_msg);
+	zassert_ok(ret);
+	// Needs a small delay to allow the worker thread to run
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_not_ok(ret);
+	zassert_equal(produce_data.num_produced, 0);
+	zassert_equal(pub_sub_lazy_msg_dropped(&test_lazy_msg), 1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		pub_sub_release_msg(msgs[i]);
+	}
+}
+
+ZTEST_SUITE(lazy_msg, NULL, NULL, lazy_msg_before_test, lazy_msg_after_test, NULL);
\ No newline at end of file
@@ -0,0 +1,187 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <pub_sub/msg_ring.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES 8
+#define TEST_RING_SIZE      4
+
+enum msg_id {
+	MSG_ID_SUBSCRIBED_ID_0,
+	MSG_ID_SUBSCRIBED_ID_1,
+	MSG_ID_MAX_PUB_ID = MSG_ID_SUBSCRIBED_ID_1,
+};
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 16);
+PUB_SUB_MSG_RING_DEFINE(test_ring, TEST_RING_SIZE);
+
+static struct pub_sub_broker test_broker;
+static atomic_ptr_t broker_ring_slots[TEST_RING_SIZE];
+static struct pub_sub_msg_ring broker_ring;
+
+static void msg_ring_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	pub_sub_msg_ring_init(&test_ring, test_ring.slots, TEST_RING_SIZE);
+}
+
+static void msg_ring_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+ZTEST(msg_ring, test_put_get)
+{
+	void *msgs[TEST_RING_SIZE];
+	void *msg;
+	int ret;
+
+	// Empty ring
+	msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+	zassert_is_null(msg);
+	msg = pub_sub_msg_ring_get(&test_ring, K_MSEC(1));
+	zassert_is_null(msg);
+
+	// Messages are returned in the order they were put, wrapping around the ring
+	for (size_t j = 0; j < 3; j++) {
+		for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+			msgs[i] = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0,
+						  TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+			zassert_not_null(msgs[i]);
+			ret = pub_sub_msg_ring_put(&test_ring, msgs[i]);
+			zassert_ok(ret);
+		}
+		for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+			msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+			zassert_equal_ptr(msgs[i], msg);
+			pub_sub_release_msg(msg);
+		}
+		msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+		zassert_is_null(msg);
+	}
+	zassert_equal(0, pub_sub_msg_ring_dropped(&test_ring));
+}
+
+ZTEST(msg_ring, test_full)
+{
+	void *msgs[TEST_RING_SIZE];
+	void *msg;
+	int ret;
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i] = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0,
+					  TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+		ret = pub_sub_msg_ring_put(&test_ring, msgs[i]);
+		zassert_ok(ret);
+	}
+
+	// A full ring drops and releases the message
+	msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+			      K_NO_WAIT);
+	zassert_not_null(msg);
+	ret = pub_sub_msg_ring_put(&test_ring, msg);
+	zassert_equal(-ENOBUFS, ret);
+	zassert_equal(1, pub_sub_msg_ring_dropped(&test_ring));
+
+	// Space is available again once a message has been taken
+	msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+	zassert_equal_ptr(msgs[0], msg);
+	pub_sub_release_msg(msg);
+	msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+			      K_NO_WAIT);
+	zassert_not_null(msg);
+	ret = pub_sub_msg_ring_put(&test_ring, msg);
+	zassert_ok(ret);
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_release_msg(msg);
+	}
+}
+
+ZTEST(msg_ring, test_put_list)
+{
+	void *msgs[TEST_RING_SIZE + 2];
+	sys_slist_t list;
+	void *msg;
+
+	sys_slist_init(&list);
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i] = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0,
+					  TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+
+	// The consumer is woken once for the whole list
+	pub_sub_msg_list_append(&list, msgs[0]);
+	pub_sub_msg_list_append(&list, msgs[1]);
+	zassert_equal(2, pub_sub_msg_ring_put_list(&test_ring, &list));
+	zassert_true(sys_slist_is_empty(&list));
+	zassert_equal(1, k_sem_count_get(&test_ring.signal));
+
+	// Messages that do not fit are dropped and released
+	for (size_t i = 2; i < ARRAY_SIZE(msgs); i++) {
+		pub_sub_msg_list_append(&list, msgs[i]);
+	}
+	zassert_equal(TEST_RING_SIZE - 2, pub_sub_msg_ring_put_list(&test_ring, &list));
+	zassert_true(sys_slist_is_empty(&list));
+	zassert_equal(2, pub_sub_msg_ring_dropped(&test_ring));
+
+	for (size_t i = 0; i < TEST_RING_SIZE; i++) {
+		msg = pub_sub_msg_ring_get(&test_ring, K_NO_WAIT);
+		zassert_equal_ptr(msgs[i], msg);
+		pub_sub_release_msg(msg);
+	}
+	zassert_is_null(pub_sub_msg_ring_get(&test_ring, K_NO_WAIT));
+	zassert_equal(0, k_sem_count_get(&test_ring.signal));
+}
+
+ZTEST(msg_ring, test_broker)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	void *msgs[TEST_RING_SIZE];
+	struct rx_msg rx_msg;
+	int ret;
+
+	pub_sub_msg_ring_init(&broker_ring, broker_ring_slots, TEST_RING_SIZE);
+	pub_sub_broker_set_msg_ring(&test_broker, &broker_ring);
+	pub_sub_init_broker(&test_broker);
+	ret = pub_sub_add_subscriber_to_broker(&test_broker, subscriber);
+	zassert_ok(ret);
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i] = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0 + (i & 1),
+					  TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	pub_sub_publish_to_broker(&test_broker, msgs[0]);
+	pub_sub_publish_batch_to_broker(&test_broker, &msgs[1], ARRAY_SIZE(msgs) - 1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		ret = k_msgq_get(
+			&c_subscriber->msgq, &rx_msg,
+			K_MSEC(1)); // Needs a small delay to allow the worker thread to run
+		zassert_ok(ret);
+		zassert_equal(MSG_ID_SUBSCRIBED_ID_0 + (i & 1), rx_msg.msg_id);
+		zassert_equal_ptr(msgs[i], rx_msg.msg);
+		pub_sub_release_msg(rx_msg.msg);
+	}
+	zassert_equal(0, pub_sub_msg_ring_dropped(&broker_ring));
+
+	teardown_pub_sub_broker(&test_broker);
+}
+
+ZTEST_SUITE(msg_ring, NULL, NULL, msg_ring_before_test, msg_ring_after_test, NULL);
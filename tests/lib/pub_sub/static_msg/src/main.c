@@ -58,7 +58,7 @@ ZTEST(static_msg, test_static_msg)
 
 	// Basic test that a subscriber receives a published static message
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	g_static_msg->test_data = 12345;
@@ -95,7 +95,7 @@ ZTEST(static_msg, test_callback_msg)
 		f_subscribers[i] = malloc_fifo_subscriber(MSG_ID_MAX_PUB_ID);
 		struct pub_sub_subscriber *subscriber = &f_subscribers[i]->subscriber;
 		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	}
 
@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES 8
+
+enum msg_id {
+	MSG_ID_SUBSCRIBED_ID_0,
+	MSG_ID_MAX_PUB_ID = MSG_ID_SUBSCRIBED_ID_0,
+};
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 16);
+
+static void stats_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+	pub_sub_broker_stats_reset(&g_pub_sub_default_broker);
+}
+
+static void stats_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+static void msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	ARG_UNUSED(msg);
+	ARG_UNUSED(user_data);
+}
+
+static void publish_msgs(size_t num_msgs)
+{
+	for (size_t i = 0; i < num_msgs; i++) {
+		void *msg = pub_sub_new_msg(&test_allocator, MSG_ID_SUBSCRIBED_ID_0,
+					    TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		// Direct publishing updates the statistics before returning
+		pub_sub_publish_direct(msg);
+	}
+}
+
+ZTEST(stats, test_broker)
+{
+	struct pub_sub_broker_stats stats;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	struct rx_msg rx_msg;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	publish_msgs(3);
+	// Messages are dispatched even if there is no subscriber for them
+	pub_sub_unsubscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	publish_msgs(2);
+
+	pub_sub_broker_stats_get(&g_pub_sub_default_broker, &stats);
+	zassert_equal(5, stats.msgs_dispatched);
+	zassert_equal(0, stats.msgq_blocked_ns);
+
+	pub_sub_broker_stats_reset(&g_pub_sub_default_broker);
+	pub_sub_broker_stats_get(&g_pub_sub_default_broker, &stats);
+	zassert_equal(0, stats.msgs_dispatched);
+
+	while (k_msgq_get(&c_subscriber->msgq, &rx_msg, K_NO_WAIT) == 0) {
+		pub_sub_release_msg(rx_msg.msg);
+	}
+}
+
+ZTEST(stats, test_callback_subscriber)
+{
+	struct pub_sub_subscriber_stats stats;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, NULL);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	publish_msgs(3);
+
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(3, stats.handler_calls);
+	zassert_equal(0, stats.msgs_queued);
+
+	pub_sub_subscriber_stats_reset(subscriber);
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(0, stats.handler_calls);
+	zassert_equal(0, stats.handler_ns);
+}
+
+ZTEST(stats, test_msgq_subscriber)
+{
+	struct pub_sub_subscriber_stats stats;
+	struct msgq_subscriber *m_subscriber = malloc_msgq_subscriber(MSG_ID_MAX_PUB_ID, 4);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	int ret;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, NULL);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	publish_msgs(3);
+
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(3, stats.msgs_queued);
+	zassert_equal(3, stats.queue_peak);
+	zassert_equal(0, stats.handler_calls);
+
+	for (size_t i = 0; i < 3; i++) {
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(3, stats.handler_calls);
+	zassert_equal(3, stats.queue_peak);
+
+	pub_sub_subscriber_stats_reset(subscriber);
+	publish_msgs(1);
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(1, stats.msgs_queued);
+	zassert_equal(1, stats.queue_peak);
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_ok(ret);
+}
+
+ZTEST(stats, test_fifo_subscriber)
+{
+	struct pub_sub_subscriber_stats stats;
+	struct fifo_subscriber *f_subscriber = malloc_fifo_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &f_subscriber->subscriber;
+	int ret;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, NULL);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	publish_msgs(2);
+
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(2, stats.msgs_queued);
+	zassert_equal(2, stats.queue_depth);
+	zassert_equal(2, stats.queue_peak);
+
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_ok(ret);
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(1, stats.queue_depth);
+	zassert_equal(1, stats.handler_calls);
+
+	// The queue depth is kept when the statistics are reset
+	pub_sub_subscriber_stats_reset(subscriber);
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(0, stats.msgs_queued);
+	zassert_equal(1, stats.queue_depth);
+	zassert_equal(1, stats.queue_peak);
+
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_ok(ret);
+	pub_sub_subscriber_stats_get(subscriber, &stats);
+	zassert_equal(0, stats.queue_depth);
+}
+
+ZTEST_SUITE(stats, NULL, NULL, stats_before_test, stats_after_test, NULL);
\ No newline at end of file
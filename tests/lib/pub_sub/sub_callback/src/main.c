@@ -27,6 +27,13 @@ enum msg_id {
 
 PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 32);
 
+// Large enough that the bulk subscriptions span several bit array words
+#define TEST_BULK_MAX_PUB_ID 200
+
+PUB_SUB_SUBS_TEMPLATE_DEFINE(test_subs_template, TEST_BULK_MAX_PUB_ID) = {
+	ATOMIC_MASK(3) | ATOMIC_MASK(7),
+};
+
 static void callbacks_before_test(void *fixture)
 {
 	ARG_UNUSED(fixture);
@@ -51,7 +58,7 @@ ZTEST(callbacks, test_add_remove_subscriber)
 	int ret;
 
 	// Basic test that a subscriber receives a published message
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
@@ -66,7 +73,7 @@ ZTEST(callbacks, test_add_remove_subscriber)
 	pub_sub_release_msg(rx_msg.msg);
 
 	// Test that a removed subscriber stops receiving messages
-	pub_sub_subscriber_remove_broker(subscriber);
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -78,7 +85,7 @@ ZTEST(callbacks, test_add_remove_subscriber)
 
 	// Test that a subscriber maintains its subscriptions and can just be
 	// re-added to start receiving msgs again
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -111,7 +118,7 @@ ZTEST(callbacks, test_subscribing)
 	int ret;
 
 	// Test that subscribed msg ids are received and others are not
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_1);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_2);
@@ -173,7 +180,7 @@ ZTEST(callbacks, test_multi_subscriber)
 	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
 		c_subscribers[i] = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
 		struct pub_sub_subscriber *subscriber = &c_subscribers[i]->subscriber;
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0 + i * 2);
 	}
 
@@ -273,7 +280,7 @@ ZTEST(callbacks, test_priority)
 		pub_sub_subscriber_set_priority(subscriber, ARRAY_SIZE(c_subscribers) - i);
 		pub_sub_subscriber_set_handler_data(subscriber, priority_handler,
 						    &priority_data[i]);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	}
 
@@ -303,7 +310,7 @@ ZTEST(callbacks, test_publish_to_subscriber)
 	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
 		c_subscribers[i] = malloc_callback_subscriber(max_ids[i]);
 		struct pub_sub_subscriber *subscriber = &c_subscribers[i]->subscriber;
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, max_ids[i]);
 	}
 
@@ -354,4 +361,286 @@ ZTEST(callbacks, test_publish_to_subscriber)
 	}
 }
 
+ZTEST(callbacks, test_publish_batch)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	uint16_t pub_ids[] = {
+		MSG_ID_SUBSCRIBED_ID_0,
+		MSG_ID_SUBSCRIBED_ID_1,
+		MSG_ID_SUBSCRIBED_ID_2,
+		MSG_ID_SUBSCRIBED_ID_3,
+	};
+	void *msgs[ARRAY_SIZE(pub_ids)];
+	sys_slist_t list;
+	struct rx_msg rx_msg;
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		pub_sub_subscribe(subscriber, pub_ids[i]);
+	}
+
+	// Publish an array of messages, they should be received in array order
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		msgs[i] = pub_sub_new_msg(allocator, pub_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+	}
+	pub_sub_publish_batch(msgs, ARRAY_SIZE(msgs));
+
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		ret = k_msgq_get(
+			&c_subscriber->msgq, &rx_msg,
+			K_MSEC(1)); // Needs a small delay to allow the worker thread to run
+		zassert_ok(ret);
+		zassert_equal(pub_ids[i], rx_msg.msg_id);
+		zassert_equal_ptr(msgs[i], rx_msg.msg);
+		pub_sub_release_msg(rx_msg.msg);
+	}
+
+	// Publish a list of messages in reverse order, they should be received in list order
+	sys_slist_init(&list);
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		msgs[i] = pub_sub_new_msg(allocator, pub_ids[ARRAY_SIZE(pub_ids) - 1 - i],
+					  TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+		pub_sub_msg_list_append(&list, msgs[i]);
+	}
+	pub_sub_publish_list(&list);
+	zassert_true(sys_slist_is_empty(&list));
+
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		ret = k_msgq_get(
+			&c_subscriber->msgq, &rx_msg,
+			K_MSEC(1)); // Needs a small delay to allow the worker thread to run
+		zassert_ok(ret);
+		zassert_equal(pub_ids[ARRAY_SIZE(pub_ids) - 1 - i], rx_msg.msg_id);
+		zassert_equal_ptr(msgs[i], rx_msg.msg);
+		pub_sub_release_msg(rx_msg.msg);
+	}
+
+	// No other messages in the queue
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg,
+			 K_MSEC(1)); // Needs a small delay to allow the worker thread to run
+	zassert_not_ok(ret);
+}
+
+ZTEST(callbacks, test_publish_direct)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	struct rx_msg rx_msg;
+	void *msg;
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+
+	// The handler is called before publish returns so no delay is needed
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_direct(msg);
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_NO_WAIT);
+	zassert_ok(ret);
+	zassert_equal(MSG_ID_SUBSCRIBED_ID_0, rx_msg.msg_id);
+	zassert_equal_ptr(msg, rx_msg.msg);
+	pub_sub_release_msg(rx_msg.msg);
+
+	// Not subscribed, the message is freed without being received
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_1, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_direct(msg);
+	ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+	zassert_not_ok(ret);
+}
+
+static void check_bulk_subscriptions(struct callback_subscriber *c_subscriber,
+				     const uint16_t *msg_ids, const bool *subscribed, size_t num_ids)
+{
+	struct rx_msg rx_msg;
+	void *msg;
+	int ret;
+
+	for (size_t i = 0; i < num_ids; i++) {
+		zassert_equal(atomic_test_bit(c_subscriber->subs_bitarray, msg_ids[i]),
+			      subscribed[i]);
+		msg = pub_sub_new_msg(&test_allocator, msg_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish(msg);
+		// Needs a small delay to allow the worker thread to run
+		ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+		if (subscribed[i]) {
+			zassert_ok(ret);
+			zassert_equal(msg_ids[i], rx_msg.msg_id);
+			pub_sub_release_msg(rx_msg.msg);
+		} else {
+			zassert_not_ok(ret);
+		}
+	}
+}
+
+ZTEST(callbacks, test_bulk_subscribing)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(TEST_BULK_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	int ret;
+
+	// Templates are copied in before the subscriber is added to the broker
+	pub_sub_subscribe_from_template(subscriber, test_subs_template);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	uint16_t template_ids[] = {2, 3, 7, 8};
+	bool template_subscribed[] = {false, true, true, false};
+	check_bulk_subscriptions(c_subscriber, template_ids, template_subscribed,
+				 ARRAY_SIZE(template_ids));
+
+	// A range is inclusive of both ends
+	ret = pub_sub_subscribe_range(subscriber, 30, 170);
+	zassert_ok(ret);
+	uint16_t range_ids[] = {29, 30, 31, 63, 64, 100, 169, 170, 171};
+	bool range_subscribed[] = {false, true, true, true, true, true, true, true, false};
+	check_bulk_subscriptions(c_subscriber, range_ids, range_subscribed, ARRAY_SIZE(range_ids));
+
+	// Unsubscribing from the middle of a range leaves the rest subscribed
+	ret = pub_sub_unsubscribe_range(subscriber, 60, 100);
+	zassert_ok(ret);
+	uint16_t unsub_ids[] = {59, 60, 64, 100, 101};
+	bool unsub_subscribed[] = {true, false, false, false, true};
+	check_bulk_subscriptions(c_subscriber, unsub_ids, unsub_subscribed, ARRAY_SIZE(unsub_ids));
+
+	// Bitmaps are merged with the existing subscriptions, ignoring bits past the maximum id
+	ATOMIC_DEFINE(bitmap, TEST_BULK_MAX_PUB_ID + 1) = {};
+	atomic_set_bit(bitmap, 0);
+	atomic_set_bit(bitmap, 64);
+	atomic_set_bit(bitmap, 199);
+	atomic_set_bit(bitmap, 200);
+	ret = pub_sub_subscribe_bitmap(subscriber, bitmap, 199);
+	zassert_ok(ret);
+	uint16_t bitmap_ids[] = {0, 3, 31, 64, 65, 199, 200};
+	bool bitmap_subscribed[] = {true, true, true, true, false, true, false};
+	check_bulk_subscriptions(c_subscriber, bitmap_ids, bitmap_subscribed,
+				 ARRAY_SIZE(bitmap_ids));
+
+	// Single subscriptions and ranges can be mixed
+	ret = pub_sub_unsubscribe_range(subscriber, 0, TEST_BULK_MAX_PUB_ID);
+	zassert_ok(ret);
+	pub_sub_subscribe(subscriber, 200);
+	uint16_t cleared_ids[] = {0, 3, 31, 199, 200};
+	bool cleared_subscribed[] = {false, false, false, false, true};
+	check_bulk_subscriptions(c_subscriber, cleared_ids, cleared_subscribed,
+				 ARRAY_SIZE(cleared_ids));
+}
+
+ZTEST(callbacks, test_has_subscribers)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct callback_subscriber *c_subscribers[2] = {};
+	struct rx_msg rx_msg;
+	void *msg;
+	int ret;
+
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		c_subscribers[i] = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	}
+	struct pub_sub_subscriber *subscriber_0 = &c_subscribers[0]->subscriber;
+	struct pub_sub_subscriber *subscriber_1 = &c_subscribers[1]->subscriber;
+
+	// Subscriptions made before the subscriber is added to the broker are included
+	pub_sub_subscribe(subscriber_0, MSG_ID_SUBSCRIBED_ID_0);
+	zassert_false(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_0));
+	zassert_ok(pub_sub_add_subscriber(subscriber_0));
+	zassert_true(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_0));
+	zassert_false(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_1));
+
+	// A message id stays subscribed until the last subscriber unsubscribes
+	zassert_ok(pub_sub_add_subscriber(subscriber_1));
+	pub_sub_subscribe(subscriber_1, MSG_ID_SUBSCRIBED_ID_0);
+	pub_sub_subscribe(subscriber_1, MSG_ID_SUBSCRIBED_ID_1);
+	zassert_true(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_1));
+	pub_sub_unsubscribe(subscriber_0, MSG_ID_SUBSCRIBED_ID_0);
+	zassert_true(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_0));
+	pub_sub_unsubscribe(subscriber_1, MSG_ID_SUBSCRIBED_ID_0);
+	zassert_false(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_0));
+
+	// Removing a subscriber removes its subscriptions
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber_1));
+	zassert_false(pub_sub_has_subscribers(MSG_ID_SUBSCRIBED_ID_1));
+	free_callback_subscriber(c_subscribers[1]);
+
+	// Messages that nobody is subscribed to are released without being queued
+	pub_sub_subscribe(subscriber_0, MSG_ID_SUBSCRIBED_ID_2);
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_1, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	ret = pub_sub_publish_if_subscribed(msg);
+	zassert_equal(ret, -ENOENT);
+
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_2, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	ret = pub_sub_publish_if_subscribed(msg);
+	zassert_ok(ret);
+	// Needs a small delay to allow the worker thread to run
+	ret = k_msgq_get(&c_subscribers[0]->msgq, &rx_msg, K_MSEC(1));
+	zassert_ok(ret);
+	zassert_equal(MSG_ID_SUBSCRIBED_ID_2, rx_msg.msg_id);
+	zassert_equal_ptr(msg, rx_msg.msg);
+	pub_sub_release_msg(rx_msg.msg);
+	ret = k_msgq_get(&c_subscribers[0]->msgq, &rx_msg, K_MSEC(1));
+	zassert_not_ok(ret);
+}
+
+#ifdef CONFIG_PUB_SUB_PUBLISH_LANES
+ZTEST(callbacks, test_publish_lanes)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	enum pub_sub_publish_lane lanes[] = {
+		PUB_SUB_PUBLISH_LANE_BULK,
+		PUB_SUB_PUBLISH_LANE_BULK,
+		PUB_SUB_PUBLISH_LANE_NORMAL,
+		PUB_SUB_PUBLISH_LANE_URGENT,
+	};
+	// The messages are received in lane priority order and publish order within a lane
+	size_t rx_order[] = {3, 2, 0, 1};
+	void *msgs[ARRAY_SIZE(lanes)];
+	struct rx_msg rx_msg;
+	int ret;
+
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+
+	// Stop the broker from running until all of the messages have been published
+	k_sched_lock();
+	for (size_t i = 0; i < ARRAY_SIZE(lanes); i++) {
+		msgs[i] = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+					  K_NO_WAIT);
+		zassert_not_null(msgs[i]);
+		pub_sub_publish_prio(msgs[i], lanes[i]);
+	}
+	zassert_equal(1, pub_sub_broker_lane_depth(&g_pub_sub_default_broker,
+						   PUB_SUB_PUBLISH_LANE_URGENT));
+	zassert_equal(1, pub_sub_broker_lane_depth(&g_pub_sub_default_broker,
+						   PUB_SUB_PUBLISH_LANE_NORMAL));
+	zassert_equal(2, pub_sub_broker_lane_depth(&g_pub_sub_default_broker,
+						   PUB_SUB_PUBLISH_LANE_BULK));
+	k_sched_unlock();
+
+	for (size_t i = 0; i < ARRAY_SIZE(rx_order); i++) {
+		ret = k_msgq_get(
+			&c_subscriber->msgq, &rx_msg,
+			K_MSEC(1)); // Needs a small delay to allow the worker thread to run
+		zassert_ok(ret);
+		zassert_equal_ptr(msgs[rx_order[i]], rx_msg.msg);
+		pub_sub_release_msg(rx_msg.msg);
+	}
+
+	for (size_t i = 0; i < PUB_SUB_PUBLISH_NUM_LANES; i++) {
+		zassert_equal(0, pub_sub_broker_lane_depth(&g_pub_sub_default_broker, i));
+	}
+	zassert_equal(2, pub_sub_broker_lane_peak_depth(&g_pub_sub_default_broker,
+							PUB_SUB_PUBLISH_LANE_BULK));
+}
+#endif // CONFIG_PUB_SUB_PUBLISH_LANES
+
 ZTEST_SUITE(callbacks, NULL, NULL, callbacks_before_test, callbacks_after_test, NULL);
\ No newline at end of file
@@ -62,7 +62,7 @@ ZTEST(fifo, test_add_remove_subscriber)
 
 	// Basic test that a subscriber receives a published message
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
@@ -75,7 +75,7 @@ ZTEST(fifo, test_add_remove_subscriber)
 	zassert_ok(ret);
 
 	// Test that a removed subscriber stops receiving messages
-	pub_sub_subscriber_remove_broker(subscriber);
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -88,7 +88,7 @@ ZTEST(fifo, test_add_remove_subscriber)
 
 	// Test that a subscriber maintains its subscriptions and can just be
 	// re-added to start receiving msgs again
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -111,7 +111,7 @@ ZTEST(fifo, test_subscribing)
 
 	// Test that subscribed msg ids are received and others are not
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_1);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_2);
@@ -170,7 +170,7 @@ ZTEST(fifo, test_multi_subscriber)
 		f_subscribers[i] = malloc_fifo_subscriber(MSG_ID_MAX_PUB_ID);
 		struct pub_sub_subscriber *subscriber = &f_subscribers[i]->subscriber;
 		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0 + i * 2);
 	}
 
@@ -247,7 +247,7 @@ ZTEST(fifo, test_poll_evt)
 
 	// Add a subscriber and publish some messages to it
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	for (size_t i = 0; i < num_msgs; i++) {
@@ -306,7 +306,7 @@ ZTEST(fifo, test_priority)
 		pub_sub_subscriber_set_priority(subscriber, ARRAY_SIZE(f_subscribers) - i);
 		pub_sub_subscriber_set_handler_data(subscriber, priority_handler,
 						    &priority_data[i]);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	}
 
@@ -340,7 +340,7 @@ ZTEST(fifo, test_publish_to_subscriber)
 		f_subscribers[i] = malloc_fifo_subscriber(max_ids[i]);
 		struct pub_sub_subscriber *subscriber = &f_subscribers[i]->subscriber;
 		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, max_ids[i]);
 	}
 
@@ -385,4 +385,84 @@ ZTEST(fifo, test_publish_to_subscriber)
 	}
 }
 
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+ZTEST(fifo, test_fanout)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct fifo_subscriber *f_subscribers[4] = {};
+	struct msg_handler_data handler_data = {.msg_id = MSG_ID_SUBSCRIBED_ID_0};
+	void *msg;
+	int ret;
+
+	for (size_t i = 0; i < ARRAY_SIZE(f_subscribers); i++) {
+		f_subscribers[i] = malloc_fifo_subscriber(MSG_ID_MAX_PUB_ID);
+		struct pub_sub_subscriber *subscriber = &f_subscribers[i]->subscriber;
+		pub_sub_subscriber_set_priority(subscriber, i);
+		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
+		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	}
+
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	handler_data.msg = msg;
+	pub_sub_publish(msg);
+
+	// Every subscriber has the message queued once it has been dispatched so the lowest
+	// priority subscriber can handle it before any of the others
+	for (int i = ARRAY_SIZE(f_subscribers) - 1; i > -1; i--) {
+		// Needs a small delay to allow the worker thread to run
+		ret = pub_sub_handle_queued_msg(&f_subscribers[i]->subscriber, K_MSEC(1));
+		zassert_ok(ret);
+		ret = pub_sub_handle_queued_msg(&f_subscribers[i]->subscriber, K_NO_WAIT);
+		zassert_not_ok(ret);
+	}
+
+	// Messages published directly to a subscriber also use envelopes
+	msg = pub_sub_new_msg(allocator, MSG_ID_MAX_PUB_ID + 1, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	handler_data.msg_id = MSG_ID_MAX_PUB_ID + 1;
+	handler_data.msg = msg;
+	pub_sub_publish_to_subscriber(&f_subscribers[0]->subscriber, msg);
+	ret = pub_sub_handle_queued_msg(&f_subscribers[0]->subscriber, K_NO_WAIT);
+	zassert_ok(ret);
+}
+
+ZTEST(fifo, test_fanout_envelopes_exhausted)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct fifo_subscriber *f_subscriber = malloc_fifo_subscriber(MSG_ID_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &f_subscriber->subscriber;
+	struct msg_handler_data handler_data = {.msg_id = MSG_ID_MAX_PUB_ID + 1};
+	void *msg;
+	int ret;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
+	zassert_equal(pub_sub_subscriber_fifo_dropped(subscriber), 0);
+
+	// Every envelope is in use once the subscriber has this many messages queued
+	for (int i = 0; i < CONFIG_PUB_SUB_FIFO_FANOUT_NUM_ENVELOPES; i++) {
+		msg = pub_sub_new_msg(allocator, MSG_ID_MAX_PUB_ID + 1, TEST_MSG_SIZE_BYTES,
+				      K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish_to_subscriber(subscriber, msg);
+	}
+	zassert_equal(pub_sub_subscriber_fifo_dropped(subscriber), 0);
+
+	// The next message is dropped once the envelope wait times out
+	msg = pub_sub_new_msg(allocator, MSG_ID_MAX_PUB_ID + 1, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish_to_subscriber(subscriber, msg);
+	zassert_equal(pub_sub_subscriber_fifo_dropped(subscriber), 1);
+
+	for (int i = 0; i < CONFIG_PUB_SUB_FIFO_FANOUT_NUM_ENVELOPES; i++) {
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_not_ok(ret);
+	free_fifo_subscriber(f_subscriber);
+}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
 ZTEST_SUITE(fifo, NULL, NULL, fifo_before_test, fifo_after_test, NULL);
\ No newline at end of file
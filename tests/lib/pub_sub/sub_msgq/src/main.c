@@ -62,7 +62,7 @@ ZTEST(msg_queue, test_add_remove_subscriber)
 
 	// Basic test that a subscriber receives a published message
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
@@ -75,7 +75,7 @@ ZTEST(msg_queue, test_add_remove_subscriber)
 	zassert_ok(ret);
 
 	// Test that a removed subscriber stops receiving messages
-	pub_sub_subscriber_remove_broker(subscriber);
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -88,7 +88,7 @@ ZTEST(msg_queue, test_add_remove_subscriber)
 
 	// Test that a subscriber maintains its subscriptions and can just be
 	// re-added to start receiving msgs again
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 
 	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
 	zassert_not_null(msg);
@@ -111,7 +111,7 @@ ZTEST(msg_queue, test_subscribing)
 
 	// Test that subscribed msg ids are received and others are not
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_1);
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_2);
@@ -170,7 +170,7 @@ ZTEST(msg_queue, test_multi_subscriber)
 		m_subscribers[i] = malloc_msgq_subscriber(MSG_ID_MAX_PUB_ID, 4);
 		struct pub_sub_subscriber *subscriber = &m_subscribers[i]->subscriber;
 		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0 + i * 2);
 	}
 
@@ -245,7 +245,7 @@ ZTEST(msg_queue, test_poll_evt)
 
 	// Add a subscriber and publish some messages to it
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	for (size_t i = 0; i < num_msgs; i++) {
@@ -285,7 +285,7 @@ ZTEST(msg_queue, test_msgs_not_dropped)
 
 	// Add a subscriber and publish some messages to it
 	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-	pub_sub_add_subscriber(subscriber);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
 	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
 
 	for (size_t i = 0; i < num_msgs; i++) {
@@ -326,7 +326,7 @@ ZTEST(msg_queue, test_publish_to_subscriber)
 		m_subscribers[i] = malloc_msgq_subscriber(max_ids[i], 4);
 		struct pub_sub_subscriber *subscriber = &m_subscribers[i]->subscriber;
 		pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
-		pub_sub_add_subscriber(subscriber);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
 		pub_sub_subscribe(subscriber, max_ids[i]);
 	}
 
@@ -371,4 +371,160 @@ ZTEST(msg_queue, test_publish_to_subscriber)
 	}
 }
 
+#ifdef CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+ZTEST(msg_queue, test_overflow_policies)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct msgq_subscriber *m_subscriber = malloc_msgq_subscriber(MSG_ID_MAX_PUB_ID, 2);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	struct msg_handler_data handler_data = {};
+	uint16_t pub_ids[] = {
+		MSG_ID_SUBSCRIBED_ID_0,
+		MSG_ID_SUBSCRIBED_ID_1,
+		MSG_ID_SUBSCRIBED_ID_2,
+		MSG_ID_SUBSCRIBED_ID_3,
+	};
+	void *msg;
+	int ret;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		pub_sub_subscribe(subscriber, pub_ids[i]);
+	}
+
+	// Direct publishing queues the messages on the subscriber before returning, the new messages
+	// are dropped once the queue is full
+	pub_sub_subscriber_set_msgq_overflow_policy(subscriber, PUB_SUB_MSGQ_OVERFLOW_DROP_NEWEST, 0);
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		msg = pub_sub_new_msg(allocator, pub_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish_direct(msg);
+	}
+	zassert_equal(2, pub_sub_subscriber_msgq_dropped(subscriber));
+	for (size_t i = 0; i < 2; i++) {
+		handler_data.msg_id = pub_ids[i];
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_not_ok(ret);
+
+	// The oldest messages are dropped to make space
+	pub_sub_subscriber_set_msgq_overflow_policy(subscriber, PUB_SUB_MSGQ_OVERFLOW_DROP_OLDEST, 0);
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		msg = pub_sub_new_msg(allocator, pub_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish_direct(msg);
+	}
+	zassert_equal(4, pub_sub_subscriber_msgq_dropped(subscriber));
+	for (size_t i = 2; i < ARRAY_SIZE(pub_ids); i++) {
+		handler_data.msg_id = pub_ids[i];
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_not_ok(ret);
+
+	// Only messages above the drop level are dropped, the queue is filled first so that
+	// nothing would block
+	pub_sub_subscriber_set_msgq_overflow_policy(
+		subscriber, PUB_SUB_MSGQ_OVERFLOW_DROP_ABOVE_LEVEL, MSG_ID_SUBSCRIBED_ID_1);
+	for (size_t i = 0; i < ARRAY_SIZE(pub_ids); i++) {
+		msg = pub_sub_new_msg(allocator, pub_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish_direct(msg);
+	}
+	zassert_equal(6, pub_sub_subscriber_msgq_dropped(subscriber));
+	zassert_equal(0, pub_sub_subscriber_msgq_blocked(subscriber));
+	for (size_t i = 0; i < 2; i++) {
+		handler_data.msg_id = pub_ids[i];
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_not_ok(ret);
+}
+#endif // CONFIG_PUB_SUB_MSGQ_OVERFLOW_POLICY
+
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+// Accepts messages whose first byte matches the value pointed to by 'user_data'
+static bool first_byte_filter(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	return *(const uint8_t *)msg == *(uint8_t *)user_data;
+}
+
+ZTEST(msg_queue, test_filters)
+{
+	struct pub_sub_allocator *allocator = &test_allocator;
+	struct msgq_subscriber *m_subscriber = malloc_msgq_subscriber(MSG_ID_MAX_PUB_ID, 8);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	struct msg_handler_data handler_data = {};
+	struct pub_sub_filter all_filter;
+	struct pub_sub_filter msg_filter;
+	uint8_t all_value = 1;
+	uint8_t msg_value = 1;
+	uint8_t *msg;
+	int ret;
+
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &handler_data);
+	pub_sub_subscriber_add_filter(subscriber, &all_filter, first_byte_filter, &all_value);
+	pub_sub_subscriber_add_msg_filter(subscriber, &msg_filter, MSG_ID_SUBSCRIBED_ID_1,
+					  first_byte_filter, &msg_value);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_0);
+	pub_sub_subscribe(subscriber, MSG_ID_SUBSCRIBED_ID_1);
+
+	// Only the accepted messages are queued, the rejected ones are freed by the broker
+	uint8_t values[] = {1, 2, 1, 3};
+	for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+		msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_0, TEST_MSG_SIZE_BYTES,
+				      K_NO_WAIT);
+		zassert_not_null(msg);
+		msg[0] = values[i];
+		pub_sub_publish_direct(msg);
+	}
+	zassert_equal(2, k_msgq_num_used_get(&m_subscriber->msgq));
+	zassert_equal(2, pub_sub_filter_hits(&all_filter));
+	zassert_equal(2, pub_sub_filter_misses(&all_filter));
+	// The message id filter does not apply to other message ids
+	zassert_equal(0, pub_sub_filter_hits(&msg_filter));
+	zassert_equal(0, pub_sub_filter_misses(&msg_filter));
+	handler_data.msg_id = MSG_ID_SUBSCRIBED_ID_0;
+	for (size_t i = 0; i < 2; i++) {
+		ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+		zassert_ok(ret);
+	}
+
+	// A message must be accepted by every filter that applies to it
+	msg_value = 2;
+	for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+		msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_1, TEST_MSG_SIZE_BYTES,
+				      K_NO_WAIT);
+		zassert_not_null(msg);
+		msg[0] = values[i];
+		pub_sub_publish_direct(msg);
+	}
+	zassert_equal(0, k_msgq_num_used_get(&m_subscriber->msgq));
+	zassert_equal(4, pub_sub_filter_hits(&all_filter));
+	zassert_equal(4, pub_sub_filter_misses(&all_filter));
+	zassert_equal(0, pub_sub_filter_hits(&msg_filter));
+	zassert_equal(2, pub_sub_filter_misses(&msg_filter));
+
+	all_value = 2;
+	msg = pub_sub_new_msg(allocator, MSG_ID_SUBSCRIBED_ID_1, TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	msg[0] = 2;
+	pub_sub_publish_direct(msg);
+	zassert_equal(1, pub_sub_filter_hits(&msg_filter));
+	handler_data.msg_id = MSG_ID_SUBSCRIBED_ID_1;
+	handler_data.msg = msg;
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_ok(ret);
+	ret = pub_sub_handle_queued_msg(subscriber, K_NO_WAIT);
+	zassert_not_ok(ret);
+}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_FILTERS
+
 ZTEST_SUITE(msg_queue, NULL, NULL, msg_queue_before_test, msg_queue_after_test, NULL);
\ No newline at end of file
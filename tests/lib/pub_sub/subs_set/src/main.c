@@ -0,0 +1,432 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <pub_sub/subs_set.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES 8
+#define TEST_MAX_ENTRIES    4
+#define TEST_MAX_PUB_ID     0xFFF0
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 16);
+PUB_SUB_SUBS_SORTED_ARRAY_DEFINE(test_sorted_array, TEST_MAX_ENTRIES);
+PUB_SUB_SUBS_RANGE_LIST_DEFINE(test_range_list, TEST_MAX_ENTRIES);
+PUB_SUB_SUBS_CHUNKED_BITMAP_DEFINE(test_chunked_bitmap, TEST_MAX_ENTRIES);
+
+static atomic_t num_lookups;
+static atomic_t num_failed_lookups;
+static struct pub_sub_subs_set *lookup_subs_set;
+static struct k_timer lookup_timer;
+
+static void lookup_timer_fn(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	// Looks up an id that stays in the set while the test changes the set's other ids
+	if (!pub_sub_subs_set_contains(lookup_subs_set, 1000)) {
+		atomic_inc(&num_failed_lookups);
+	}
+	atomic_inc(&num_lookups);
+}
+
+// The number of entries in the copy of the set that lookups read
+static uint16_t num_entries(struct pub_sub_subs_set *subs_set)
+{
+	return subs_set->num_entries[atomic_get(&subs_set->published)];
+}
+
+// The index of the first entry of the copy of the set that lookups read
+static size_t published_offset(struct pub_sub_subs_set *subs_set)
+{
+	return atomic_get(&subs_set->published) * subs_set->max_entries;
+}
+
+static void *subs_set_suite_setup(void)
+{
+	k_timer_init(&lookup_timer, lookup_timer_fn, NULL);
+	return NULL;
+}
+
+static void subs_set_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+	pub_sub_subs_set_init(&test_sorted_array, PUB_SUB_SUBS_SET_SORTED_ARRAY,
+			      test_sorted_array.ids, TEST_MAX_ENTRIES);
+	pub_sub_subs_set_init(&test_range_list, PUB_SUB_SUBS_SET_RANGE_LIST,
+			      test_range_list.ranges, TEST_MAX_ENTRIES);
+	pub_sub_subs_set_init(&test_chunked_bitmap, PUB_SUB_SUBS_SET_CHUNKED_BITMAP,
+			      test_chunked_bitmap.chunks, TEST_MAX_ENTRIES);
+}
+
+static void subs_set_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+ZTEST(subs_set, test_sorted_array)
+{
+	struct pub_sub_subs_set *subs_set = &test_sorted_array;
+	uint16_t ids[TEST_MAX_ENTRIES] = {4000, 7, 65535, 300};
+
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_equal(pub_sub_subs_set_add(subs_set, ids[i]), 1);
+		zassert_equal(pub_sub_subs_set_add(subs_set, ids[i]), 0);
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_true(pub_sub_subs_set_contains(subs_set, ids[i]));
+		zassert_false(pub_sub_subs_set_contains(subs_set, ids[i] - 1));
+	}
+	// The ids are kept sorted
+	size_t offset = published_offset(subs_set);
+	for (size_t i = 1; i < num_entries(subs_set); i++) {
+		zassert_true(subs_set->ids[offset + i - 1] < subs_set->ids[offset + i]);
+	}
+
+	// Full
+	zassert_equal(pub_sub_subs_set_add(subs_set, 8), -ENOMEM);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 8));
+
+	// Removing frees an entry
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 300), 1);
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 300), 0);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 300));
+	zassert_equal(pub_sub_subs_set_add(subs_set, 8), 1);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 7));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 8));
+}
+
+ZTEST(subs_set, test_range_list)
+{
+	struct pub_sub_subs_set *subs_set = &test_range_list;
+
+	// Consecutive ids share a range, adding in any order
+	for (uint16_t msg_id = 100; msg_id < 110; msg_id += 2) {
+		zassert_equal(pub_sub_subs_set_add(subs_set, msg_id), 1);
+	}
+	zassert_equal(num_entries(subs_set), 5);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 200), -ENOMEM);
+	for (uint16_t msg_id = 101; msg_id < 109; msg_id += 2) {
+		zassert_equal(pub_sub_subs_set_add(subs_set, msg_id), 1);
+	}
+	zassert_equal(num_entries(subs_set), 1);
+	zassert_equal(subs_set->ranges[published_offset(subs_set)].first, 100);
+	zassert_equal(subs_set->ranges[published_offset(subs_set)].last, 108);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 104), 0);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 99));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 100));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 108));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 109));
+
+	// Extending at either end
+	zassert_equal(pub_sub_subs_set_add(subs_set, 99), 1);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 109), 1);
+	zassert_equal(num_entries(subs_set), 1);
+
+	// Removing from the middle splits the range
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 104), 1);
+	zassert_equal(num_entries(subs_set), 2);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 104));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 103));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 105));
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 104), 0);
+
+	// Removing from the ends shrinks the range
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 99), 1);
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 109), 1);
+	zassert_equal(num_entries(subs_set), 2);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 99));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 109));
+
+	// Splitting needs a free entry
+	zassert_equal(pub_sub_subs_set_add(subs_set, 0), 1);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 65535), 1);
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 106), -ENOMEM);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 106));
+
+	// Removing a single id range frees its entry
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 65535), 1);
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 106), 1);
+	zassert_equal(num_entries(subs_set), 4);
+}
+
+ZTEST(subs_set, test_range_list_ranges)
+{
+	struct pub_sub_subs_set *subs_set = &test_range_list;
+
+	// A range merges every range that it overlaps or is next to into one entry
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 10, 19), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 30, 39), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 50, 59), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 70, 79), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 20, 49), 1);
+	zassert_equal(num_entries(subs_set), 2);
+	zassert_equal(subs_set->ranges[published_offset(subs_set)].first, 10);
+	zassert_equal(subs_set->ranges[published_offset(subs_set)].last, 59);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 15, 45), 0);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 0, 65535), 1);
+	zassert_equal(num_entries(subs_set), 1);
+
+	// Removing a range trims the ranges that it overlaps and frees those within it
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 0, 65535), 1);
+	zassert_equal(num_entries(subs_set), 0);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 10, 19), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 30, 39), 1);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 50, 59), 1);
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 15, 54), 1);
+	zassert_equal(num_entries(subs_set), 2);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 14));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 15));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 35));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 54));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 55));
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 20, 49), 0);
+
+	// Removing from the middle of a range splits it, which needs a free entry
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 100, 199), 1);
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 120, 129), 1);
+	zassert_equal(num_entries(subs_set), 4);
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 150, 159), -ENOMEM);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 150));
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 300, 399), -ENOMEM);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 300));
+}
+
+ZTEST(subs_set, test_ranges_all_or_nothing)
+{
+	struct pub_sub_subs_set *subs_set = &test_sorted_array;
+
+	// A range that does not fit leaves the set as it was
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 10, 12), 1);
+	atomic_val_t published = atomic_get(&subs_set->published);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 11, 14), -ENOMEM);
+	zassert_equal(atomic_get(&subs_set->published), published);
+	zassert_equal(num_entries(subs_set), 3);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 13));
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 11, 13), 1);
+	zassert_equal(num_entries(subs_set), 4);
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 0, 11), 1);
+	zassert_equal(num_entries(subs_set), 2);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 12));
+
+	// Ids in chunks that do not fit are not added either
+	subs_set = &test_chunked_bitmap;
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 0, 4 * PUB_SUB_SUBS_CHUNK_NUM_IDS - 1),
+		      1);
+	zassert_equal(num_entries(subs_set), 4);
+	zassert_equal(pub_sub_subs_set_add_range(subs_set, 1000, 1100), -ENOMEM);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 1100));
+	zassert_equal(pub_sub_subs_set_remove_range(subs_set, 0, 2 * PUB_SUB_SUBS_CHUNK_NUM_IDS - 1),
+		      1);
+	zassert_equal(num_entries(subs_set), 2);
+}
+
+ZTEST(subs_set, test_chunked_bitmap)
+{
+	struct pub_sub_subs_set *subs_set = &test_chunked_bitmap;
+
+	// Ids in the same chunk share an entry
+	for (uint16_t msg_id = 0; msg_id < PUB_SUB_SUBS_CHUNK_NUM_IDS; msg_id += 3) {
+		zassert_equal(pub_sub_subs_set_add(subs_set, msg_id), 1);
+	}
+	zassert_equal(pub_sub_subs_set_add(subs_set, 3), 0);
+	zassert_equal(num_entries(subs_set), 1);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 255));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 254));
+
+	zassert_equal(pub_sub_subs_set_add(subs_set, 65535), 1);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 1000), 1);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 30000), 1);
+	zassert_equal(num_entries(subs_set), 4);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 40000), -ENOMEM);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 65535));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 1000));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 1001));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 40000));
+
+	// A chunk is freed once its last id is removed
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 1001), 0);
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 1000), 1);
+	zassert_equal(num_entries(subs_set), 3);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 40000), 1);
+	zassert_true(pub_sub_subs_set_contains(subs_set, 40000));
+	zassert_false(pub_sub_subs_set_contains(subs_set, 1000));
+}
+
+ZTEST(subs_set, test_contains_any)
+{
+	struct pub_sub_subs_set *subs_sets[] = {&test_sorted_array, &test_range_list,
+						&test_chunked_bitmap};
+
+	ARRAY_FOR_EACH(subs_sets, i) {
+		struct pub_sub_subs_set *subs_set = subs_sets[i];
+		zassert_false(pub_sub_subs_set_contains_any(subs_set, 0, 65535));
+		zassert_equal(pub_sub_subs_set_add(subs_set, 300), 1);
+		zassert_equal(pub_sub_subs_set_add(subs_set, 1000), 1);
+		zassert_true(pub_sub_subs_set_contains_any(subs_set, 0, 65535));
+		zassert_true(pub_sub_subs_set_contains_any(subs_set, 300, 300));
+		zassert_true(pub_sub_subs_set_contains_any(subs_set, 200, 500));
+		zassert_true(pub_sub_subs_set_contains_any(subs_set, 999, 1000));
+		zassert_false(pub_sub_subs_set_contains_any(subs_set, 0, 299));
+		zassert_false(pub_sub_subs_set_contains_any(subs_set, 301, 999));
+		zassert_false(pub_sub_subs_set_contains_any(subs_set, 1001, 65535));
+	}
+}
+
+ZTEST(subs_set, test_failed_modification)
+{
+	struct pub_sub_subs_set *subs_set = &test_range_list;
+
+	// A modification that fails leaves the published copy in place
+	for (uint16_t msg_id = 100; msg_id < 108; msg_id += 2) {
+		zassert_equal(pub_sub_subs_set_add(subs_set, msg_id), 1);
+	}
+	atomic_val_t published = atomic_get(&subs_set->published);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 200), -ENOMEM);
+	zassert_equal(pub_sub_subs_set_add(subs_set, 100), 0);
+	zassert_equal(atomic_get(&subs_set->published), published);
+	zassert_equal(num_entries(subs_set), 4);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 200));
+
+	// The next modification is made to a fresh copy of the published entries
+	zassert_equal(pub_sub_subs_set_remove(subs_set, 100), 1);
+	zassert_not_equal(atomic_get(&subs_set->published), published);
+	zassert_equal(num_entries(subs_set), 3);
+	zassert_false(pub_sub_subs_set_contains(subs_set, 100));
+	zassert_true(pub_sub_subs_set_contains(subs_set, 106));
+}
+
+ZTEST(subs_set, test_lookup_while_modifying)
+{
+	struct pub_sub_subs_set *subs_sets[] = {&test_sorted_array, &test_range_list,
+						&test_chunked_bitmap};
+	uint16_t msg_ids[] = {999, 1001, 5000};
+
+	// Lookups from an ISR read the published copy while the other copy is modified
+	for (size_t i = 0; i < ARRAY_SIZE(subs_sets); i++) {
+		lookup_subs_set = subs_sets[i];
+		zassert_equal(pub_sub_subs_set_add(lookup_subs_set, 1000), 1);
+		atomic_clear(&num_lookups);
+		atomic_clear(&num_failed_lookups);
+		k_timer_start(&lookup_timer, K_NO_WAIT, K_TICKS(1));
+		while (atomic_get(&num_lookups) < 20) {
+			for (size_t j = 0; j < ARRAY_SIZE(msg_ids); j++) {
+				zassert_equal(pub_sub_subs_set_add(lookup_subs_set, msg_ids[j]), 1);
+			}
+			for (size_t j = 0; j < ARRAY_SIZE(msg_ids); j++) {
+				zassert_equal(pub_sub_subs_set_remove(lookup_subs_set, msg_ids[j]),
+					      1);
+			}
+			k_busy_wait(10);
+		}
+		k_timer_stop(&lookup_timer);
+		zassert_equal(atomic_get(&num_failed_lookups), 0);
+	}
+}
+
+ZTEST(subs_set, test_subscribers)
+{
+	struct pub_sub_subs_set *subs_sets[] = {&test_sorted_array, &test_range_list,
+						&test_chunked_bitmap};
+	struct callback_subscriber *c_subscribers[ARRAY_SIZE(subs_sets)];
+	uint16_t msg_ids[] = {10, 5000, 5002, TEST_MAX_PUB_ID - 1};
+	struct rx_msg rx_msg;
+	void *msg;
+	int ret;
+
+	// Every representation subscribes to the same ids
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		c_subscribers[i] = malloc_callback_subscriber(TEST_MAX_PUB_ID);
+		struct pub_sub_subscriber *subscriber = &c_subscribers[i]->subscriber;
+		pub_sub_subscriber_set_subs_set(subscriber, subs_sets[i]);
+		zassert_ok(pub_sub_add_subscriber(subscriber));
+		for (size_t j = 0; j < ARRAY_SIZE(msg_ids); j++) {
+			ret = pub_sub_subscribe(subscriber, msg_ids[j]);
+			zassert_ok(ret);
+		}
+		// Not tracked in the unused bit array
+		zassert_false(atomic_test_bit(c_subscribers[i]->subs_bitarray, msg_ids[0]));
+	}
+
+	for (size_t j = 0; j < ARRAY_SIZE(msg_ids); j++) {
+		for (uint16_t msg_id = msg_ids[j]; msg_id <= msg_ids[j] + 1; msg_id++) {
+			msg = pub_sub_new_msg(&test_allocator, msg_id, TEST_MSG_SIZE_BYTES,
+					      K_NO_WAIT);
+			zassert_not_null(msg);
+			pub_sub_publish(msg);
+		}
+	}
+
+	// Each subscriber receives the subscribed ids and nothing else
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(msg_ids); j++) {
+			// Needs a small delay to allow the worker thread to run
+			ret = k_msgq_get(&c_subscribers[i]->msgq, &rx_msg, K_MSEC(1));
+			zassert_ok(ret);
+			zassert_equal(rx_msg.msg_id, msg_ids[j]);
+			pub_sub_release_msg(rx_msg.msg);
+		}
+		ret = k_msgq_get(&c_subscribers[i]->msgq, &rx_msg, K_MSEC(1));
+		zassert_not_ok(ret);
+	}
+
+	// Unsubscribing works the same way
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		ret = pub_sub_unsubscribe(&c_subscribers[i]->subscriber, msg_ids[0]);
+		zassert_ok(ret);
+	}
+	msg = pub_sub_new_msg(&test_allocator, msg_ids[0], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish(msg);
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		ret = k_msgq_get(&c_subscribers[i]->msgq, &rx_msg, K_MSEC(1));
+		zassert_not_ok(ret);
+	}
+}
+
+ZTEST(subs_set, test_subscribe_range)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(TEST_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	int ret;
+
+	// A range list stores a subscribed range in a single entry
+	pub_sub_subscriber_set_subs_set(subscriber, &test_range_list);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	ret = pub_sub_subscribe_range(subscriber, 1000, 1999);
+	zassert_ok(ret);
+	zassert_equal(num_entries(&test_range_list), 1);
+	zassert_true(pub_sub_subs_set_contains(&test_range_list, 1000));
+	zassert_true(pub_sub_subs_set_contains(&test_range_list, 1999));
+	zassert_false(pub_sub_subs_set_contains(&test_range_list, 2000));
+
+	ret = pub_sub_unsubscribe_range(subscriber, 1100, 1199);
+	zassert_ok(ret);
+	zassert_equal(num_entries(&test_range_list), 2);
+	zassert_false(pub_sub_subs_set_contains(&test_range_list, 1150));
+
+	// Each run of consecutive ids in a bitmap is added as one range
+	ATOMIC_DEFINE(bitmap, 64) = {};
+	atomic_set_bit(bitmap, 5);
+	atomic_set_bit(bitmap, 6);
+	atomic_set_bit(bitmap, 40);
+	ret = pub_sub_subscribe_bitmap(subscriber, bitmap, 63);
+	zassert_ok(ret);
+	zassert_equal(num_entries(&test_range_list), 4);
+	zassert_true(pub_sub_subs_set_contains(&test_range_list, 6));
+	zassert_false(pub_sub_subs_set_contains(&test_range_list, 7));
+
+	// A full set subscribes to none of the range
+	ret = pub_sub_subscribe_range(subscriber, 3000, 3000);
+	zassert_equal(ret, -ENOMEM);
+	ret = pub_sub_unsubscribe_range(subscriber, 1500, 1500);
+	zassert_equal(ret, -ENOMEM);
+}
+
+ZTEST_SUITE(subs_set, NULL, subs_set_suite_setup, subs_set_before_test, subs_set_after_test, NULL);
\ No newline at end of file
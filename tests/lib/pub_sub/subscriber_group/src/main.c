@@ -0,0 +1,254 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/subscriber_group.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MAX_PUB_ID  4
+#define TEST_MSG_ID      1
+#define TEST_MSGQ_LEN    8
+#define TEST_NUM_MEMBERS 3
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, sizeof(uint32_t), 32);
+
+// Static so that the broker teardown can still remove the group if a test fails part way through
+static struct pub_sub_subscriber_group test_group;
+static PUB_SUB_SUBS_BITARRAY_DEFINE(test_group_subs, TEST_MAX_PUB_ID);
+
+static void subscriber_group_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+}
+
+static void subscriber_group_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+static void msg_handler(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg);
+	atomic_t *handled = user_data;
+	zassert_equal(msg_id, TEST_MSG_ID);
+	atomic_inc(handled);
+}
+
+static uint32_t msg_key(uint16_t msg_id, const void *msg, void *user_data)
+{
+	ARG_UNUSED(msg_id);
+	ARG_UNUSED(user_data);
+	return *(const uint32_t *)msg;
+}
+
+static void publish_msgs(uint32_t key, size_t num_msgs)
+{
+	for (size_t i = 0; i < num_msgs; i++) {
+		uint32_t *msg = pub_sub_new_msg(&test_allocator, TEST_MSG_ID, sizeof(uint32_t),
+						K_NO_WAIT);
+		zassert_not_null(msg);
+		*msg = key;
+		pub_sub_publish(msg);
+	}
+	// Allow the broker to dispatch the messages
+	k_sleep(K_MSEC(1));
+}
+
+static void init_msgq_group(struct msgq_subscriber **m_subscribers,
+			    struct pub_sub_subscriber **members, atomic_t *handled,
+			    enum pub_sub_group_policy policy)
+{
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		m_subscribers[i] = malloc_msgq_subscriber(TEST_MAX_PUB_ID, TEST_MSGQ_LEN);
+		members[i] = &m_subscribers[i]->subscriber;
+		pub_sub_subscriber_set_handler_data(members[i], msg_handler, &handled[i]);
+	}
+	pub_sub_init_subscriber_group(&test_group, test_group_subs, TEST_MAX_PUB_ID, members,
+				      TEST_NUM_MEMBERS, policy);
+}
+
+static void add_test_group(void)
+{
+	zassert_ok(pub_sub_add_subscriber(&test_group.subscriber));
+	pub_sub_subscribe(&test_group.subscriber, TEST_MSG_ID);
+}
+
+static void free_msgq_group(struct msgq_subscriber **m_subscribers)
+{
+	zassert_ok(pub_sub_subscriber_remove_broker(&test_group.subscriber));
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		free_msgq_subscriber(m_subscribers[i]);
+	}
+}
+
+static void handle_all_msgs(struct pub_sub_subscriber **members)
+{
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		while (pub_sub_handle_queued_msg(members[i], K_NO_WAIT) == 0) {
+		}
+	}
+}
+
+ZTEST(subscriber_group, test_round_robin)
+{
+	struct msgq_subscriber *m_subscribers[TEST_NUM_MEMBERS];
+	struct pub_sub_subscriber *members[TEST_NUM_MEMBERS];
+	atomic_t handled[TEST_NUM_MEMBERS] = {0};
+
+	init_msgq_group(m_subscribers, members, handled, PUB_SUB_GROUP_ROUND_ROBIN);
+	add_test_group();
+
+	// The group can't be serviced directly, its messages are queued on the members
+	zassert_equal(pub_sub_handle_queued_msg(&test_group.subscriber, K_NO_WAIT), -EPERM);
+
+	// Each message is queued on exactly one member, in turn
+	publish_msgs(0, TEST_NUM_MEMBERS * 2);
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		zassert_equal(k_msgq_num_used_get(&m_subscribers[i]->msgq), 2);
+	}
+	handle_all_msgs(members);
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		zassert_equal(atomic_get(&handled[i]), 2);
+	}
+
+	// Messages the group isn't subscribed to aren't sent to any member
+	struct pub_sub_allocator *allocator = &test_allocator;
+	void *msg = pub_sub_new_msg(allocator, TEST_MSG_ID + 1, sizeof(uint32_t), K_NO_WAIT);
+	zassert_not_null(msg);
+	pub_sub_publish(msg);
+	k_sleep(K_MSEC(1));
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		zassert_equal(k_msgq_num_used_get(&m_subscribers[i]->msgq), 0);
+	}
+
+	free_msgq_group(m_subscribers);
+}
+
+ZTEST(subscriber_group, test_least_queued)
+{
+	struct msgq_subscriber *m_subscribers[TEST_NUM_MEMBERS];
+	struct pub_sub_subscriber *members[TEST_NUM_MEMBERS];
+	atomic_t handled[TEST_NUM_MEMBERS] = {0};
+
+	init_msgq_group(m_subscribers, members, handled, PUB_SUB_GROUP_LEAST_QUEUED);
+	add_test_group();
+
+	// With nothing being handled the members' queue depths never differ by more than one
+	publish_msgs(0, TEST_NUM_MEMBERS + 1);
+	uint32_t total = 0;
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		uint32_t depth = k_msgq_num_used_get(&m_subscribers[i]->msgq);
+		zassert_true((depth == 1) || (depth == 2));
+		total += depth;
+	}
+	zassert_equal(total, TEST_NUM_MEMBERS + 1);
+
+	// A member that has emptied its queue gets the next message
+	size_t drained = 0;
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		if (k_msgq_num_used_get(&m_subscribers[i]->msgq) == 1) {
+			drained = i;
+			break;
+		}
+	}
+	zassert_ok(pub_sub_handle_queued_msg(members[drained], K_NO_WAIT));
+	publish_msgs(0, 1);
+	zassert_equal(k_msgq_num_used_get(&m_subscribers[drained]->msgq), 1);
+
+	handle_all_msgs(members);
+	total = 0;
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		total += atomic_get(&handled[i]);
+	}
+	zassert_equal(total, TEST_NUM_MEMBERS + 2);
+
+	free_msgq_group(m_subscribers);
+}
+
+ZTEST(subscriber_group, test_key_hash)
+{
+	struct msgq_subscriber *m_subscribers[TEST_NUM_MEMBERS];
+	struct pub_sub_subscriber *members[TEST_NUM_MEMBERS];
+	atomic_t handled[TEST_NUM_MEMBERS] = {0};
+
+	init_msgq_group(m_subscribers, members, handled, PUB_SUB_GROUP_KEY_HASH);
+	pub_sub_subscriber_group_set_key_fn(&test_group, msg_key, NULL);
+	add_test_group();
+
+	// Messages with the same key always go to the same member
+	publish_msgs(7, 4);
+	size_t num_used_members = 0;
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		uint32_t depth = k_msgq_num_used_get(&m_subscribers[i]->msgq);
+		zassert_true((depth == 0) || (depth == 4));
+		num_used_members += depth != 0 ? 1 : 0;
+	}
+	zassert_equal(num_used_members, 1);
+	handle_all_msgs(members);
+
+	// Different keys are spread across the members
+	for (uint32_t key = 0; key < TEST_MSGQ_LEN; key++) {
+		publish_msgs(key, 1);
+	}
+	num_used_members = 0;
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		num_used_members += k_msgq_num_used_get(&m_subscribers[i]->msgq) != 0 ? 1 : 0;
+	}
+	zassert_true(num_used_members > 1);
+	handle_all_msgs(members);
+
+	free_msgq_group(m_subscribers);
+}
+
+#ifdef CONFIG_PUB_SUB_FIFO_FANOUT
+ZTEST(subscriber_group, test_fifo_members)
+{
+	struct fifo_subscriber *f_subscribers[TEST_NUM_MEMBERS];
+	struct pub_sub_subscriber *members[TEST_NUM_MEMBERS];
+	atomic_t handled[TEST_NUM_MEMBERS] = {0};
+	struct msgq_subscriber *m_subscriber = malloc_msgq_subscriber(TEST_MAX_PUB_ID, 8);
+	struct pub_sub_subscriber *subscriber = &m_subscriber->subscriber;
+	atomic_t subscriber_handled = ATOMIC_INIT(0);
+
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		f_subscribers[i] = malloc_fifo_subscriber(TEST_MAX_PUB_ID);
+		members[i] = &f_subscribers[i]->subscriber;
+		pub_sub_subscriber_set_handler_data(members[i], msg_handler, &handled[i]);
+	}
+	pub_sub_init_subscriber_group(&test_group, test_group_subs, TEST_MAX_PUB_ID, members,
+				      TEST_NUM_MEMBERS, PUB_SUB_GROUP_LEAST_QUEUED);
+	add_test_group();
+	// A normal subscriber still receives every message
+	pub_sub_subscriber_set_handler_data(subscriber, msg_handler, &subscriber_handled);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+	pub_sub_subscribe(subscriber, TEST_MSG_ID);
+
+	publish_msgs(0, TEST_NUM_MEMBERS);
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		zassert_equal(atomic_get(&members[i]->fifo_depth), 1);
+	}
+	handle_all_msgs(members);
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		zassert_equal(atomic_get(&handled[i]), 1);
+		zassert_equal(atomic_get(&members[i]->fifo_depth), 0);
+	}
+	while (pub_sub_handle_queued_msg(subscriber, K_NO_WAIT) == 0) {
+	}
+	zassert_equal(atomic_get(&subscriber_handled), TEST_NUM_MEMBERS);
+
+	zassert_ok(pub_sub_subscriber_remove_broker(&test_group.subscriber));
+	for (size_t i = 0; i < TEST_NUM_MEMBERS; i++) {
+		free_fifo_subscriber(f_subscribers[i]);
+	}
+}
+#endif // CONFIG_PUB_SUB_FIFO_FANOUT
+
+ZTEST_SUITE(subscriber_group, NULL, NULL, subscriber_group_before_test,
+	    subscriber_group_after_test, NULL);
\ No newline at end of file
@@ -97,13 +97,23 @@ void teardown_pub_sub_broker(struct pub_sub_broker *broker)
 	// A pub_sub broker isn't really made to be torn down during normal operation
 	// so we have to look inside and do it ourselves for test teardowns
 
+#ifdef CONFIG_PUB_SUB_BROKER_THREAD
+	k_thread_abort(&broker->thread);
+#ifdef CONFIG_PUB_SUB_BROKER_SHARDING
+	for (size_t i = 0; i < ARRAY_SIZE(broker->shards); i++) {
+		k_thread_abort(&broker->shards[i].thread);
+	}
+#endif // CONFIG_PUB_SUB_BROKER_SHARDING
+#else
 	zassert_ok(k_work_poll_cancel(&broker->publish_work));
-
-	// Free all of the subscribers
-	sys_snode_t *node;
-	while ((node = sys_slist_get(&broker->subscribers)) != NULL) {
-		struct pub_sub_subscriber *subscriber =
-			CONTAINER_OF(node, struct pub_sub_subscriber, sub_list_node);
+#endif // CONFIG_PUB_SUB_BROKER_THREAD
+
+	// Free all of the subscribers, they are removed through the broker API so that any routing
+	// data the broker holds for them is freed as well
+	struct pub_sub_subscriber *subscriber;
+	while ((subscriber = SYS_SLIST_PEEK_HEAD_CONTAINER(&broker->subscribers, subscriber,
+							   sub_list_node)) != NULL) {
+		zassert_ok(pub_sub_subscriber_remove_broker(subscriber));
 		switch (subscriber->rx_type) {
 		case PUB_SUB_RX_TYPE_CALLBACK: {
 			struct callback_subscriber *c_subscriber =
@@ -117,6 +127,12 @@ void teardown_pub_sub_broker(struct pub_sub_broker *broker)
 			free_msgq_subscriber(m_subscriber);
 			break;
 		}
+#ifdef CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
+		case PUB_SUB_RX_TYPE_GROUP: {
+			// Groups and their members are owned by the tests
+			break;
+		}
+#endif // CONFIG_PUB_SUB_SUBSCRIBER_GROUPS
 		case PUB_SUB_RX_TYPE_FIFO: {
 			struct fifo_subscriber *f_subscriber =
 				CONTAINER_OF(subscriber, struct fifo_subscriber, subscriber);
@@ -0,0 +1,223 @@
+/* Copyright (c) 2024 Joshua White
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <pub_sub/pub_sub.h>
+#include <pub_sub/msg_alloc_mem_slab.h>
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <helpers.h>
+
+#define TEST_MSG_SIZE_BYTES 8
+#define TEST_MAX_PUB_ID     UINT16_MAX
+
+PUB_SUB_MEM_SLAB_ALLOCATOR_DEFINE_STATIC(test_allocator, TEST_MSG_SIZE_BYTES, 16);
+
+static void topics_before_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	reset_default_broker();
+}
+
+static void topics_after_test(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	// Check for leaked messages
+	struct k_mem_slab *mem_slab = test_allocator.impl;
+	__ASSERT(k_mem_slab_num_used_get(mem_slab) == 0, "");
+}
+
+// Publishes each message id and checks which ones the subscriber receives
+static void check_received(struct callback_subscriber *c_subscriber, const uint16_t *msg_ids,
+			   const bool *received, size_t num_ids)
+{
+	struct rx_msg rx_msg;
+	void *msg;
+	int ret;
+
+	for (size_t i = 0; i < num_ids; i++) {
+		msg = pub_sub_new_msg(&test_allocator, msg_ids[i], TEST_MSG_SIZE_BYTES, K_NO_WAIT);
+		zassert_not_null(msg);
+		pub_sub_publish(msg);
+		// Needs a small delay to allow the worker thread to run
+		ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_MSEC(1));
+		if (received[i]) {
+			zassert_ok(ret);
+			zassert_equal(msg_ids[i], rx_msg.msg_id);
+			pub_sub_release_msg(rx_msg.msg);
+			// Received exactly once
+			ret = k_msgq_get(&c_subscriber->msgq, &rx_msg, K_NO_WAIT);
+		}
+		zassert_not_ok(ret);
+	}
+}
+
+static const struct pub_sub_sub_array *get_topic_route(uint16_t msg_id)
+{
+	return atomic_ptr_get(
+		&g_pub_sub_default_broker.topic_routes[PUB_SUB_TOPIC_PREFIX(msg_id, 1)]);
+}
+
+ZTEST(topics, test_msg_id_layout)
+{
+	uint16_t msg_id = PUB_SUB_TOPIC_MSG_ID(1, 0, 3);
+	zassert_equal(msg_id, BIT(PUB_SUB_TOPIC_PREFIX_SHIFT(1)) | 3);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX(msg_id, 1), 1);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(1, 1), BIT(PUB_SUB_TOPIC_PREFIX_SHIFT(1)));
+	zassert_equal(PUB_SUB_TOPIC_PREFIX_LAST_MSG_ID(1, 1),
+		      BIT(PUB_SUB_TOPIC_PREFIX_SHIFT(1) + 1) - 1);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX(UINT16_MAX, 1), PUB_SUB_TOPIC_NUM_PREFIXES(1) - 1);
+#if CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS > 0
+	msg_id = PUB_SUB_TOPIC_MSG_ID(1, 2, 3);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX(msg_id, 1), 1);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX(msg_id, 2), BIT(CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS) + 2);
+	zassert_equal(PUB_SUB_TOPIC_PREFIX_FIRST_MSG_ID(PUB_SUB_TOPIC_PREFIX(msg_id, 2), 2),
+		      PUB_SUB_TOPIC_MSG_ID(1, 2, 0));
+#endif
+}
+
+ZTEST(topics, test_prefix_subscriptions)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(TEST_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+
+	// A level 1 prefix matches every message id in the namespace
+	pub_sub_subscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(2, 0, 0), 1);
+	uint16_t level_1_ids[] = {
+		PUB_SUB_TOPIC_MSG_ID(1, 0, 5),
+		PUB_SUB_TOPIC_MSG_ID(2, 0, 0),
+		PUB_SUB_TOPIC_MSG_ID(2, 0, 5),
+		PUB_SUB_TOPIC_PREFIX_LAST_MSG_ID(2, 1),
+		PUB_SUB_TOPIC_MSG_ID(3, 0, 0),
+	};
+	bool level_1_received[] = {false, true, true, true, false};
+	check_received(c_subscriber, level_1_ids, level_1_received, ARRAY_SIZE(level_1_ids));
+
+	// Message ids subscribed to individually are only received once
+	pub_sub_subscribe(subscriber, PUB_SUB_TOPIC_MSG_ID(2, 0, 5));
+	pub_sub_subscribe(subscriber, PUB_SUB_TOPIC_MSG_ID(0, 0, 5));
+	pub_sub_unsubscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(2, 0, 9), 1);
+	uint16_t unsub_ids[] = {
+		PUB_SUB_TOPIC_MSG_ID(0, 0, 5),
+		PUB_SUB_TOPIC_MSG_ID(2, 0, 0),
+		PUB_SUB_TOPIC_MSG_ID(2, 0, 5),
+	};
+	bool unsub_received[] = {true, false, true};
+	check_received(c_subscriber, unsub_ids, unsub_received, ARRAY_SIZE(unsub_ids));
+
+#if CONFIG_PUB_SUB_TOPIC_LEVEL_2_BITS > 0
+	// A level 2 prefix matches the message ids in the level 2 namespace
+	pub_sub_subscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(0, 3, 0), 2);
+	uint16_t level_2_ids[] = {
+		PUB_SUB_TOPIC_MSG_ID(0, 2, 1),
+		PUB_SUB_TOPIC_MSG_ID(0, 3, 0),
+		PUB_SUB_TOPIC_MSG_ID(0, 3, 1),
+		PUB_SUB_TOPIC_MSG_ID(0, 4, 0),
+	};
+	bool level_2_received[] = {false, true, true, false};
+	check_received(c_subscriber, level_2_ids, level_2_received, ARRAY_SIZE(level_2_ids));
+
+	// Both levels are tracked separately
+	pub_sub_subscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(0, 0, 0), 1);
+	pub_sub_unsubscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(0, 3, 0), 2);
+	level_2_received[0] = true;
+	level_2_received[3] = true;
+	check_received(c_subscriber, level_2_ids, level_2_received, ARRAY_SIZE(level_2_ids));
+#endif
+}
+
+ZTEST(topics, test_max_pub_msg_id)
+{
+	uint16_t max_pub_msg_id = PUB_SUB_TOPIC_MSG_ID(1, 0, 10);
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(max_pub_msg_id);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+
+	// The part of the namespace above the maximum public message id is not subscribed to
+	pub_sub_subscribe_prefix(subscriber, max_pub_msg_id, 1);
+	uint16_t msg_ids[] = {PUB_SUB_TOPIC_MSG_ID(1, 0, 0), max_pub_msg_id, max_pub_msg_id + 1};
+	bool received[] = {true, true, false};
+	check_received(c_subscriber, msg_ids, received, ARRAY_SIZE(msg_ids));
+}
+
+ZTEST(topics, test_namespace_routes)
+{
+	struct callback_subscriber *c_subscribers[3];
+	for (size_t i = 0; i < ARRAY_SIZE(c_subscribers); i++) {
+		c_subscribers[i] = malloc_callback_subscriber(TEST_MAX_PUB_ID);
+	}
+	struct pub_sub_subscriber *subscriber_0 = &c_subscribers[0]->subscriber;
+	struct pub_sub_subscriber *subscriber_1 = &c_subscribers[1]->subscriber;
+	struct pub_sub_subscriber *subscriber_2 = &c_subscribers[2]->subscriber;
+	const struct pub_sub_sub_array *route;
+
+	// Subscriptions made before the subscriber is added to the broker are included
+	pub_sub_subscribe_prefix(subscriber_0, PUB_SUB_TOPIC_MSG_ID(1, 0, 0), 1);
+	zassert_ok(pub_sub_add_subscriber(subscriber_0));
+	zassert_ok(pub_sub_add_subscriber(subscriber_1));
+	zassert_ok(pub_sub_add_subscriber(subscriber_2));
+	pub_sub_subscribe(subscriber_1, PUB_SUB_TOPIC_MSG_ID(1, 0, 7));
+	pub_sub_subscribe(subscriber_2, PUB_SUB_TOPIC_MSG_ID(5, 0, 7));
+
+	// Only the subscribers with subscriptions in a namespace are in its route
+	route = get_topic_route(PUB_SUB_TOPIC_MSG_ID(1, 0, 0));
+	zassert_not_null(route);
+	zassert_equal(route->num_subs, 2);
+	zassert_equal_ptr(route->subs[0], subscriber_0);
+	zassert_equal_ptr(route->subs[1], subscriber_1);
+	route = get_topic_route(PUB_SUB_TOPIC_MSG_ID(5, 0, 0));
+	zassert_not_null(route);
+	zassert_equal(route->num_subs, 1);
+	zassert_equal_ptr(route->subs[0], subscriber_2);
+	zassert_is_null(get_topic_route(PUB_SUB_TOPIC_MSG_ID(3, 0, 0)));
+
+	uint16_t msg_ids[] = {PUB_SUB_TOPIC_MSG_ID(1, 0, 7), PUB_SUB_TOPIC_MSG_ID(1, 0, 8)};
+	bool received_0[] = {true, true};
+	check_received(c_subscribers[0], msg_ids, received_0, ARRAY_SIZE(msg_ids));
+	bool received_1[] = {true, false};
+	check_received(c_subscribers[1], msg_ids, received_1, ARRAY_SIZE(msg_ids));
+
+	// Unsubscribing and removing subscribers removes them from the routes
+	pub_sub_unsubscribe(subscriber_2, PUB_SUB_TOPIC_MSG_ID(5, 0, 7));
+	zassert_is_null(get_topic_route(PUB_SUB_TOPIC_MSG_ID(5, 0, 0)));
+	zassert_ok(pub_sub_subscriber_remove_broker(subscriber_0));
+	route = get_topic_route(PUB_SUB_TOPIC_MSG_ID(1, 0, 0));
+	zassert_not_null(route);
+	zassert_equal(route->num_subs, 1);
+	zassert_equal_ptr(route->subs[0], subscriber_1);
+	free_callback_subscriber(c_subscribers[0]);
+}
+
+#ifdef CONFIG_PUB_SUB_SUBS_SETS
+PUB_SUB_SUBS_SORTED_ARRAY_DEFINE(test_sorted_array, 4);
+
+ZTEST(topics, test_subs_set_subscriber)
+{
+	struct callback_subscriber *c_subscriber = malloc_callback_subscriber(TEST_MAX_PUB_ID);
+	struct pub_sub_subscriber *subscriber = &c_subscriber->subscriber;
+	pub_sub_subs_set_init(&test_sorted_array, PUB_SUB_SUBS_SET_SORTED_ARRAY,
+			      test_sorted_array.ids, 4);
+	pub_sub_subscriber_set_subs_set(subscriber, &test_sorted_array);
+	zassert_ok(pub_sub_add_subscriber(subscriber));
+
+	// Prefix subscriptions work alongside a subscription set
+	pub_sub_subscribe(subscriber, PUB_SUB_TOPIC_MSG_ID(4, 0, 1));
+	pub_sub_subscribe_prefix(subscriber, PUB_SUB_TOPIC_MSG_ID(6, 0, 0), 1);
+	uint16_t msg_ids[] = {
+		PUB_SUB_TOPIC_MSG_ID(4, 0, 1),
+		PUB_SUB_TOPIC_MSG_ID(4, 0, 2),
+		PUB_SUB_TOPIC_MSG_ID(6, 0, 2),
+	};
+	bool received[] = {true, false, true};
+	check_received(c_subscriber, msg_ids, received, ARRAY_SIZE(msg_ids));
+
+	// The subscriber is only in the routes of the namespaces its set has ids in
+	const struct pub_sub_sub_array *route = get_topic_route(PUB_SUB_TOPIC_MSG_ID(4, 0, 0));
+	zassert_not_null(route);
+	zassert_equal(route->num_subs, 1);
+	zassert_equal_ptr(route->subs[0], subscriber);
+	zassert_is_null(get_topic_route(PUB_SUB_TOPIC_MSG_ID(5, 0, 0)));
+}
+#endif // CONFIG_PUB_SUB_SUBS_SETS
+
+ZTEST_SUITE(topics, NULL, NULL, topics_before_test, topics_after_test, NULL);
\ No newline at end of file